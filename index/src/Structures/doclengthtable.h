@@ -0,0 +1,38 @@
+#ifndef DOCLENGTHTABLE_H
+#define DOCLENGTHTABLE_H
+
+#include <atomic>
+
+#include "utility/chunked_array.hpp"
+
+//Term length of every document, indexed by docID
+//Written by the index writer and read by queries without any locking
+class DocLengthTable {
+public:
+    //Writer only
+    void set(unsigned int docID, int length) {
+        lengths.grow(docID).store(length + 1, std::memory_order_relaxed);
+        if(docID >= end)
+            end = docID + 1;
+    }
+
+    //Writer only. One past the highest docID with a recorded length
+    size_t size() const {
+        return end;
+    }
+
+    //Returns -1 if no length is recorded for the document
+    int get(unsigned int docID) const {
+        const std::atomic<int>* length = lengths.find(docID);
+        if(length == nullptr)
+            return -1;
+        return length->load(std::memory_order_relaxed) - 1;
+    }
+
+private:
+    //Lengths are stored plus one, so that the initial value of zero means missing
+    Utility::ChunkedArray<std::atomic<int>> lengths;
+    size_t end = 0;
+};
+
+#endif
\ No newline at end of file
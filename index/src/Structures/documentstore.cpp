@@ -1,5 +1,10 @@
 #include "documentstore.h"
 
+#include "utility/metrics.hpp"
+#include "utility/util.hpp"
+#include "static_functions/compression_functions/varbyte.hpp"
+
+#include <stdexcept>
 #include <sys/socket.h>
 #include <sys/time.h>
 
@@ -23,6 +28,78 @@ double updateAverageAdd(double avg, unsigned int toadd, unsigned int collections
     return avg + (toadd - avg) / (collectionsize+1);
 }
 
+//Starts every encoded document, so that a tuple from before documents were encoded is never parsed as one
+//A change to the format needs a new tag
+static const string EncodedTag = "encoded1 ";
+
+string encodedToString(const EncodedDocument& doc) {
+    string result = EncodedTag + to_string(doc.hash) + "\n";
+    for(size_t i = 0; i < doc.terms.size(); ++i) {
+        if(i > 0)
+            result += ' ';
+        result += doc.terms[i];
+    }
+    result += '\n';
+
+    //Same bytes as VBEncode, written directly into the string
+    result.reserve(result.size() + doc.stream.size() * 2);
+    uint8_t bytes[5];
+    for(unsigned int code : doc.stream) {
+        int count = 0;
+        bytes[count++] = (code % 128) + 128;
+        while(code >= 128) {
+            code /= 128;
+            bytes[count++] = code % 128;
+        }
+        while(count > 0)
+            result += static_cast<char>(bytes[--count]);
+    }
+    return result;
+}
+
+EncodedDocument stringToEncoded(const string& s) {
+    //Stores written by earlier builds hold the raw page
+    if(s.compare(0, EncodedTag.size(), EncodedTag) != 0)
+        return StringEncoder(EncodedDocument(), s).getNewVersion(Utility::hashString(s));
+
+    size_t hashend = s.find('\n');
+    size_t termsend = hashend == string::npos ? string::npos : s.find('\n', hashend + 1);
+    if(termsend == string::npos)
+        throw runtime_error("Error, stored document is not a complete encoded document");
+
+    EncodedDocument doc;
+    doc.hash = strtoull(s.c_str() + EncodedTag.size(), nullptr, 10);
+
+    //Terms never contain spaces, since they were split on them
+    string terms = s.substr(hashend + 1, termsend - hashend - 1);
+    doc.terms = Utility::splitString(terms, ' ');
+
+    vector<uint8_t> bytes(s.begin() + termsend + 1, s.end());
+    vector<unsigned int> stream = VBDecode(bytes);
+    doc.stream.assign(stream.begin(), stream.end());
+    //A code past the terms would be read out of bounds by the matcher
+    for(int code : doc.stream) {
+        if(code < 0 || code >= (int)doc.terms.size())
+            throw runtime_error("Error, stored document has a code without a term");
+    }
+    return doc;
+}
+
+//Parses the reply to an lrange of a url
+DocumentTuple replyToTuple(const vector<cpp_redis::reply>& response) {
+    DocumentTuple obtaineddoc(-1, EncodedDocument(), 0, "");
+    
+    if(response.size() == 5) {
+        obtaineddoc.docID = stoi(response[0].as_string());
+        obtaineddoc.doc = stringToEncoded(response[1].as_string());
+        obtaineddoc.doclength = stoi(response[2].as_string());
+        obtaineddoc.maxfragID = stoi(response[3].as_string());
+        obtaineddoc.timestamp = response[4].as_string();
+    }
+    
+    return obtaineddoc;
+}
+
 DocumentStore::DocumentStore() {
     #ifdef _WIN32
         //! Windows netword DLL init
@@ -47,6 +124,9 @@ DocumentStore::DocumentStore() {
 }
 
 DocumentTuple DocumentStore::getDocument(string url) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.docstore.get_document_ns");
+    Metrics::ScopedTimer timer(hist);
+
     vector<cpp_redis::reply> response;
     
     client.lrange(url, 0, -1, [&response](cpp_redis::reply& reply) {
@@ -56,20 +136,34 @@ DocumentTuple DocumentStore::getDocument(string url) {
     
     client.sync_commit();
     
-    DocumentTuple obtaineddoc(-1, "", 0, "");
-    
-    if(response.size() == 5) {
-        obtaineddoc.docID = stoi(response[0].as_string());
-        obtaineddoc.doc = response[1].as_string();
-        //Skip getting doclength
-        obtaineddoc.maxfragID = stoi(response[3].as_string());
-        obtaineddoc.timestamp = response[4].as_string();
+    return replyToTuple(response);
+}
+
+vector<DocumentTuple> DocumentStore::getDocuments(const vector<string>& urls) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.docstore.get_documents_ns");
+    Metrics::ScopedTimer timer(hist);
+
+    vector<vector<cpp_redis::reply>> responses(urls.size());
+    for(size_t i = 0; i < urls.size(); ++i) {
+        client.lrange(urls[i], 0, -1, [&responses, i](cpp_redis::reply& reply) {
+            if(reply.ok())
+                responses[i] = reply.as_array();
+        });
     }
-    
-    return obtaineddoc;
+
+    client.sync_commit();
+
+    vector<DocumentTuple> docs;
+    docs.reserve(urls.size());
+    for(auto& response : responses)
+        docs.push_back(replyToTuple(response));
+    return docs;
 }
 
-void DocumentStore::insertDocument(std::string url, std::string doc, int termlength, unsigned int maxfragID, string timestamp) {
+void DocumentStore::insertDocument(std::string url, const EncodedDocument& doc, int termlength, unsigned int maxfragID, string timestamp) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.docstore.insert_document_ns");
+    Metrics::ScopedTimer timer(hist);
+
     //Get nextid, olddoclen, avgdoclen, doccount
     string nextid;
     client.get("nextid", [&nextid](cpp_redis::reply& reply) {
@@ -91,7 +185,7 @@ void DocumentStore::insertDocument(std::string url, std::string doc, int termlen
 
     //document doesn't exist
     if(olddoclen < 0) {
-        vector<string> doctuple = {nextid, doc, to_string(termlength), to_string(maxfragID), timestamp};
+        vector<string> doctuple = {nextid, encodedToString(doc), to_string(termlength), to_string(maxfragID), timestamp};
         client.rpush(url, doctuple);
 
         client.select(2);
@@ -105,7 +199,7 @@ void DocumentStore::insertDocument(std::string url, std::string doc, int termlen
     else {
         //Keep only the docid
         client.ltrim(url, 0, 0);
-        vector<string> newdocinfo = {doc, to_string(termlength), to_string(maxfragID), timestamp};
+        vector<string> newdocinfo = {encodedToString(doc), to_string(termlength), to_string(maxfragID), timestamp};
         client.rpush(url, newdocinfo);
 
         avgdoclen = updateAverageRemove(avgdoclen, olddoclen, doccount);
@@ -120,6 +214,82 @@ void DocumentStore::insertDocument(std::string url, std::string doc, int termlen
     client.sync_commit();
 }
 
+void DocumentStore::insertDocuments(const vector<DocumentUpdate>& updates) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.docstore.insert_documents_ns");
+    Metrics::ScopedTimer timer(hist);
+
+    string nextid, avgdoclen, doccount;
+    client.get("nextid", [&nextid](cpp_redis::reply& reply) {
+        nextid = reply.as_string();
+    });
+    client.get("avgdoclen", [&avgdoclen](cpp_redis::reply& reply) {
+        avgdoclen = reply.as_string();
+    });
+    client.get("doccount", [&doccount](cpp_redis::reply& reply) {
+        doccount = reply.as_string();
+    });
+    client.sync_commit();
+
+    //The statistics are updated in memory, and written once at the end
+    unsigned long long docID = stoull(nextid);
+    double average = stod(avgdoclen);
+    unsigned int count = stoul(doccount);
+    int newdocs = 0;
+    for(const DocumentUpdate& update : updates) {
+        //document doesn't exist
+        if(update.olddoclength < 0) {
+            vector<string> doctuple = {to_string(docID), encodedToString(update.doc), to_string(update.termlength),
+                to_string(update.maxfragID), update.timestamp};
+            client.rpush(update.url, doctuple);
+
+            client.select(2);
+            client.set(to_string(docID), update.url);
+            client.select(0);
+
+            docID++;
+            newdocs++;
+        }
+        //document exists
+        else {
+            //Keep only the docid
+            client.ltrim(update.url, 0, 0);
+            vector<string> newdocinfo = {encodedToString(update.doc), to_string(update.termlength),
+                to_string(update.maxfragID), update.timestamp};
+            client.rpush(update.url, newdocinfo);
+
+            average = updateAverageRemove(average, update.olddoclength, count);
+            count--;
+        }
+
+        average = updateAverageAdd(average, update.termlength, count);
+        count++;
+    }
+
+    if(newdocs > 0) {
+        client.incrby("nextid", newdocs);
+        client.incrby("doccount", newdocs);
+    }
+    client.set("avgdoclen", to_string(average));
+
+    client.sync_commit();
+}
+
+void DocumentStore::setDocIDs(const vector<pair<string, unsigned int>>& docIDs) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.docstore.set_docids_ns");
+    Metrics::ScopedTimer timer(hist);
+
+    //The docID is the first field of the tuple
+    for(const auto& entry : docIDs)
+        client.lset(entry.first, 0, to_string(entry.second));
+
+    client.select(2);
+    for(const auto& entry : docIDs)
+        client.set(to_string(entry.second), entry.first);
+    client.select(0);
+
+    client.sync_commit();
+}
+
 void DocumentStore::dump() {
     //Ensure database is saved
     client.save();
@@ -127,6 +297,9 @@ void DocumentStore::dump() {
 }
 
 size_t DocumentStore::getDocumentCount() {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.docstore.get_document_count_ns");
+    Metrics::ScopedTimer timer(hist);
+
     auto result = client.get("doccount");
 
     client.sync_commit();
@@ -136,6 +309,9 @@ size_t DocumentStore::getDocumentCount() {
 }
 
 int DocumentStore::getDocLength(unsigned int docID) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.docstore.get_doc_length_ns");
+    Metrics::ScopedTimer timer(hist);
+
     //Get url from docID
     client.select(2);
     auto result = client.get(to_string(docID));
@@ -156,6 +332,9 @@ int DocumentStore::getDocLength(unsigned int docID) {
 }
 
 double DocumentStore::getAverageDocLength() {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.docstore.get_average_doc_length_ns");
+    Metrics::ScopedTimer timer(hist);
+
     auto result = client.get("avgdoclen");
     
     client.sync_commit();
@@ -165,6 +344,9 @@ double DocumentStore::getAverageDocLength() {
 }
 
 int DocumentStore::getNextDocID() {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.docstore.get_next_docid_ns");
+    Metrics::ScopedTimer timer(hist);
+
     auto result = client.get("nextid");
 
     client.sync_commit();
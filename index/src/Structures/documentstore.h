@@ -3,27 +3,59 @@
 
 #include <cpp_redis/cpp_redis>
 
+#include "doc_analyzer/Matcher/stringencoder.h"
+
 #ifdef _WIN32
 #include <Winsock2.h>
 #endif /* _WIN32 */
 
 struct DocumentTuple {
-    DocumentTuple(unsigned int id, std::string d, unsigned int f, std::string t)
-        : docID(id), doc(d), maxfragID(f), timestamp(t) {}
+    DocumentTuple(unsigned int id, EncodedDocument d, unsigned int f, std::string t)
+        : docID(id), doc(d), doclength(-1), maxfragID(f), timestamp(t) {}
     
     unsigned int docID;
-    std::string doc;
+    //The latest version, already tokenized
+    EncodedDocument doc;
+    //Length of the latest version in terms. Negative if the document is not stored
+    int doclength;
     //Refers to the next available fragID
     unsigned int maxfragID;
     std::string timestamp;
 };
 
+//A new version of a document, written by DocumentStore::insertDocuments
+struct DocumentUpdate {
+    std::string url;
+    //Length of the version being replaced. Negative for a new document
+    int olddoclength;
+    EncodedDocument doc;
+    int termlength;
+    unsigned int maxfragID;
+    std::string timestamp;
+};
+
+//Converts an encoded document to and from the string stored in its tuple
+//The string holds a format tag with the hash, the terms separated by spaces and the varbyte encoded stream,
+//separated by newlines
+std::string encodedToString(const EncodedDocument& doc);
+//A string without the format tag is the raw text of a page stored before documents were encoded, and is encoded here
+//Throws std::runtime_error if a tagged string is cut short or has codes without terms
+EncodedDocument stringToEncoded(const std::string& s);
+
 class DocumentStore {
 public:
     DocumentStore();
 
     DocumentTuple getDocument(std::string url);
-    void insertDocument(std::string url, std::string doc, int termlength, unsigned int maxfragID, std::string timestamp);
+    void insertDocument(std::string url, const EncodedDocument& doc, int termlength, unsigned int maxfragID, std::string timestamp);
+
+    //Same as the above for many documents, pipelined so that each takes a single round trip to redis
+    std::vector<DocumentTuple> getDocuments(const std::vector<std::string>& urls);
+    //New documents get consecutive docIDs starting at getNextDocID, in order. Every url must be different
+    void insertDocuments(const std::vector<DocumentUpdate>& updates);
+    //Moves each url to the docID paired with it, in a single round trip. The urls must together hold exactly the
+    //docIDs they are moved to, since the docID to url mapping of those docIDs is overwritten
+    void setDocIDs(const std::vector<std::pair<std::string, unsigned int>>& docIDs);
 
     //Document Statistics
     size_t getDocumentCount();
@@ -39,6 +71,7 @@ private:
     //{avgdoclen}
     //{doccount}
     //{url}, {docID, doc, doclength, maxfragID, timestamp}
+    //doc is the latest version as a string from encodedToString
     //db 2:
     //{docID}, {url}
     cpp_redis::client client;
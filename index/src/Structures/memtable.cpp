@@ -0,0 +1,148 @@
+#include "memtable.h"
+
+#include <algorithm>
+
+#include "global_parameters.hpp"
+
+MemPostingList::Cursor::Cursor(const MemPostingList& list, size_t sortedlength, size_t sidelength)
+    : runiter(list.sorted.begin()), runend(list.sorted.end(sortedlength)),
+    side(list.side.begin(), list.side.end(sidelength)), sideindex(0)
+{
+    //Postings of a document stay in insertion order, which keeps the original query semantics for repeated docIDs.
+    //Equal docIDs in the run were always inserted before those in the side buffer
+    std::stable_sort(side.begin(), side.end());
+    pick();
+}
+
+void MemPostingList::Cursor::pick() {
+    if(sideindex == side.size())
+        fromside = false;
+    else if(runiter == runend)
+        fromside = true;
+    else
+        fromside = side[sideindex].docID < runiter->docID;
+}
+
+bool MemPostingList::Cursor::valid() const {
+    return runiter != runend || sideindex < side.size();
+}
+
+const nPosting& MemPostingList::Cursor::get() const {
+    return fromside ? side[sideindex] : *runiter;
+}
+
+void MemPostingList::Cursor::next() {
+    if(fromside)
+        ++sideindex;
+    else
+        ++runiter;
+    pick();
+}
+
+size_t MemPostingList::Cursor::skipTo(unsigned int docID) {
+    auto before = [docID](const nPosting& posting) { return posting.docID < docID; };
+    size_t skipped = runiter.advanceWhile(before, runend);
+    if(sideindex < side.size()) {
+        size_t oldindex = sideindex;
+        sideindex = std::partition_point(side.begin() + sideindex, side.end(), before) - side.begin();
+        skipped += sideindex - oldindex;
+    }
+    pick();
+    return skipped;
+}
+
+MemPostingList::MemPostingList() : lastdocID(0) {}
+
+void MemPostingList::push_back(const nPosting& posting) {
+    if(posting.docID >= lastdocID) {
+        sorted.push_back(posting);
+        lastdocID = posting.docID;
+    }
+    else {
+        side.push_back(posting);
+    }
+}
+
+void MemPostingList::publish() {
+    sorted.publish();
+    side.publish();
+}
+
+size_t MemPostingList::sortedSize() const {
+    return sorted.size();
+}
+
+size_t MemPostingList::sideSize() const {
+    return side.size();
+}
+
+size_t MemPostingList::size() const {
+    return sortedSize() + sideSize();
+}
+
+bool MemPostingList::needsCompaction() const {
+    size_t sidesize = side.size();
+    return sidesize > MEMTABLE_SIDE_MIN && sidesize * MEMTABLE_SIDE_RATIO > sorted.size();
+}
+
+std::vector<nPosting> MemPostingList::toVector() const {
+    std::vector<nPosting> postings;
+    postings.reserve(size());
+    for(Cursor cursor(*this, sortedSize(), sideSize()); cursor.valid(); cursor.next())
+        postings.push_back(cursor.get());
+    return postings;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+NonPosMemtable::NonPosMemtable() : postingcount(0) {}
+
+void NonPosMemtable::insert(const nPosting& posting) {
+    ListMap::iterator listiter;
+
+    auto iter = lookup.find(posting.termID);
+    if(iter == lookup.end()) {
+        //Construct posting list for the term since it doesn't exist
+        listiter = lists.emplace(posting.termID, std::make_shared<PostingList>()).first;
+        lookup[posting.termID] = listiter;
+    }
+    else {
+        listiter = iter->second;
+    }
+
+    listiter->second->push_back(posting);
+    unpublished.push_back(listiter);
+    postingcount++;
+}
+
+void NonPosMemtable::publish() {
+    for(ListMap::iterator listiter : unpublished) {
+        std::shared_ptr<PostingList>& list = listiter->second;
+        list->publish();
+
+        //Copy on write: readers holding the old list keep it alive until they are done
+        if(list->needsCompaction()) {
+            auto compacted = std::make_shared<PostingList>();
+            for(const nPosting& posting : list->toVector())
+                compacted->push_back(posting);
+            compacted->publish();
+            list = compacted;
+        }
+    }
+    unpublished.clear();
+}
+
+std::shared_ptr<const NonPosMemtable::PostingList> NonPosMemtable::find(unsigned int termID) const {
+    auto iter = lookup.find(termID);
+    if(iter == lookup.end())
+        return nullptr;
+    return iter->second->second;
+}
+
+size_t NonPosMemtable::size() const {
+    return postingcount;
+}
+
+const NonPosMemtable::ListMap& NonPosMemtable::getLists() const {
+    return lists;
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef MEMTABLE_H
+#define MEMTABLE_H
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "posting.hpp"
+#include "libs/sparsepp/spp.h"
+#include "utility/append_only_list.hpp"
+
+/**
+ * Postings of a single term, kept sorted by docID as they are appended.
+ * DocIDs are mostly increasing, so postings that arrive in order are appended to a sorted run. The few that arrive
+ * out of order (updates to older documents) go to a small unsorted side buffer, which readers sort and merge with
+ * the run on the fly. Both parts are append-only, so readers can iterate them while the writer appends.
+ */
+class MemPostingList {
+public:
+    using Postings = Utility::AppendOnlyList<nPosting>;
+
+    //Reads the first sortedlength postings of the run and the first sidelength postings of the side buffer
+    //in docID order. The list must outlive the cursor
+    class Cursor {
+    public:
+        Cursor(const MemPostingList& list, size_t sortedlength, size_t sidelength);
+
+        bool valid() const;
+        //Undefined if the cursor is not valid
+        const nPosting& get() const;
+        void next();
+        //Advances to the first posting with a docID of at least docID, and returns how many postings were skipped
+        size_t skipTo(unsigned int docID);
+
+    private:
+        //Determines whether the current posting comes from the side buffer
+        void pick();
+
+        Postings::const_iterator runiter;
+        Postings::const_iterator runend;
+        std::vector<nPosting> side;
+        size_t sideindex;
+        bool fromside;
+    };
+
+    MemPostingList();
+
+    //Writer only. The posting is not visible to readers until publish is called
+    void push_back(const nPosting& posting);
+    //Writer only
+    void publish();
+
+    //Number of postings visible to readers in the sorted run and in the side buffer
+    size_t sortedSize() const;
+    size_t sideSize() const;
+    size_t size() const;
+
+    //Writer only. Whether the side buffer has grown large enough that the list should be rebuilt
+    bool needsCompaction() const;
+    //Copies every visible posting, sorted by docID
+    std::vector<nPosting> toVector() const;
+
+private:
+    Postings sorted;
+    Postings side;
+    //Largest docID in the sorted run
+    unsigned int lastdocID;
+};
+
+/**
+ * In-memory non-positional index that queries can read while the index writer keeps inserting.
+ * Postings become visible to readers when the writer publishes them, which the index does once per document.
+ * Creating the list of a new term changes the term map, so lookups must not run at the same time as inserts (the
+ * index guards both with its snapshot lock), but iterating a list that was found needs no lock.
+ * When a list has collected too many out of order postings, publish replaces it with a fully sorted copy. Readers
+ * share ownership of the lists they found, so they keep reading the old list unchanged.
+ */
+class NonPosMemtable {
+public:
+    using PostingList = MemPostingList;
+    using ListMap = std::map<unsigned int, std::shared_ptr<PostingList>>;
+
+    NonPosMemtable();
+
+    //Writer only
+    void insert(const nPosting& posting);
+    //Writer only. Makes every posting inserted so far visible to readers
+    void publish();
+
+    //Returns nullptr if the term has no postings
+    std::shared_ptr<const PostingList> find(unsigned int termID) const;
+    //Number of postings inserted
+    size_t size() const;
+
+    //Lists ordered by termID
+    const ListMap& getLists() const;
+
+private:
+    ListMap lists;
+    spp::sparse_hash_map<unsigned int, ListMap::iterator> lookup;
+    //Lists with postings that have not been published yet
+    std::vector<ListMap::iterator> unpublished;
+    size_t postingcount;
+};
+
+#endif
\ No newline at end of file
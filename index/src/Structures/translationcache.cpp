@@ -0,0 +1,55 @@
+#include "translationcache.h"
+
+using namespace std;
+
+TranslationCache::TranslationCache(size_t capacitybytes)
+    : compiled(capacitybytes, [](const shared_ptr<const CompiledTranslations>& translations) {
+        return translations->bytes();
+    }), version(0) {}
+
+shared_ptr<const CompiledTranslations> TranslationCache::get(int docID, unsigned long long& seenversion) {
+    lock_guard<mutex> guard(lock);
+    shared_ptr<const CompiledTranslations>* cached = compiled.get(docID);
+    if(cached)
+        return *cached;
+    seenversion = version;
+    return nullptr;
+}
+
+void TranslationCache::put(int docID, shared_ptr<const CompiledTranslations> translations,
+    unsigned long long seenversion) {
+    lock_guard<mutex> guard(lock);
+    if(version == seenversion)
+        compiled.put(docID, move(translations));
+}
+
+void TranslationCache::append(int docID, const vector<Translation>& translations, size_t oldlength) {
+    lock_guard<mutex> guard(lock);
+    version++;
+    shared_ptr<const CompiledTranslations>* cached = compiled.get(docID);
+    if(!cached)
+        return;
+
+    //A query that missed between the write to redis and this call already read the new translations
+    if((*cached)->size() != oldlength) {
+        compiled.erase(docID);
+        return;
+    }
+
+    //Readers holding the old map keep it unchanged
+    auto extended = make_shared<CompiledTranslations>(**cached);
+    extended->append(translations);
+    compiled.put(docID, extended);
+}
+
+void TranslationCache::erase(int docID) {
+    lock_guard<mutex> guard(lock);
+    version++;
+    compiled.erase(docID);
+}
+
+void TranslationCache::clear() {
+    lock_guard<mutex> guard(lock);
+    version++;
+    compiled.clear();
+}
@@ -0,0 +1,38 @@
+#ifndef TRANSLATIONCACHE_H
+#define TRANSLATIONCACHE_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+#include "doc_analyzer/Matcher/translate.h"
+#include "utility/lru_cache.hpp"
+
+//Compiled translations of recently used documents, kept in memory by the translation table
+//Queries fill it with translation lists they read from redis while the index writer appends to those lists, so an
+//entry is only cached or extended when it is known to hold exactly the stored list
+class TranslationCache {
+public:
+    //Entries are evicted once they take more than capacitybytes in total, see CompiledTranslations::bytes
+    TranslationCache(size_t capacitybytes);
+
+    //Returns the cached translations of the document, or nullptr. On a miss, version is set to what put needs
+    std::shared_ptr<const CompiledTranslations> get(int docID, unsigned long long& version);
+    //Caches translations read from redis after get missed with version, unless the list changed in between
+    void put(int docID, std::shared_ptr<const CompiledTranslations> translations, unsigned long long version);
+    //Must be called after translations were appended to the stored list of the document, which held oldlength
+    //translations before. A cached entry that does not hold exactly oldlength translations was read after the append
+    //and is dropped instead of being extended
+    void append(int docID, const std::vector<Translation>& translations, size_t oldlength);
+    void erase(int docID);
+    void clear();
+
+private:
+    std::mutex lock;
+    Utility::LRUCache<int, std::shared_ptr<const CompiledTranslations>> compiled;
+    //Changes on every append, erase and clear, so that a translation list read from redis before one of them is not
+    //cached after it
+    unsigned long long version;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include "translationtable.h"
 
+#include "utility/metrics.hpp"
+
 #include <sstream>
+#include <cstdlib>
 
 #include <sys/socket.h>
 #include <sys/time.h>
@@ -11,10 +14,10 @@
 
 using namespace std;
 
-string transToString(Translation& t);
+string transToString(const Translation& t);
 Translation stringToTrans(const string& s);
 
-TranslationTable::TranslationTable() {
+TranslationTable::TranslationTable() : compiled(TRANSLATION_CACHE_BYTES) {
     #ifdef _WIN32
         //! Windows netword DLL init
         WORD version = MAKEWORD(2, 2);
@@ -33,69 +36,157 @@ TranslationTable::TranslationTable() {
 }
 
 int TranslationTable::apply(int docID, size_t fragID, int position) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.transtable.apply_ns");
+    Metrics::ScopedTimer timer(hist);
+
+    //A document that was never edited has no translations, and its positions are unchanged
+    return getCompiled(docID)->apply(position, fragID);
+}
+
+vector<int> TranslationTable::applyBatch(int docID, const vector<FragmentPosition>& positions) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.transtable.apply_batch_ns");
+    Metrics::ScopedTimer timer(hist);
+
+    return getCompiled(docID)->applyBatch(positions);
+}
+
+shared_ptr<const CompiledTranslations> TranslationTable::getCompiled(int docID) {
+    static Metrics::Counter& hits = Metrics::counter("redis.transtable.compiled_hits");
+    static Metrics::Counter& misses = Metrics::counter("redis.transtable.compiled_misses");
+
+    unsigned long long seenversion;
+    shared_ptr<const CompiledTranslations> cached = compiled.get(docID, seenversion);
+    if(cached) {
+        hits.add();
+        return cached;
+    }
+    misses.add();
+
+    auto result = make_shared<const CompiledTranslations>(getTranslations(docID));
+    compiled.put(docID, result, seenversion);
+    return result;
+}
+
+vector<Translation> TranslationTable::getTranslations(int docID) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.transtable.get_ns");
+    Metrics::ScopedTimer timer(hist);
+
     vector<cpp_redis::reply> response;
-    
-    client.lrange(to_string(docID), 0, -1, [&response](cpp_redis::reply& reply) {
-        if(reply.ok())
-            response = reply.as_array();
-    });
-    
-    client.sync_commit();
-    
-    if(response.size() == 0)
-        return -1;
-    
-    int finalposition = position;
-    for(size_t i = fragID; i < response.size(); ++i) {
-        finalposition = applyTranslation(finalposition, stringToTrans(response[i].as_string()));
-        //return if position becomes invalidated
-        //cannot keep running; position might accidentally become revalidated
-        if(finalposition < 0)
-            return finalposition;
+
+    {
+        lock_guard<mutex> guard(lock);
+        client.lrange(to_string(docID), 0, -1, [&response](cpp_redis::reply& reply) {
+            if(reply.ok())
+                response = reply.as_array();
+        });
+
+        client.sync_commit();
     }
-    
-    return finalposition;
+
+    vector<Translation> translations;
+    translations.reserve(response.size());
+    for(cpp_redis::reply& reply : response)
+        translations.push_back(stringToTrans(reply.as_string()));
+    return translations;
 }
 
 void TranslationTable::insert(vector<Translation>& trans, int docID) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.transtable.insert_ns");
+    Metrics::ScopedTimer timer(hist);
+
     vector<string> val;
     for(Translation& t : trans)
         val.push_back(transToString(t));
     
-    client.rpush(to_string(docID), val);
-    client.commit();
+    //rpush replies with the length of the list after the push
+    long long length = 0;
+    {
+        lock_guard<mutex> guard(lock);
+        client.rpush(to_string(docID), val, [&length](cpp_redis::reply& reply) {
+            if(reply.is_integer())
+                length = reply.as_integer();
+        });
+        client.sync_commit();
+    }
+
+    compiled.append(docID, trans, length - trans.size());
+}
+
+void TranslationTable::insertBatch(const vector<pair<int, vector<Translation>>>& batch) {
+    static Metrics::Histogram& hist = Metrics::histogram("redis.transtable.insert_batch_ns");
+    Metrics::ScopedTimer timer(hist);
+
+    //Length of the list of each document after its push
+    vector<long long> lengths(batch.size(), 0);
+    {
+        lock_guard<mutex> guard(lock);
+        for(size_t i = 0; i < batch.size(); ++i) {
+            //An unchanged document has nothing to append
+            if(batch[i].second.empty())
+                continue;
+
+            vector<string> val;
+            for(const Translation& t : batch[i].second)
+                val.push_back(transToString(t));
+            long long& length = lengths[i];
+            client.rpush(to_string(batch[i].first), val, [&length](cpp_redis::reply& reply) {
+                if(reply.is_integer())
+                    length = reply.as_integer();
+            });
+        }
+        client.sync_commit();
+    }
+
+    for(size_t i = 0; i < batch.size(); ++i) {
+        if(!batch[i].second.empty())
+            compiled.append(batch[i].first, batch[i].second, lengths[i] - batch[i].second.size());
+    }
 }
 
 void TranslationTable::erase(int docID) {
-    client.del( {to_string(docID)} );
-    client.commit();
+    static Metrics::Histogram& hist = Metrics::histogram("redis.transtable.erase_ns");
+    Metrics::ScopedTimer timer(hist);
+
+    {
+        lock_guard<mutex> guard(lock);
+        client.del( {to_string(docID)} );
+        client.commit();
+    }
+
+    compiled.erase(docID);
 }
 
 void TranslationTable::dump() {
     //Ensure database is saved
+    lock_guard<mutex> guard(lock);
     client.save();
     client.sync_commit();
 }
 
 void TranslationTable::clear() {
-    client.flushdb();
-    client.sync_commit();
+    {
+        lock_guard<mutex> guard(lock);
+        client.flushdb();
+        client.sync_commit();
+    }
+
+    compiled.clear();
 }
 
-string transToString(Translation& t) {
+string transToString(const Translation& t) {
     stringstream result;
     result << t.loc << "-" << t.oldlen << "-" << t.newlen;
     return result.str();
 }
 
 Translation stringToTrans(const string& s) {
-    int nums[3];
-    stringstream stringtrans(s);
-    string token;
-    int i = 0;
-    while(getline(stringtrans, token, '-')) {
-        nums[i] = stoi(token);
-        ++i;
+    //"loc-oldlen-newlen", all non-negative
+    int nums[3] = {0, 0, 0};
+    const char* pos = s.c_str();
+    for(int i = 0; i < 3; ++i) {
+        char* end;
+        nums[i] = strtol(pos, &end, 10);
+        pos = (*end == '-') ? end + 1 : end;
     }
     
     return Translation(nums[0], nums[1], nums[2]);
@@ -2,6 +2,8 @@
 #define TRANSLATIONTABLE_H
 
 #include <vector>
+#include <memory>
+#include <mutex>
 #include <cpp_redis/cpp_redis>
 
 #ifdef _WIN32
@@ -9,12 +11,24 @@
 #endif /* _WIN32 */
 
 #include "doc_analyzer/Matcher/translate.h"
+#include "Structures/translationcache.h"
+#include "global_parameters.hpp"
 
 class TranslationTable {
 public:
     TranslationTable();
+    //Returns a negative number if the position was removed by a later edit
     int apply(int docID, size_t fragID, int position);
+    //Maps many (fragID, position) pairs of one document with a single translation lookup
+    //Returns the positions in input order, negative for positions removed by a later edit
+    std::vector<int> applyBatch(int docID, const std::vector<FragmentPosition>& positions);
+    //Every translation of the document, oldest first
+    std::vector<Translation> getTranslations(int docID);
+    //Every translation of the document compiled for fast lookups. Served from memory once compiled
+    std::shared_ptr<const CompiledTranslations> getCompiled(int docID);
     void insert(std::vector<Translation>& trans, int docID);
+    //Same as insert for many documents, with a single round trip to redis. Pairs are (docID, translations)
+    void insertBatch(const std::vector<std::pair<int, std::vector<Translation>>>& batch);
     //If a document gets reindexed, throw away its translation list
     void erase(int docID);
     void dump();
@@ -24,6 +38,11 @@ private:
     //key: docID
     //val: translations
     cpp_redis::client client;
+    //Queries read translations while the index writer inserts them, and the client is not thread safe
+    std::mutex lock;
+
+    //Compiled translations of recently used documents. insert extends a cached entry instead of dropping it
+    TranslationCache compiled;
 };
 
 #endif
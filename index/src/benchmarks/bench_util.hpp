@@ -0,0 +1,60 @@
+#ifndef BENCH_UTIL_HPP
+#define BENCH_UTIL_HPP
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+
+//Draws ranks in [0, n) following Zipf's law with exponent s
+//Shared by the benchmarks so that generated corpora and posting lists look like real text
+class ZipfGenerator {
+public:
+    ZipfGenerator(size_t n, double s) : dis(0, 1.0) {
+        cdf.reserve(n);
+        double sum = 0;
+        for(size_t i = 1; i <= n; ++i) {
+            sum += 1.0 / std::pow(i, s);
+            cdf.push_back(sum);
+        }
+        for(double& p : cdf)
+            p /= sum;
+    }
+
+    size_t next(std::mt19937_64& gen) {
+        auto iter = std::lower_bound(cdf.begin(), cdf.end(), dis(gen));
+        if(iter == cdf.end())
+            return cdf.size() - 1;
+        return iter - cdf.begin();
+    }
+
+private:
+    std::vector<double> cdf;
+    std::uniform_real_distribution<double> dis;
+};
+
+//Generates a sorted list of n docIDs whose gaps follow a Zipfian distribution, as in a real posting list
+inline std::vector<unsigned int> makeDocIDList(size_t n, size_t maxgap, std::mt19937_64& gen) {
+    ZipfGenerator zipf(maxgap, 1.1);
+    std::vector<unsigned int> docIDs;
+    docIDs.reserve(n);
+
+    unsigned int docID = 0;
+    for(size_t i = 0; i < n; ++i) {
+        docID += zipf.next(gen) + 1;
+        docIDs.push_back(docID);
+    }
+    return docIDs;
+}
+
+//Generates n term frequencies, where most terms appear only a few times in a document
+inline std::vector<unsigned int> makeFrequencies(size_t n, std::mt19937_64& gen) {
+    ZipfGenerator zipf(1000, 2.0);
+    std::vector<unsigned int> freqs;
+    freqs.reserve(n);
+    for(size_t i = 0; i < n; ++i)
+        freqs.push_back(zipf.next(gen) + 1);
+    return freqs;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,247 @@
+/**
+ * End-to-end benchmark for the index: ingestion, flushing, merging and querying.
+ * Documents are generated from a fixed seed so that every run sees the same corpus, and versions are produced
+ * with the DocumentMorpher in the same way as the INSERT script command.
+ * Results are written as json so that runs can be compared against each other.
+ *
+ * Documents are inserted one at a time, or with insert_documents when a batch size is given.
+ *
+ * Usage: ./index_bench outputfile [docs] [versions] [queries] [seed] [postinglimit] [batchsize]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <algorithm>
+#include <chrono>
+
+#include "index.hpp"
+#include "morph.hpp"
+#include "redis.hpp"
+#include "utility/util.hpp"
+#include "utility/metrics.hpp"
+#include "libs/json.hpp"
+#include "benchmarks/bench_util.hpp"
+
+std::string makeTerm(size_t rank) {
+    return "t" + std::to_string(rank);
+}
+
+//Generates a document of random length with terms drawn from the vocabulary
+std::string makeDocument(ZipfGenerator& zipf, std::mt19937_64& gen, size_t minlen, size_t maxlen) {
+    std::uniform_int_distribution<size_t> lendis(minlen, maxlen);
+    size_t len = lendis(gen);
+
+    std::string doc;
+    for(size_t i = 0; i < len; ++i) {
+        doc += makeTerm(zipf.next(gen));
+        doc += (i % 16 == 15) ? '\n' : ' ';
+    }
+    return doc;
+}
+
+//Returns p-th percentile of a sorted list of latencies
+double percentile(std::vector<double>& sorted, double p) {
+    if(sorted.empty())
+        return 0;
+    size_t index = std::min(sorted.size() - 1, (size_t)(p / 100.0 * sorted.size()));
+    return sorted[index];
+}
+
+nlohmann::json summarize(std::vector<double>& latencies) {
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for(double l : latencies)
+        sum += l;
+
+    return nlohmann::json::object({
+        {"count", latencies.size()},
+        {"mean_us", latencies.empty() ? 0 : sum / latencies.size()},
+        {"p50_us", percentile(latencies, 50)},
+        {"p90_us", percentile(latencies, 90)},
+        {"p99_us", percentile(latencies, 99)},
+        {"max_us", latencies.empty() ? 0 : latencies.back()},
+    });
+}
+
+//Removes static indexes left behind by a previous run so every run starts from an empty index
+void removeStaticIndexes(std::string dir) {
+    for(std::string path : {dir + GlobalConst::PosPath, dir + GlobalConst::NonPosPath}) {
+        try {
+            for(std::string& name : Utility::readDirectory(path))
+                remove((path + name).c_str());
+        }
+        catch(const std::runtime_error& e) {}
+    }
+}
+
+double perSecond(double amount, long long ns) {
+    if(ns <= 0)
+        return 0;
+    return amount / (ns / 1e9);
+}
+
+int main(int argc, char **argv) {
+    if(argc < 2) {
+        std::cout << "Usage: ./index_bench outputfile [docs] [versions] [queries] [seed] [postinglimit] [batchsize]" << std::endl;
+        return 1;
+    }
+
+    std::string outputpath = argv[1];
+    size_t doccount = argc > 2 ? std::stoul(argv[2]) : 200;
+    int versioncount = argc > 3 ? std::stoi(argv[3]) : 5;
+    size_t querycount = argc > 4 ? std::stoul(argv[4]) : 200;
+    unsigned long seed = argc > 5 ? std::stoul(argv[5]) : 42;
+    unsigned long postinglimit = argc > 6 ? std::stoul(argv[6]) : 100000;
+    size_t batchsize = argc > 7 ? std::stoul(argv[7]) : 0;
+
+    const size_t vocabsize = 50000;
+
+    std::mt19937_64 gen(seed);
+    ZipfGenerator zipf(vocabsize, 1.0);
+
+    //Generate the base documents. Each document is morphed towards the next one to create its versions
+    std::vector<std::string> basedocs;
+    for(size_t i = 0; i <= doccount; ++i) {
+        basedocs.push_back(makeDocument(zipf, gen, 200, 2000));
+    }
+
+    redisFlushDatabase();
+    removeStaticIndexes("./bench_index");
+    Index index("bench_index", postinglimit);
+    index.clear();
+
+    //Ingestion
+    size_t docsinserted = 0;
+    unsigned long long bytesinserted = 0;
+    auto ingestbegin = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < doccount && batchsize == 0; ++i) {
+        std::string url = "http://bench.local/doc" + std::to_string(i);
+
+        DocumentMorpher morpher(basedocs[i], basedocs[i+1], versioncount, seed + i);
+        while(true) {
+            std::string version = morpher.getDocument();
+            index.insert_document(url, version);
+            bytesinserted += version.size();
+            docsinserted++;
+
+            if(!morpher.isValid())
+                break;
+            morpher.nextVersion();
+        }
+    }
+    //A batch holds each url once, so it takes the next version of batchsize documents
+    for(size_t first = 0; first < doccount && batchsize > 0; first += batchsize) {
+        size_t last = std::min(doccount, first + batchsize);
+        std::vector<DocumentMorpher> morphers;
+        for(size_t i = first; i < last; ++i)
+            morphers.emplace_back(basedocs[i], basedocs[i+1], versioncount, seed + i);
+
+        std::vector<bool> done(morphers.size(), false);
+        while(true) {
+            std::vector<std::string> versions;
+            std::vector<DocumentInput> batch;
+            for(size_t i = 0; i < morphers.size(); ++i) {
+                if(done[i])
+                    continue;
+                versions.push_back(morphers[i].getDocument());
+                batch.push_back({"http://bench.local/doc" + std::to_string(first + i), std::string_view()});
+            }
+            if(batch.empty())
+                break;
+            for(size_t i = 0; i < batch.size(); ++i) {
+                batch[i].page = versions[i];
+                bytesinserted += versions[i].size();
+            }
+            index.insert_documents(batch);
+            docsinserted += batch.size();
+
+            for(size_t i = 0; i < morphers.size(); ++i) {
+                if(done[i] || !morphers[i].isValid())
+                    done[i] = true;
+                else
+                    morphers[i].nextVersion();
+            }
+        }
+    }
+    auto ingestend = std::chrono::steady_clock::now();
+    long long ingestns = std::chrono::duration_cast<std::chrono::nanoseconds>(ingestend - ingestbegin).count();
+
+    //Queries of different shapes. Head terms are the most frequent terms of the vocabulary, tail terms are rare
+    std::uniform_int_distribution<size_t> headdis(0, 99);
+    std::uniform_int_distribution<size_t> taildis(1000, vocabsize - 1);
+
+    struct QueryShape {
+        std::string name;
+        int headterms;
+        int tailterms;
+    };
+    std::vector<QueryShape> shapes = {
+        {"1_head", 1, 0},
+        {"1_tail", 0, 1},
+        {"2_head", 2, 0},
+        {"1_head_1_tail", 1, 1},
+        {"4_mixed", 2, 2},
+    };
+
+    nlohmann::json queryresults;
+    for(QueryShape& shape : shapes) {
+        std::vector<double> latencies;
+        for(size_t q = 0; q < querycount; ++q) {
+            std::vector<std::string> words;
+            for(int i = 0; i < shape.headterms; ++i)
+                words.push_back(makeTerm(headdis(gen)));
+            for(int i = 0; i < shape.tailterms; ++i)
+                words.push_back(makeTerm(taildis(gen)));
+
+            auto querybegin = std::chrono::steady_clock::now();
+            index.query(words);
+            auto queryend = std::chrono::steady_clock::now();
+            latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(queryend - querybegin).count() / 1e3);
+        }
+        queryresults[shape.name] = summarize(latencies);
+    }
+
+    const StaticIndex::IOStats& iostats = index.getStaticStats();
+
+    nlohmann::json results = {
+        {"config", {
+            {"docs", doccount},
+            {"versions", versioncount},
+            {"queries_per_shape", querycount},
+            {"seed", seed},
+            {"posting_limit", postinglimit},
+            {"batch_size", batchsize},
+            {"vocabulary", vocabsize},
+        }},
+        {"ingest", {
+            {"documents", docsinserted},
+            {"postings", index.getPostingsInserted()},
+            {"seconds", ingestns / 1e9},
+            {"docs_per_s", perSecond(docsinserted, ingestns)},
+            {"postings_per_s", perSecond(index.getPostingsInserted(), ingestns)},
+            {"input_mb_per_s", perSecond(bytesinserted / 1e6, ingestns)},
+        }},
+        {"flush", {
+            {"count", iostats.flushcount},
+            {"mb", iostats.flushbytes / 1e6},
+            {"mb_per_s", perSecond(iostats.flushbytes / 1e6, iostats.flushns)},
+        }},
+        {"merge", {
+            {"count", iostats.mergecount},
+            {"mb", iostats.mergebytes / 1e6},
+            {"mb_per_s", perSecond(iostats.mergebytes / 1e6, iostats.mergens)},
+        }},
+        {"query", queryresults},
+        //Per-stage breakdown collected by the metrics registry during the run
+        {"metrics", Metrics::toJson()},
+    };
+
+    std::ofstream ofile(outputpath, std::ios::out | std::ios::trunc);
+    ofile << results.dump(4) << std::endl;
+    std::cout << results.dump(4) << std::endl;
+
+    index.clear();
+
+    return 0;
+}
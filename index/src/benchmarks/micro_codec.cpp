@@ -0,0 +1,72 @@
+/**
+ * Micro-benchmarks for the posting codec: VBEncode/VBDecode and block (de)compression.
+ * Counters report the cost per encoded or decoded integer.
+ */
+
+#include "global_parameters.hpp"
+#include "static_functions/compression.hpp"
+#include "static_functions/compression_functions/varbyte.hpp"
+#include "benchmarks/micro_util.hpp"
+
+//Gaps of a docID block, which is what VBEncode sees when delta compressing
+std::vector<unsigned int> makeGaps(size_t n) {
+    std::mt19937_64 gen(7);
+    std::vector<unsigned int> docIDs = makeDocIDList(n, 1000, gen);
+    std::vector<unsigned int> gaps(n);
+    gaps[0] = docIDs[0];
+    for(size_t i = 1; i < n; ++i)
+        gaps[i] = docIDs[i] - docIDs[i-1];
+    return gaps;
+}
+
+static void BM_VBEncode(benchmark::State& state) {
+    std::vector<unsigned int> gaps = makeGaps(BLOCKSIZE * 64);
+
+    for(auto _ : state) {
+        for(unsigned int gap : gaps) {
+            std::list<uint8_t> bytes = VBEncode(gap);
+            benchmark::DoNotOptimize(bytes);
+        }
+    }
+    state.counters["ns/int"] = nsPer(gaps.size());
+}
+BENCHMARK(BM_VBEncode);
+
+static void BM_VBDecode(benchmark::State& state) {
+    std::vector<unsigned int> gaps = makeGaps(BLOCKSIZE * 64);
+    std::vector<uint8_t> bytes = encode_array(gaps, VBEncode, 1);
+
+    for(auto _ : state) {
+        std::vector<unsigned int> decoded = VBDecode(bytes);
+        benchmark::DoNotOptimize(decoded.data());
+    }
+    state.counters["ns/int"] = nsPer(gaps.size());
+    state.counters["bytes/int"] = bytes.size() / (double)gaps.size();
+}
+BENCHMARK(BM_VBDecode);
+
+//Argument is the number of postings in the block, to cover partially filled trailing blocks
+static void BM_CompressBlock(benchmark::State& state) {
+    std::mt19937_64 gen(11);
+    std::vector<unsigned int> docIDs = makeDocIDList(state.range(0), 1000, gen);
+
+    for(auto _ : state) {
+        std::vector<uint8_t> compressed = compress_block(docIDs, VBEncode, true);
+        benchmark::DoNotOptimize(compressed.data());
+    }
+    state.counters["ns/int"] = nsPer(docIDs.size());
+}
+BENCHMARK(BM_CompressBlock)->Arg(8)->Arg(BLOCKSIZE / 2)->Arg(BLOCKSIZE);
+
+static void BM_DecompressBlock(benchmark::State& state) {
+    std::mt19937_64 gen(11);
+    std::vector<unsigned int> docIDs = makeDocIDList(state.range(0), 1000, gen);
+    std::vector<uint8_t> compressed = compress_block(docIDs, VBEncode, true);
+
+    for(auto _ : state) {
+        std::vector<unsigned int> decompressed = decompress_block(compressed, VBDecode, true);
+        benchmark::DoNotOptimize(decompressed.data());
+    }
+    state.counters["ns/int"] = nsPer(docIDs.size());
+}
+BENCHMARK(BM_DecompressBlock)->Arg(8)->Arg(BLOCKSIZE / 2)->Arg(BLOCKSIZE);
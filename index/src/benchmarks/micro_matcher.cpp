@@ -0,0 +1,233 @@
+/**
+ * Micro-benchmarks for the matcher kernels: tokenizing, candidate block generation, the distance table DP,
+ * matching revisions and mapping positions through translations.
+ */
+
+#include <string>
+#include <algorithm>
+#include <iostream>
+
+#include "global_parameters.hpp"
+#include "doc_analyzer/Matcher/blockmatching.hpp"
+#include "doc_analyzer/Matcher/distancetable.h"
+#include "doc_analyzer/Matcher/matcher.h"
+#include "doc_analyzer/Matcher/translate.h"
+#include "benchmarks/micro_util.hpp"
+
+namespace {
+
+//Builds an old and a new version of a document with the given number of tokens
+//editrate is the probability that a token of the new version is replaced
+std::pair<std::string, std::string> makeVersions(size_t tokens, double editrate) {
+    std::mt19937_64 gen(17);
+    ZipfGenerator zipf(20000, 1.0);
+    std::uniform_real_distribution<double> dis(0, 1.0);
+
+    std::string olddoc, newdoc;
+    for(size_t i = 0; i < tokens; ++i) {
+        std::string token = "t" + std::to_string(zipf.next(gen)) + " ";
+        olddoc += token;
+        if(dis(gen) < editrate)
+            newdoc += "t" + std::to_string(zipf.next(gen)) + " ";
+        else
+            newdoc += token;
+    }
+    return std::make_pair(olddoc, newdoc);
+}
+
+//Builds an old version of a document and a revision that replaces edited tokens in the middle
+std::pair<std::string, std::string> makeRevision(size_t tokens, size_t edited) {
+    std::mt19937_64 gen(19);
+    ZipfGenerator zipf(20000, 1.0);
+
+    std::string olddoc, newdoc;
+    for(size_t i = 0; i < tokens; ++i) {
+        std::string token = "t" + std::to_string(zipf.next(gen)) + " ";
+        olddoc += token;
+        if(i >= tokens / 2 && i < tokens / 2 + edited)
+            newdoc += "t" + std::to_string(zipf.next(gen)) + " ";
+        else
+            newdoc += token;
+    }
+    return std::make_pair(olddoc, newdoc);
+}
+
+//Translations of a document edited versions times, each version replacing a small block of a 5000 token document
+std::vector<Translation> makeTranslations(size_t versions) {
+    std::mt19937_64 gen(23);
+    std::uniform_int_distribution<int> loc(0, 4990);
+    std::uniform_int_distribution<int> len(0, 8);
+
+    std::vector<Translation> translations;
+    for(size_t i = 0; i < versions; ++i)
+        translations.emplace_back(loc(gen), len(gen), len(gen));
+    return translations;
+}
+
+//Postings of a document spread over every version. A posting list holds them sorted by fragment and position
+std::vector<FragmentPosition> makePositions(size_t count, size_t versions, bool sorted) {
+    std::mt19937_64 gen(29);
+    std::uniform_int_distribution<unsigned int> frag(0, versions);
+    std::uniform_int_distribution<unsigned int> pos(0, 4999);
+
+    std::vector<FragmentPosition> positions;
+    for(size_t i = 0; i < count; ++i)
+        positions.emplace_back(frag(gen), pos(gen));
+    if(sorted)
+        std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+}
+
+//Arguments: document length in tokens, edit rate in percent
+static void BM_StringEncoder(benchmark::State& state) {
+    auto versions = makeVersions(state.range(0), state.range(1) / 100.0);
+
+    size_t tokens = 0;
+    for(auto _ : state) {
+        StringEncoder se(versions.first, versions.second);
+        tokens = se.getOldSize() + se.getNewSize();
+        benchmark::DoNotOptimize(tokens);
+    }
+    state.counters["ns/token"] = nsPer(tokens);
+}
+BENCHMARK(BM_StringEncoder)->Args({1000, 1})->Args({10000, 1});
+
+static void BM_GetCommonBlocks(benchmark::State& state) {
+    auto versions = makeVersions(state.range(0), state.range(1) / 100.0);
+    StringEncoder se(versions.first, versions.second);
+
+    size_t blocks = 0;
+    for(auto _ : state) {
+        auto commonblocks = getCommonBlocks(MIN_BLOCK_SIZE, se);
+        blocks = commonblocks.size();
+        benchmark::DoNotOptimize(commonblocks.data());
+    }
+    state.counters["ns/token"] = nsPer(se.getOldSize() + se.getNewSize());
+    state.counters["blocks"] = blocks;
+}
+BENCHMARK(BM_GetCommonBlocks)->Args({1000, 1})->Args({10000, 1})->Args({10000, 10})->Args({100000, 1});
+
+//Same output as getCommonBlocks followed by extendBlocks
+static void BM_GetMaximalBlocks(benchmark::State& state) {
+    auto versions = makeVersions(state.range(0), state.range(1) / 100.0);
+    StringEncoder se(versions.first, versions.second);
+
+    size_t blocks = 0;
+    for(auto _ : state) {
+        auto commonblocks = getMaximalBlocks(MIN_BLOCK_SIZE, se);
+        blocks = commonblocks.size();
+        benchmark::DoNotOptimize(commonblocks.data());
+    }
+    state.counters["ns/token"] = nsPer(se.getOldSize() + se.getNewSize());
+    state.counters["blocks"] = blocks;
+}
+BENCHMARK(BM_GetMaximalBlocks)->Args({1000, 1})->Args({10000, 1})->Args({10000, 10})->Args({100000, 1});
+
+static void BM_GetAndExtendCommonBlocks(benchmark::State& state) {
+    auto versions = makeVersions(state.range(0), state.range(1) / 100.0);
+    StringEncoder se(versions.first, versions.second);
+
+    for(auto _ : state) {
+        auto commonblocks = getCommonBlocks(MIN_BLOCK_SIZE, se);
+        extendBlocks(commonblocks, se);
+        benchmark::DoNotOptimize(commonblocks.data());
+    }
+    state.counters["ns/token"] = nsPer(se.getOldSize() + se.getNewSize());
+}
+BENCHMARK(BM_GetAndExtendCommonBlocks)->Args({1000, 1})->Args({10000, 1})->Args({10000, 10})->Args({100000, 1});
+
+static void BM_DistanceTable(benchmark::State& state) {
+    auto versions = makeVersions(state.range(0), state.range(1) / 100.0);
+    StringEncoder se(versions.first, versions.second);
+    auto commonblocks = getMaximalBlocks(MIN_BLOCK_SIZE, se);
+    resolveIntersections(commonblocks);
+
+    for(auto _ : state) {
+        DistanceTable disttable(MAX_BLOCK_COUNT, commonblocks);
+        auto path = disttable.findOptimalPath(0);
+        benchmark::DoNotOptimize(path.data());
+    }
+    state.counters["ns/block"] = nsPer(commonblocks.size());
+    state.counters["blocks"] = commonblocks.size();
+}
+BENCHMARK(BM_DistanceTable)->Args({1000, 1})->Args({10000, 1})->Args({10000, 10})->Args({100000, 10});
+
+//Arguments: document length in tokens, edited tokens, whether the common prefix and suffix are trimmed first
+static void BM_MatchRevision(benchmark::State& state) {
+    auto versions = makeRevision(state.range(0), state.range(1));
+    StringEncoder se(versions.first, versions.second);
+
+    //getOptimalBlocks reports its block counts on stdout
+    std::cout.setstate(std::ios::failbit);
+    for(auto _ : state) {
+        auto path = state.range(2) ? getTrimmedBlocks(se, MIN_BLOCK_SIZE, MAX_BLOCK_COUNT, 0)
+            : getOptimalBlocks(se, MIN_BLOCK_SIZE, MAX_BLOCK_COUNT, 0);
+        benchmark::DoNotOptimize(path.data());
+    }
+    std::cout.clear();
+    state.counters["ns/token"] = nsPer(se.getOldSize() + se.getNewSize());
+}
+BENCHMARK(BM_MatchRevision)->Args({10000, 0, 0})->Args({10000, 0, 1})->Args({10000, 5, 0})->Args({10000, 5, 1});
+
+//The same DP over an explicit block graph
+static void BM_DistanceTableGraph(benchmark::State& state) {
+    auto versions = makeVersions(state.range(0), state.range(1) / 100.0);
+    StringEncoder se(versions.first, versions.second);
+    auto commonblocks = getMaximalBlocks(MIN_BLOCK_SIZE, se);
+    resolveIntersections(commonblocks);
+
+    for(auto _ : state) {
+        BlockGraph graph(commonblocks);
+        DistanceTable disttable(MAX_BLOCK_COUNT, graph, topologicalSort(graph));
+        auto path = disttable.findOptimalPath(0);
+        benchmark::DoNotOptimize(path.data());
+    }
+    state.counters["ns/block"] = nsPer(commonblocks.size());
+    state.counters["blocks"] = commonblocks.size();
+}
+BENCHMARK(BM_DistanceTableGraph)->Args({1000, 1})->Args({10000, 1})->Args({10000, 10});
+
+
+//Arguments: positions mapped, translations of the document, whether the positions are in posting list order
+//Per position path of TranslationTable::apply once the translations are fetched: walk every later translation
+static void BM_ApplyTranslations(benchmark::State& state) {
+    std::vector<Translation> translations = makeTranslations(state.range(1));
+    std::vector<FragmentPosition> positions = makePositions(state.range(0), state.range(1), state.range(2));
+
+    for(auto _ : state) {
+        int sum = 0;
+        for(const FragmentPosition& p : positions)
+            sum += applyTranslations(p.second, p.first, translations);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.counters["ns/position"] = nsPer(positions.size());
+}
+BENCHMARK(BM_ApplyTranslations)->Args({100, 10, 1})->Args({1000, 10, 1})->Args({1000, 100, 1})->Args({1000, 100, 0});
+
+static void BM_CompiledApply(benchmark::State& state) {
+    CompiledTranslations compiled(makeTranslations(state.range(1)));
+    std::vector<FragmentPosition> positions = makePositions(state.range(0), state.range(1), state.range(2));
+
+    for(auto _ : state) {
+        int sum = 0;
+        for(const FragmentPosition& p : positions)
+            sum += compiled.apply(p.second, p.first);
+        benchmark::DoNotOptimize(sum);
+    }
+    state.counters["ns/position"] = nsPer(positions.size());
+}
+BENCHMARK(BM_CompiledApply)->Args({100, 10, 1})->Args({1000, 10, 1})->Args({1000, 100, 1})->Args({1000, 100, 0});
+
+static void BM_CompiledApplyBatch(benchmark::State& state) {
+    CompiledTranslations compiled(makeTranslations(state.range(1)));
+    std::vector<FragmentPosition> positions = makePositions(state.range(0), state.range(1), state.range(2));
+
+    for(auto _ : state) {
+        std::vector<int> mapped = compiled.applyBatch(positions);
+        benchmark::DoNotOptimize(mapped.data());
+    }
+    state.counters["ns/position"] = nsPer(positions.size());
+}
+BENCHMARK(BM_CompiledApplyBatch)->Args({100, 10, 1})->Args({1000, 10, 1})->Args({1000, 100, 1})->Args({1000, 100, 0});
\ No newline at end of file
@@ -0,0 +1,215 @@
+/**
+ * Micro-benchmarks for the query kernels: query_primitive_low::nextGEQ/getFreq over static (with and without the
+ * block cache) and in-memory posting lists, and BM25 scoring.
+ */
+
+#include <fstream>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "posting.hpp"
+#include "global_parameters.hpp"
+#include "query_processing/query_primitive_low.hpp"
+#include "query_processing/ranking_functions/BM25.hpp"
+#include "static_functions/postingIO.hpp"
+#include "benchmarks/micro_util.hpp"
+
+namespace {
+
+const unsigned int BENCH_TERMID = 1;
+//Static index files are named after their order
+const std::string BENCH_INDEX_DIR = "./microbench";
+const std::string BENCH_INDEX_PATH = BENCH_INDEX_DIR + "/Z0";
+
+std::vector<nPosting> makePostingList(size_t n) {
+    std::mt19937_64 gen(3);
+    std::vector<unsigned int> docIDs = makeDocIDList(n, 64, gen);
+    std::vector<unsigned int> freqs = makeFrequencies(n, gen);
+
+    std::vector<nPosting> postinglist;
+    postinglist.reserve(n);
+    for(size_t i = 0; i < n; ++i)
+        postinglist.emplace_back(BENCH_TERMID, docIDs[i], freqs[i]);
+    return postinglist;
+}
+
+//Writes a single posting list as a static index so that it can be read back by query_primitive_low
+std::shared_ptr<const StaticFileHandle> writeStaticList(std::vector<nPosting>& postinglist) {
+    mkdir(BENCH_INDEX_DIR.c_str(), S_IRWXU);
+    {
+        std::ofstream ofile(BENCH_INDEX_PATH, std::ios::out | std::ios::trunc);
+        write_postinglist(ofile, BENCH_TERMID, postinglist, false);
+    }
+    return std::make_shared<const StaticFileHandle>(BENCH_INDEX_PATH, 0, std::map<unsigned int, unsigned long>());
+}
+
+void removeStaticList() {
+    std::remove(BENCH_INDEX_PATH.c_str());
+    rmdir(BENCH_INDEX_DIR.c_str());
+}
+
+}
+
+//Arguments: list length, and how many postings each nextGEQ call skips over
+static void BM_NextGEQStatic(benchmark::State& state) {
+    std::vector<nPosting> postinglist = makePostingList(state.range(0));
+    auto file = writeStaticList(postinglist);
+    size_t stride = state.range(1);
+
+    size_t calls = 0;
+    QueryStats stats;
+    for(auto _ : state) {
+        state.PauseTiming();
+        query_primitive_low qpl(BENCH_TERMID, file, stats);
+        calls = 0;
+        state.ResumeTiming();
+
+        bool failure = false;
+        for(size_t i = 0; i < postinglist.size(); i += stride) {
+            benchmark::DoNotOptimize(qpl.nextGEQ(postinglist[i].docID, failure));
+            calls++;
+        }
+    }
+    state.counters["ns/skip"] = nsPer(calls);
+
+    removeStaticList();
+}
+BENCHMARK(BM_NextGEQStatic)->Args({100000, 1})->Args({100000, 16})->Args({100000, BLOCKSIZE * 4});
+
+//Walks every posting of a static list and reads its frequency, as DAAT does for a single-term query
+static void BM_GetFreqStatic(benchmark::State& state) {
+    std::vector<nPosting> postinglist = makePostingList(state.range(0));
+    auto file = writeStaticList(postinglist);
+
+    QueryStats stats;
+    for(auto _ : state) {
+        state.PauseTiming();
+        query_primitive_low qpl(BENCH_TERMID, file, stats);
+        state.ResumeTiming();
+
+        bool failure = false;
+        unsigned int docID = 0;
+        while(true) {
+            docID = qpl.nextGEQ(docID, failure);
+            if(failure)
+                break;
+            benchmark::DoNotOptimize(qpl.getFreq());
+            docID++;
+        }
+    }
+    state.counters["ns/doc"] = nsPer(postinglist.size());
+
+    removeStaticList();
+}
+BENCHMARK(BM_GetFreqStatic)->Arg(BLOCKSIZE / 2)->Arg(BLOCKSIZE * 10 + 5)->Arg(100000);
+
+//Same walk as BM_GetFreqStatic, but with every block already in the shared block cache
+static void BM_GetFreqStaticCached(benchmark::State& state) {
+    std::vector<nPosting> postinglist = makePostingList(state.range(0));
+    auto file = writeStaticList(postinglist);
+    BlockCache cache(BLOCK_CACHE_BYTES);
+
+    QueryStats stats;
+    for(auto _ : state) {
+        state.PauseTiming();
+        query_primitive_low qpl(BENCH_TERMID, file, stats, &cache);
+        state.ResumeTiming();
+
+        bool failure = false;
+        unsigned int docID = 0;
+        while(true) {
+            docID = qpl.nextGEQ(docID, failure);
+            if(failure)
+                break;
+            benchmark::DoNotOptimize(qpl.getFreq());
+            docID++;
+        }
+    }
+    state.counters["ns/doc"] = nsPer(postinglist.size());
+
+    removeStaticList();
+}
+BENCHMARK(BM_GetFreqStaticCached)->Arg(BLOCKSIZE * 10 + 5)->Arg(100000);
+
+static void BM_NextGEQInMemory(benchmark::State& state) {
+    std::vector<nPosting> postinglist = makePostingList(state.range(0));
+    NonPosMemtable memtable;
+    for(nPosting& posting : postinglist)
+        memtable.insert(posting);
+    memtable.publish();
+    size_t stride = state.range(1);
+
+    size_t calls = 0;
+    QueryStats stats;
+    for(auto _ : state) {
+        state.PauseTiming();
+        query_primitive_low qpl(*memtable.find(BENCH_TERMID), postinglist.size(), 0, stats);
+        calls = 0;
+        state.ResumeTiming();
+
+        bool failure = false;
+        for(size_t i = 0; i < postinglist.size(); i += stride) {
+            benchmark::DoNotOptimize(qpl.nextGEQ(postinglist[i].docID, failure));
+            calls++;
+        }
+    }
+    state.counters["ns/skip"] = nsPer(calls);
+}
+BENCHMARK(BM_NextGEQInMemory)->Args({100000, 1})->Args({100000, 16});
+
+//Opens an in-memory list and walks all of it, as a single-term query on a recently updated term does.
+//Arguments: list length, and the percentage of postings that were inserted out of docID order
+static void BM_WalkInMemory(benchmark::State& state) {
+    std::vector<nPosting> postinglist = makePostingList(state.range(0));
+    std::mt19937_64 gen(9);
+    std::uniform_int_distribution<int> dis(0, 99);
+    for(size_t i = 1; i < postinglist.size(); ++i) {
+        if(dis(gen) < state.range(1))
+            std::swap(postinglist[i - 1], postinglist[i]);
+    }
+
+    NonPosMemtable memtable;
+    for(nPosting& posting : postinglist) {
+        memtable.insert(posting);
+        memtable.publish();
+    }
+    auto list = memtable.find(BENCH_TERMID);
+
+    QueryStats stats;
+    for(auto _ : state) {
+        query_primitive_low qpl(*list, list->sortedSize(), list->sideSize(), stats);
+        bool failure = false;
+        unsigned int docID = 0;
+        while(true) {
+            docID = qpl.nextGEQ(docID, failure);
+            if(failure)
+                break;
+            benchmark::DoNotOptimize(qpl.getFreq());
+            docID++;
+        }
+    }
+    state.counters["ns/doc"] = nsPer(postinglist.size());
+    state.counters["side"] = list->sideSize();
+}
+BENCHMARK(BM_WalkInMemory)->Args({100000, 0})->Args({100000, 5});
+
+//Argument is the number of query terms
+static void BM_BM25(benchmark::State& state) {
+    const size_t docs = 4096;
+    std::mt19937_64 gen(5);
+    std::vector<unsigned int> freqs = makeFrequencies(docs * state.range(0), gen);
+    std::vector<unsigned int> docscontaining;
+    for(int i = 0; i < state.range(0); ++i)
+        docscontaining.push_back(1000 * (i + 1));
+
+    std::vector<unsigned int> docfreqs(state.range(0));
+    for(auto _ : state) {
+        for(size_t d = 0; d < docs; ++d) {
+            std::copy(freqs.begin() + d * docfreqs.size(), freqs.begin() + (d + 1) * docfreqs.size(), docfreqs.begin());
+            benchmark::DoNotOptimize(BM25(docfreqs, docscontaining, 300 + d % 500, 550.0, 1000000));
+        }
+    }
+    state.counters["ns/doc"] = nsPer(docs);
+}
+BENCHMARK(BM_BM25)->Arg(1)->Arg(2)->Arg(4);
@@ -0,0 +1,14 @@
+#ifndef MICRO_UTIL_HPP
+#define MICRO_UTIL_HPP
+
+#include <benchmark/benchmark.h>
+
+#include "benchmarks/bench_util.hpp"
+
+//Converts a count of items processed per iteration into a counter that reads as nanoseconds per item
+//(the console reporter still prints an "s" suffix after the number)
+inline benchmark::Counter nsPer(double items) {
+    return benchmark::Counter(items * 1e-9, benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+}
+
+#endif
\ No newline at end of file
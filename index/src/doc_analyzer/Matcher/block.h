@@ -2,7 +2,6 @@
 #define BLOCK_H
 
 #include <vector>
-#include <memory>
 
 #include "stringencoder.h"
 #include "utility/util.hpp"
@@ -12,8 +11,8 @@ struct Block {
     Block();
     Block(int o, int n, size_t l);
     
-    int oldendloc();
-    int newendloc();
+    int oldendloc() const;
+    int newendloc() const;
     
     //Indicates where in each file the block begins
     int oldloc;
@@ -27,14 +26,13 @@ struct Block {
 std::ostream& operator<<(std::ostream& os, const Block& bl);
 
 //Block operators
-//Define outside struct since they work based on pointers
-bool operator==(const std::shared_ptr<Block>& lhs, const std::shared_ptr<Block>& rhs);
+bool operator==(const Block& lhs, const Block& rhs);
 //Compare blocks based on location in old file
-bool compareOld(const std::shared_ptr<Block>& lhs, const std::shared_ptr<Block>& rhs);
+bool compareOld(const Block& lhs, const Block& rhs);
 //Compare blocks based on location in new file
-bool compareNew(const std::shared_ptr<Block>& lhs, const std::shared_ptr<Block>& rhs);
-bool compareSizeGreater(const std::shared_ptr<Block>& lhs, const std::shared_ptr<Block>& rhs);
+bool compareNew(const Block& lhs, const Block& rhs);
+bool compareSizeGreater(const Block& lhs, const Block& rhs);
 //Compares blocks by old location, then new location, then by length
-bool compareStrict(const std::shared_ptr<Block>& lhs, const std::shared_ptr<Block>& rhs);
+bool compareStrict(const Block& lhs, const Block& rhs);
 
 #endif
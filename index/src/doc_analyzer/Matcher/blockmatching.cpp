@@ -4,6 +4,7 @@
 #include <unordered_map>
 #include <algorithm>
 #include <iostream>
+#include <cstdint>
 
 #include "utility/util.hpp"
 
@@ -16,25 +17,87 @@ bool isOverlap(int oldbegin1, int newbegin1, int oldlen, int oldbegin2, int newb
         newbegin1 + oldlen <= newbegin2 + newlen;
 }
 
-void extendBlock(std::shared_ptr<Block> block, StringEncoder& se) {
+void extendBlock(Block& block, StringEncoder& se) {
     auto oldend = se.getOldEnd();
     auto newend = se.getNewEnd();
 
     //Go past end of block
-    auto olditer = se.getOldIter() + block->oldendloc()+1;
-    auto newiter = se.getNewIter() + block->newendloc()+1;
+    auto olditer = se.getOldIter() + block.oldendloc()+1;
+    auto newiter = se.getNewIter() + block.newendloc()+1;
 
     while(olditer != oldend && newiter != newend && *olditer == *newiter) {
-        block->len++;
+        block.len++;
         olditer++;
         newiter++;
     }
 }
 
+//Deletes every block contained in a block that comes before it. Blocks must be sorted with compareStrict
+void removeOverlapped(std::vector<Block>& commonblocks) {
+    //Create a vector of chars to store deleted locations
+    //Can't use bools since vector<bool> is special
+    std::vector<char> isdeleted(commonblocks.size());
+
+    //Eliminate overlaps
+    size_t index = 0;
+    while(index < commonblocks.size()) {
+            
+        //Potential overlap as long as the other block's begin is before this block's end
+        int oldendloc = commonblocks[index].oldendloc();
+        for(auto overlapchecker = commonblocks.begin() + index + 1; overlapchecker != commonblocks.end() && overlapchecker->oldloc <= oldendloc; overlapchecker++) {
+            if(isdeleted[overlapchecker - commonblocks.begin()])
+                continue;
+            
+            if(isOverlap(overlapchecker->oldloc, overlapchecker->newloc, overlapchecker->len,
+                commonblocks[index].oldloc, commonblocks[index].newloc, commonblocks[index].len))
+            {
+                isdeleted[overlapchecker - commonblocks.begin()] = 1;
+            }
+        }
+        
+        do {
+            index++;
+        } while(index < commonblocks.size() && isdeleted[index]);
+    }
+
+    //Move valid blocks to the front
+    size_t kept = 0;
+    for(size_t i = 0; i < commonblocks.size(); i++) {
+        if(!isdeleted[i])
+            commonblocks[kept++] = commonblocks[i];
+    }
+
+    commonblocks.resize(kept);
+}
+
+//Rabin-Karp hashes of every window of minsize tokens, modulo 2^64
+std::vector<uint64_t> windowHashes(std::vector<int>::const_iterator begin, std::vector<int>::const_iterator end, int minsize) {
+    const uint64_t base = 1000003;
+    //base^(minsize-1), to remove the token leaving the window
+    uint64_t leading = 1;
+    for(int i = 1; i < minsize; ++i)
+        leading *= base;
+
+    std::vector<uint64_t> hashes;
+    if(end - begin < minsize)
+        return hashes;
+    hashes.reserve(end - begin - minsize + 1);
+
+    uint64_t hash = 0;
+    for(auto iter = begin; iter != begin + minsize; ++iter)
+        hash = hash * base + (uint32_t)*iter;
+    hashes.push_back(hash);
+    for(auto iter = begin + minsize; iter != end; ++iter) {
+        hash = (hash - (uint32_t)*(iter - minsize) * leading) * base + (uint32_t)*iter;
+        hashes.push_back(hash);
+    }
+    return hashes;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-std::vector<std::shared_ptr<Block>> getCommonBlocks(int minsize, StringEncoder& se) {
-    std::vector<std::shared_ptr<Block>> commonblocks;
+std::vector<Block> getCommonBlocks(int minsize, StringEncoder& se) {
+    std::vector<Block> commonblocks;
     //Impossible to have common blocks if one doc is smaller than the minimum block size
     if(se.getOldSize() < minsize || se.getNewSize() < minsize || minsize < 1)
         return commonblocks;
@@ -77,7 +140,7 @@ std::vector<std::shared_ptr<Block>> getCommonBlocks(int minsize, StringEncoder&
         for(auto matchedblock = blockmatchrange.first; matchedblock != blockmatchrange.second; ++matchedblock) {
             //Double-check equality
             if(blockcheck == matchedblock->second.run) {
-                commonblocks.push_back(std::make_shared<Block>(matchedblock->second.oldloc, newiter - newbeginiter, matchedblock->second.run.size()));
+                commonblocks.emplace_back(matchedblock->second.oldloc, newiter - newbeginiter, matchedblock->second.run.size());
             }
         }
 
@@ -87,85 +150,99 @@ std::vector<std::shared_ptr<Block>> getCommonBlocks(int minsize, StringEncoder&
     return commonblocks;
 }
 
-void extendBlocks(std::vector<std::shared_ptr<Block>>& commonblocks, StringEncoder& se) {
-    if(commonblocks.size() <= 1)
-        return;
+std::vector<Block> getMaximalBlocks(int minsize, StringEncoder& se) {
+    std::vector<Block> commonblocks;
+    if(se.getOldSize() < minsize || se.getNewSize() < minsize || minsize < 1)
+        return commonblocks;
 
-    std::sort(commonblocks.begin(), commonblocks.end(), compareStrict);
-    //Create a vector of chars to store deleted locations
-    //Can't use bools since vector<bool> is special
-    std::vector<char> isdeleted(commonblocks.size());
+    auto oldbegin = se.getOldIter();
+    auto newbegin = se.getNewIter();
 
-    //Extend every block
-    for(auto iter = commonblocks.begin(); iter != commonblocks.end(); iter++) {
-        extendBlock(*iter, se);
+    //Candidates only hold the location of each window of the old document, chained in a table indexed by the top
+    //bits of the window hash
+    std::vector<uint64_t> oldhashes = windowHashes(oldbegin, se.getOldEnd(), minsize);
+    int tablebits = 1;
+    while(((size_t)1 << tablebits) < oldhashes.size() * 2)
+        tablebits++;
+    auto slot = [tablebits](uint64_t hash) { return (hash * 0x9E3779B97F4A7C15ULL) >> (64 - tablebits); };
+
+    std::vector<int> head((size_t)1 << tablebits, -1);
+    std::vector<int> next(oldhashes.size());
+    for(size_t i = oldhashes.size(); i-- > 0;) {
+        next[i] = head[slot(oldhashes[i])];
+        head[slot(oldhashes[i])] = i;
     }
 
-    //Eliminate overlaps
-    size_t index = 0;
-    while(index < commonblocks.size()) {
-            
-        //Potential overlap as long as the other block's begin is before this block's end
-        int oldendloc = commonblocks[index]->oldendloc();
-        for(auto overlapchecker = commonblocks.begin() + index + 1; overlapchecker != commonblocks.end() && (*overlapchecker)->oldloc <= oldendloc; overlapchecker++) {
-            if(isdeleted[overlapchecker - commonblocks.begin()])
+    std::vector<uint64_t> newhashes = windowHashes(newbegin, se.getNewEnd(), minsize);
+    for(size_t newloc = 0; newloc < newhashes.size(); ++newloc) {
+        for(int oldloc = head[slot(newhashes[newloc])]; oldloc >= 0; oldloc = next[oldloc]) {
+            if(oldhashes[oldloc] != newhashes[newloc])
                 continue;
-            
-            if(isOverlap((*overlapchecker)->oldloc, (*overlapchecker)->newloc, (*overlapchecker)->len,
-                commonblocks[index]->oldloc, commonblocks[index]->newloc, commonblocks[index]->len))
-            {
-                isdeleted[overlapchecker - commonblocks.begin()] = 1;
-            }
+            //The window is part of the block starting at the previous token, which is found on its own
+            if(oldloc > 0 && newloc > 0 && *(oldbegin + oldloc - 1) == *(newbegin + newloc - 1))
+                continue;
+            //Double-check equality
+            if(!std::equal(oldbegin + oldloc, oldbegin + oldloc + minsize, newbegin + newloc))
+                continue;
+
+            Block block(oldloc, newloc, minsize);
+            extendBlock(block, se);
+            commonblocks.push_back(block);
         }
-        
-        do {
-            index++;
-        } while(index < commonblocks.size() && isdeleted[index]);
     }
 
-    //Copy over valid blocks
-    std::vector<std::shared_ptr<Block>> newblocks;
-    for(size_t i = 0; i < commonblocks.size(); i++) {
-        if(!isdeleted[i])
-            newblocks.push_back(commonblocks[i]);
+    std::sort(commonblocks.begin(), commonblocks.end(), compareStrict);
+    removeOverlapped(commonblocks);
+    return commonblocks;
+}
+
+void extendBlocks(std::vector<Block>& commonblocks, StringEncoder& se) {
+    if(commonblocks.size() <= 1)
+        return;
+
+    std::sort(commonblocks.begin(), commonblocks.end(), compareStrict);
+
+    //Extend every block
+    for(auto iter = commonblocks.begin(); iter != commonblocks.end(); iter++) {
+        extendBlock(*iter, se);
     }
 
-    commonblocks.swap(newblocks);
+    removeOverlapped(commonblocks);
 }
 
 //Resolve blocks that are intersecting
 //Should be run after extendBlocks
-void resolveIntersections(std::vector<std::shared_ptr<Block>>& allblocks) {
+void resolveIntersections(std::vector<Block>& allblocks) {
     //List of blocks to add to the main list later
     //NOTE: It is impossible for blocks generated from intersection resolution to
     //be a duplicate from an original block in allblocks.
     //Consider a b c d e, a b c f c d e. "a b" would be generated from intersection resolution,
     //but it is impossible for that block to be generated normally since it is possible to extend that block,
     //so the extended version would be added, which is a b c.
-    std::vector<std::shared_ptr<Block>> addedblocks;
+    std::vector<Block> addedblocks;
     //First, sort based on old locations
     std::sort(allblocks.begin(), allblocks.end(), compareOld);
     
     for(size_t i = 0; i < allblocks.size(); i++) {
         for(size_t j = i+1; j < allblocks.size(); j++) {
             //break if intersections are not possible anymore
-            if(allblocks[j]->oldloc > allblocks[i]->oldendloc())
+            if(allblocks[j].oldloc > allblocks[i].oldendloc())
                 break;
             
             //Intersection occurs if B.end > A.end >= B.begin > A.begin
             //We know that B.begin > A.begin (iterating in sorted order)
             //We know that A.end >= B.begin (is our breaking condition)
             //Thus we only need to check B.end > A.end
-            if(allblocks[j]->oldendloc() > allblocks[i]->oldendloc()) {
+            if(allblocks[j].oldendloc() > allblocks[i].oldendloc()) {
                 //calculate how much the current block needs to shrink by
-                int shrunksize = allblocks[j]->oldloc - allblocks[i]->oldloc;
+                int shrunksize = allblocks[j].oldloc - allblocks[i].oldloc;
                 //No point adding zero-length blocks
                 if(shrunksize > 0) {
-                    addedblocks.push_back(std::make_shared<Block>(
-                        allblocks[i]->oldloc,
-                        allblocks[i]->newloc,
+                    addedblocks.emplace_back(
+                        allblocks[i].oldloc,
+                        allblocks[i].newloc,
                         shrunksize
-                    ));
+                    );
                 }
             }
         }
@@ -176,17 +253,17 @@ void resolveIntersections(std::vector<std::shared_ptr<Block>>& allblocks) {
     
     for(size_t i = 0; i < allblocks.size(); i++) {
         for(size_t j = i+1; j < allblocks.size(); j++) {
-            if(allblocks[j]->newloc > allblocks[i]->newendloc())
+            if(allblocks[j].newloc > allblocks[i].newendloc())
                 break;
             
-            if(allblocks[j]->newendloc() > allblocks[i]->newendloc()) {
-                int shrunksize = allblocks[j]->newloc - allblocks[i]->newloc;
+            if(allblocks[j].newendloc() > allblocks[i].newendloc()) {
+                int shrunksize = allblocks[j].newloc - allblocks[i].newloc;
                 if(shrunksize > 0) {
-                    addedblocks.push_back(std::make_shared<Block>(
-                        allblocks[i]->oldloc,
-                        allblocks[i]->newloc,
+                    addedblocks.emplace_back(
+                        allblocks[i].oldloc,
+                        allblocks[i].newloc,
                         shrunksize
-                    ));
+                    );
                 }
             }
         }
@@ -9,11 +9,16 @@
 
 //Gets all possible common blocks of text of size minsize. Extends blocks where necessary
 //Blocks can be overlapping; this is fixed with the other two functions
-std::vector<std::shared_ptr<Block>> getCommonBlocks(int minsize, StringEncoder& se);
+std::vector<Block> getCommonBlocks(int minsize, StringEncoder& se);
+//Gets the same blocks as getCommonBlocks followed by extendBlocks, without generating every window of minsize
+//Windows are found with a rolling hash, and only the window starting each run of common text is kept and extended
+std::vector<Block> getMaximalBlocks(int minsize, StringEncoder& se);
+//Extends a block for as long as the text following it is common to both versions
+void extendBlock(Block& block, StringEncoder& se);
 //Extends common blocks, and removes blocks that are overlapped by the extended block
-void extendBlocks(std::vector<std::shared_ptr<Block>>& allblocks, StringEncoder& se);
+void extendBlocks(std::vector<Block>& allblocks, StringEncoder& se);
 //Resolves blocks that may be only partially overlapping
 //This is done by adding extra blocks that represent the overlaps
-void resolveIntersections(std::vector<std::shared_ptr<Block>>& allblocks);
+void resolveIntersections(std::vector<Block>& allblocks);
 
 #endif
\ No newline at end of file
@@ -1,89 +1,170 @@
 #include "distancetable.h"
 
 #include <algorithm>
+#include <numeric>
 #include <iostream>
 
 using namespace std;
 
-//Assumes that commonblocks is already sorted by old position
-vector<shared_ptr<Block>> getAdjacencyList(vector<shared_ptr<Block>>& commonblocks, size_t index) {
-    vector<shared_ptr<Block>> adjacencylist;
+const int DistanceTable::NONE;
 
-    shared_ptr<Block>& source = commonblocks[index];
-    
-    //All potential neighbors will be strictly after the current block
-    for(auto neighborindex = index+1; neighborindex < commonblocks.size(); neighborindex++) {
-        shared_ptr<Block>& neighbor = commonblocks[neighborindex];
-        if(neighbor->oldloc > source->oldendloc() && neighbor->newloc > source->newendloc())
-            adjacencylist.push_back(neighbor);
+//Fenwick tree over new end locations that answers "best distance among blocks ending before this location"
+class PrefixMaxTree {
+public:
+    PrefixMaxTree(size_t size) : distances(size + 1, -1), blocks(size + 1, DistanceTable::NONE) {}
+
+    void clear() {
+        fill(distances.begin(), distances.end(), -1);
+        fill(blocks.begin(), blocks.end(), DistanceTable::NONE);
     }
 
-    return adjacencylist;
-}
+    //Offers block, with a path of the given distance ending at it, at rank
+    void update(size_t rank, int distance, int block) {
+        for(size_t i = rank + 1; i < distances.size(); i += i & (~i + 1)) {
+            if(distance > distances[i]) {
+                distances[i] = distance;
+                blocks[i] = block;
+            }
+        }
+    }
 
-DistanceTable::DistanceTable(int blocklimit, vector<shared_ptr<Block>> commonblocks) : maxsteps(blocklimit) {
-    //Initialize all vertices in graph
-    for(shared_ptr<Block>& vertex : commonblocks) {
-        this->initVertex(vertex);
+    //Best block among ranks below limit, NONE if there is none
+    int query(size_t limit, int& distance) const {
+        int best = DistanceTable::NONE;
+        distance = -1;
+        for(size_t i = limit; i > 0; i -= i & (~i + 1)) {
+            if(distances[i] > distance) {
+                distance = distances[i];
+                best = blocks[i];
+            }
+        }
+        return best;
     }
 
-    sort(commonblocks.begin(), commonblocks.end(), compareOld);
-    
-    //Fill out the dist list for each vertex
-    size_t index = 0;
-    for(shared_ptr<Block>& vertex : commonblocks) {
-        vector<shared_ptr<Block>> adjacencylist = getAdjacencyList(commonblocks, index);
-        for(shared_ptr<Block>& neighbor : adjacencylist) {
-            this->mergeIntoNext(vertex, neighbor);
+private:
+    std::vector<int> distances;
+    std::vector<int> blocks;
+};
+
+DistanceTable::DistanceTable(int blocklimit, vector<Block> commonblocks) : blocks(move(commonblocks)), maxsteps(blocklimit) {
+    //A strict order makes ties between paths of equal length independent of the order blocks were found in
+    sort(blocks.begin(), blocks.end(), compareStrict);
+    size_t count = blocks.size();
+
+    //Blocks in the order they end in the old file. A block can precede every block starting after it ends
+    vector<int> byoldend(count);
+    iota(byoldend.begin(), byoldend.end(), 0);
+    sort(byoldend.begin(), byoldend.end(), [this](int lhs, int rhs) {
+        return blocks[lhs].oldendloc() < blocks[rhs].oldendloc();
+    });
+
+    //Rank of each block's end in the new file
+    vector<int> newends(count);
+    for(size_t v = 0; v < count; v++)
+        newends[v] = blocks[v].newendloc();
+    sort(newends.begin(), newends.end());
+    newends.erase(unique(newends.begin(), newends.end()), newends.end());
+    vector<size_t> newendrank(count);
+    for(size_t v = 0; v < count; v++)
+        newendrank[v] = lower_bound(newends.begin(), newends.end(), blocks[v].newendloc()) - newends.begin();
+
+    //Any block can be reached in one step from S
+    vector<int> distances(count);
+    for(size_t v = 0; v < count; v++)
+        distances[v] = blocks[v].len;
+    vector<int> predecessors(count, NONE);
+    if(!addStep(distances, predecessors))
+        return;
+
+    PrefixMaxTree tree(newends.size());
+    vector<int> nextdistances(count);
+    while(bestlist.size() < maxsteps) {
+        tree.clear();
+        predecessors.assign(count, NONE);
+
+        size_t inserted = 0;
+        for(size_t v = 0; v < count; v++) {
+            while(inserted < count && blocks[byoldend[inserted]].oldendloc() < blocks[v].oldloc) {
+                int u = byoldend[inserted++];
+                if(distances[u] >= 0)
+                    tree.update(newendrank[u], distances[u], u);
+            }
+
+            //Blocks ending before v in the new file
+            size_t limit = lower_bound(newends.begin(), newends.end(), blocks[v].newloc) - newends.begin();
+            int distance;
+            predecessors[v] = tree.query(limit, distance);
+            nextdistances[v] = (predecessors[v] == NONE) ? -1 : distance + (int)blocks[v].len;
         }
-        index++;
+
+        distances.swap(nextdistances);
+        if(!addStep(distances, predecessors))
+            break;
     }
 }
 
-DistanceTable::DistanceTable(int blocklimit, BlockGraph& graph, vector<shared_ptr<Block>>& toporder) : maxsteps(blocklimit) {
-    //Initialize all vertices in graph
-    //Since order doesn't matter, use toporder
-    for(shared_ptr<Block> vertex : toporder) {
-        this->initVertex(vertex);
-    }
-    
-    //Fill out the dist list for each vertex
-    for(shared_ptr<Block> vertex : toporder) {
-        vector<shared_ptr<Block>> adjacencylist = graph.getAdjacencyList(vertex);
-        for(shared_ptr<Block> neighbor : adjacencylist) {
-            this->mergeIntoNext(vertex, neighbor);
+DistanceTable::DistanceTable(int blocklimit, const BlockGraph& graph, const vector<size_t>& toporder)
+    : blocks(graph.getAllVertices()), maxsteps(blocklimit)
+{
+    size_t count = blocks.size();
+
+    vector<int> distances(count);
+    for(size_t v = 0; v < count; v++)
+        distances[v] = blocks[v].len;
+    vector<int> predecessors(count, NONE);
+    if(!addStep(distances, predecessors))
+        return;
+
+    vector<int> nextdistances(count);
+    while(bestlist.size() < maxsteps) {
+        fill(nextdistances.begin(), nextdistances.end(), -1);
+        predecessors.assign(count, NONE);
+
+        for(size_t vertex : toporder) {
+            if(distances[vertex] < 0)
+                continue;
+            for(size_t neighbor : graph.getAdjacencyList(vertex)) {
+                if(distances[vertex] + (int)blocks[neighbor].len > nextdistances[neighbor]) {
+                    nextdistances[neighbor] = distances[vertex] + blocks[neighbor].len;
+                    predecessors[neighbor] = vertex;
+                }
+            }
         }
+
+        distances.swap(nextdistances);
+        if(!addStep(distances, predecessors))
+            break;
     }
 }
 
-vector<DistanceTable::TableEntry> DistanceTable::findAllBestPaths() {
-    //Initialize our vector to fit the results
-    //The actual list may be shorter than maxsteps if that graph can be traversed using
-    //less than "maxsteps" hops
-    vector<DistanceTable::TableEntry> bestlist;
-    bestlist.resize(maxsteps, DistanceTable::TableEntry(-1, -1, nullptr, nullptr));
-    
+bool DistanceTable::addStep(const vector<int>& distances, vector<int>& predecessors) {
+    if(maxsteps == 0)
+        return false;
+
     //find the longest distance
-    for(auto iter = tablelist.begin(); iter != tablelist.end(); iter++) {
-        vector<DistanceTable::TableEntry> testtable = iter->second;
-        for(size_t i = 0; i < testtable.size(); i++) {;
-            if(testtable[i].distance > bestlist[i].distance) {
-                bestlist[i] = testtable[i];
-            }
-        }
+    TableEntry best(-1, -1, NONE, NONE);
+    for(size_t v = 0; v < distances.size(); v++) {
+        if(distances[v] > best.distance)
+            best = TableEntry(bestlist.size() + 1, distances[v], v, predecessors[v]);
     }
-    
-    //Trim any null pairs remaining, but don't trim if the list is empty
-    while(bestlist.back().current == nullptr && bestlist.size() > 0)
-        bestlist.pop_back();
-    
+    if(best.current == NONE)
+        return false;
+
+    bestlist.push_back(best);
+    predecessorlist.emplace_back();
+    predecessorlist.back().swap(predecessors);
+    return true;
+}
+
+const vector<DistanceTable::TableEntry>& DistanceTable::findAllBestPaths() const {
+    //The list may be shorter than maxsteps if that graph can be traversed using less than "maxsteps" hops
     return bestlist;
 }
 
-vector<shared_ptr<Block>> DistanceTable::findOptimalPath(int a) {
-    vector<DistanceTable::TableEntry> bestlist = findAllBestPaths();
+vector<Block> DistanceTable::findOptimalPath(int a) {
+    const vector<DistanceTable::TableEntry>& bestlist = findAllBestPaths();
     //int refers to steps, not weight
-    DistanceTable::TableEntry bestending(-1, -1, nullptr, nullptr);
+    DistanceTable::TableEntry bestending(-1, -1, NONE, NONE);
     
     int prevtotalweight = 0;
     for(size_t i = 0; i < bestlist.size(); ++i) {
@@ -102,70 +183,23 @@ vector<shared_ptr<Block>> DistanceTable::findOptimalPath(int a) {
         prevtotalweight = curtotalweight;
     }
     
-    if(bestending.current == nullptr && !bestlist.empty())
+    if(bestending.current == NONE && !bestlist.empty())
         bestending = bestlist.back();
     
     return tracePath(bestending);
 }
 
-vector<shared_ptr<Block>> DistanceTable::tracePath(DistanceTable::TableEntry ending) {
-    vector<shared_ptr<Block>> path;
-    if(ending.current == nullptr)
-        return path;
-    
-    path.push_back(ending.current);
-    DistanceTable::TableEntry candidate = ending;
+vector<Block> DistanceTable::tracePath(DistanceTable::TableEntry ending) {
+    vector<Block> path;
     
-    while(candidate.prev != nullptr) {
-        path.push_back(candidate.prev);
-        candidate = getPreviousEntry(candidate);
+    //subtract one to offset step/index difference
+    int step = ending.steps - 1;
+    for(int current = ending.current; current != NONE && step >= 0; step--) {
+        path.push_back(blocks[current]);
+        current = predecessorlist[step][current];
     }
     
     reverse(path.begin(), path.end());
     
     return path;
-}
-
-void DistanceTable::mergeIntoNext(shared_ptr<Block> prev, shared_ptr<Block> next) {
-    int weight = next->len;
-
-    auto& prevblock = tablelist.find(prev)->second;
-    auto& nextblock = tablelist.find(next)->second;
-    
-    //If neighbor's distlist is not large enough for comparing, resize it
-    if(nextblock.size() < prevblock.size()+1)
-        nextblock.resize(prevblock.size()+1, DistanceTable::TableEntry(-1, -1, nullptr, nullptr));
-
-    //Compare each entry in prev to the entry in next+1
-    for(size_t i = 0; i < prevblock.size(); i++) {
-        if(prevblock[i].current == nullptr)
-            continue;
-        
-        if(prevblock[i].distance + weight > nextblock[i+1].distance) {
-            nextblock[i+1].steps = prevblock[i].steps + 1;
-            nextblock[i+1].distance = prevblock[i].distance + weight;
-            nextblock[i+1].current = next;
-            nextblock[i+1].prev = prev;
-        }
-    }
-
-    //If the table exceeds the number of steps, remove the extra entry
-    if(nextblock.size() > maxsteps)
-        nextblock.pop_back();
-}
-
-DistanceTable::TableEntry DistanceTable::getPreviousEntry(DistanceTable::TableEntry te) {
-    if(te.steps < 2)
-        return DistanceTable::TableEntry(-1, -1, nullptr, nullptr);
-    //subtract one to offset step/index difference, subtract another one to get previous step
-    return tablelist[te.prev][te.steps-2];
-}
-
-void DistanceTable::initVertex(shared_ptr<Block> V) {
-    if(tablelist.find(V) == tablelist.end()) {
-        vector<DistanceTable::TableEntry> tableinit;
-        tableinit.push_back(DistanceTable::TableEntry(1, V->len, V, nullptr));
-        //Assume that an invalid block in prev refers to the source node
-        tablelist[V] = tableinit;
-    }
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #ifndef DISTANCETABLE_H
 #define DISTANCETABLE_H
 
-#include <unordered_map>
 #include <vector>
 
 #include "graph.h"
@@ -10,20 +9,29 @@
 //Table that holds distance info when traversing a graph
 //**All references to steps are assuming starting from some source node S that connects to all other nodes
 //Thus a step=0 is impossible
+//Blocks are referred to by their index in the list of blocks the table was built from
+//The table is filled one step at a time: the best path of s+1 steps to a block extends the best path of s steps to
+//one of its predecessors, so only the previous step's distances are kept, along with every step's predecessors
 class DistanceTable {
 public:
+    //Index of the source node S, or of no block
+    static const int NONE = -1;
+
     struct TableEntry {
-        TableEntry(int s, int d, std::shared_ptr<Block> c, std::shared_ptr<Block> p)
+        TableEntry(int s, int d, int c, int p)
         : steps(s), distance(d), current(c), prev(p) {}
         
         int steps;
         int distance;
-        std::shared_ptr<Block> current;
-        std::shared_ptr<Block> prev;
+        int current;
+        int prev;
     };
     
-    DistanceTable(int blocklimit, std::vector<std::shared_ptr<Block>> commonblocks);
-    DistanceTable(int blocklimit, BlockGraph& graph, std::vector<std::shared_ptr<Block>>& toporder);
+    //Finds predecessors without building the graph: blocks are swept in old order, and the best path ending before
+    //each block is found with a prefix maximum over new end locations. O(maxsteps * B log B) for B blocks
+    DistanceTable(int blocklimit, std::vector<Block> commonblocks);
+    //Relaxes every edge of the graph once per step. O(maxsteps * E)
+    DistanceTable(int blocklimit, const BlockGraph& graph, const std::vector<size_t>& toporder);
     
     
     //Finds an optimal path through the graph that balances block count vs common text
@@ -32,32 +40,28 @@ public:
     //Thus a represents the cost of taking one block of text
     //NOTE: this pair represents <steps, block> instead of <weight, block>
     //weight can be obtained elsewhere
-    std::vector<std::shared_ptr<Block>> findOptimalPath(int a);
+    std::vector<Block> findOptimalPath(int a);
     
     //Fills a vector with a path that ends at ending
     //path is in order of graph traversal
     //ending is included in the path as the last entry
-    std::vector<std::shared_ptr<Block>> tracePath(TableEntry ending);
+    std::vector<Block> tracePath(TableEntry ending);
     
 private:
-    //Initialize a vertex in the table
-    //The vertex gets one entry in its distance list; (V.weight, nullptr)
-    //This is because we can access any vertex in the graph in one step
-    void initVertex(std::shared_ptr<Block> V);
-    //Merge the list from prev into the list of next, where next is a neighbor of prev
-    void mergeIntoNext(std::shared_ptr<Block> prev, std::shared_ptr<Block> next);
-    //Gets the previous table entry given a current table entry
-    TableEntry getPreviousEntry(TableEntry te);
+    //Records the best path of the given step, and keeps its predecessors for tracing paths
+    //Returns false if no path takes that many steps
+    bool addStep(const std::vector<int>& distances, std::vector<int>& predecessors);
     //Gets a list of every best path in the graph
     //index of vector refers to number of steps through graph (see assumption below)
     //Each entry is a pair of totalweight, endingblock.
-    std::vector<TableEntry> findAllBestPaths();
+    const std::vector<TableEntry>& findAllBestPaths() const;
     
-    //Each block is associated with a table describing its distance from S
-    //Each table is a list of distance and previous_block pairs, with the position
-    //in the vector denoting the number of hops it takes from S.
+    std::vector<Block> blocks;
+    //For each step, the block before each block on the best path of that many steps ending at it
     //**We assume that index=0 means 1 hop from S
-    std::unordered_map<std::shared_ptr<Block>, std::vector<TableEntry>> tablelist;
+    std::vector<std::vector<int>> predecessorlist;
+    //Best path of each step
+    std::vector<TableEntry> bestlist;
     //The maximum number of steps we're allowed to take through the graph
     size_t maxsteps;
 };
@@ -5,38 +5,39 @@
 
 using namespace std;
 
-BlockGraph::BlockGraph(vector<shared_ptr<Block>>& commonblocks) {
+BlockGraph::BlockGraph(vector<Block>& commonblocks) {
     //Sort based on old locations
     sort(commonblocks.begin(), commonblocks.end(), compareOld);
 
     //Create adjacency list for every block
-    for(auto iter = commonblocks.begin(); iter != commonblocks.end(); iter++) {
-        auto insertediter = G.emplace(make_pair(*iter, vector<shared_ptr<Block>>{})).first;
+    G.resize(commonblocks.size());
+    for(size_t index = 0; index < commonblocks.size(); index++) {
+        const Block& source = commonblocks[index];
         
         //All potential neighbors will be strictly after the current block
-        for(auto neighboriter = iter+1; neighboriter != commonblocks.end(); neighboriter++) {
-            if((*neighboriter)->oldloc > (*iter)->oldendloc() && (*neighboriter)->newloc > (*iter)->newendloc())
-                insertediter->second.push_back(*neighboriter);
+        for(size_t neighbor = index+1; neighbor < commonblocks.size(); neighbor++) {
+            if(commonblocks[neighbor].oldloc > source.oldendloc() && commonblocks[neighbor].newloc > source.newendloc())
+                G[index].push_back(neighbor);
         }
     }
     
     vertices = commonblocks;
 }
 
-const vector<shared_ptr<Block>>& BlockGraph::getAdjacencyList(shared_ptr<Block> V) {
+const vector<size_t>& BlockGraph::getAdjacencyList(size_t V) const {
     return G[V];
 }
 
-const vector<shared_ptr<Block>>& BlockGraph::getAllVertices() const {
+const vector<Block>& BlockGraph::getAllVertices() const {
     return vertices;
 }
 
 //Create a topological ordering of graph via DFS
-vector<shared_ptr<Block>> topologicalSort(BlockGraph& graph) {
-    vector<shared_ptr<Block>> toporder;
-    unordered_set<shared_ptr<Block>> visited;
-    const vector<shared_ptr<Block>> vertices = graph.getAllVertices();
-    for(shared_ptr<Block> i : vertices)
+vector<size_t> topologicalSort(const BlockGraph& graph) {
+    vector<size_t> toporder;
+    //Can't use bools since vector<bool> is special
+    vector<char> visited(graph.getAllVertices().size());
+    for(size_t i = 0; i < visited.size(); i++)
         explore(graph, i, visited, toporder);
     
     reverse(toporder.begin(), toporder.end());
@@ -44,15 +45,14 @@ vector<shared_ptr<Block>> topologicalSort(BlockGraph& graph) {
 }
 
 //Helper function for topologicalSort, explores all vertices connected to current
-void explore(BlockGraph& graph, shared_ptr<Block> current, unordered_set<shared_ptr<Block>>& visited, vector<shared_ptr<Block>>& toporder) {
+void explore(const BlockGraph& graph, size_t current, vector<char>& visited, vector<size_t>& toporder) {
     //do not explore if already visited
-    if(visited.find(current) != visited.end())
+    if(visited[current])
         return;
-    visited.insert(current);
-    vector<shared_ptr<Block>> adjacent = graph.getAdjacencyList(current);
-    for(shared_ptr<Block> i : adjacent) {
+    visited[current] = 1;
+    for(size_t i : graph.getAdjacencyList(current)) {
         //Not visited yet
-        if(visited.find(i) == visited.end())
+        if(!visited[i])
             explore(graph, i, visited, toporder);
     }
     toporder.push_back(current);
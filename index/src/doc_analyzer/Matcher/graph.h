@@ -1,36 +1,35 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
-#include <unordered_map>
 #include <vector>
-#include <unordered_set>
 
 #include "block.h"
 
 //A graph of text blocks
+//Vertices are referred to by their index in getAllVertices
 class BlockGraph {
 public:
     //Initializes the graph with a vector of blocks
-    BlockGraph(std::vector<std::shared_ptr<Block>>& commonblocks);
+    //Sorts commonblocks by old location; vertex indexes follow that order
+    BlockGraph(std::vector<Block>& commonblocks);
     
     //Get the adjacency list associated with V
     //* Assumes that V is a valid vertice inside of the graph *
-    const std::vector<std::shared_ptr<Block>>& getAdjacencyList(std::shared_ptr<Block> V);
+    const std::vector<size_t>& getAdjacencyList(size_t V) const;
     
-    //Gets the list of all vertices that appear in the graph
-    const std::vector<std::shared_ptr<Block>>& getAllVertices() const;
+    //Gets the list of all vertices that appear in the graph, sorted by old location
+    const std::vector<Block>& getAllVertices() const;
     
 private:
     //Each Block is associated with an adjacency list of neighboring vertices
     //Edge weights aren't required since weights are defined in each vertex
-    std::unordered_map<std::shared_ptr<Block>, std::vector<std::shared_ptr<Block>>> G;
+    std::vector<std::vector<size_t>> G;
     
     //List of all vertices that appear in the graph
-    //Not guaranteed to be sorted in any way
-    std::vector<std::shared_ptr<Block>> vertices;
+    std::vector<Block> vertices;
 };
 
-std::vector<std::shared_ptr<Block>> topologicalSort(BlockGraph& graph);
-void explore(BlockGraph& graph, std::shared_ptr<Block> current, std::unordered_set<std::shared_ptr<Block>>& visited, std::vector<std::shared_ptr<Block>>& toporder);
+std::vector<size_t> topologicalSort(const BlockGraph& graph);
+void explore(const BlockGraph& graph, size_t current, std::vector<char>& visited, std::vector<size_t>& toporder);
 
 #endif
\ No newline at end of file
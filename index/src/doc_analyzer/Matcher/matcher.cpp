@@ -2,31 +2,23 @@
 
 #include <algorithm>
 #include <iostream>
+#include <utility>
 
 #include "distancetable.h"
 #include "blockmatching.hpp"
 
 using namespace std;
 
-//Using pointers for now to avoid having to write a hash function for a block (used to be due to memory constraints)
-vector<std::shared_ptr<Block>> getOptimalBlocks(StringEncoder& se, int minblocksize, int maxblockcount, int selectionparameter) {
-    //Find common blocks between the two files
-    vector<shared_ptr<Block>> commonblocks = getCommonBlocks(minblocksize, se);
-    extendBlocks(commonblocks, se);
-    resolveIntersections(commonblocks);
-
+//Selects the optimal set among the common blocks
+static vector<Block> selectBlocks(vector<Block>& commonblocks, int maxblockcount, int selectionparameter) {
     cout << "Got " << commonblocks.size() << " blocks" << endl;
-    if(commonblocks.size() > 100000) {
-        sort(commonblocks.begin(), commonblocks.end(), compareSizeGreater);
-        commonblocks.resize(2000);
-    }
 
     //Create a graph of the common blocks
     // BlockGraph G(commonblocks);
-    // vector<shared_ptr<Block>> topsort = topologicalSort(G);
+    // vector<size_t> topsort = topologicalSort(G);
 
     // size_t sum = 0;
-    // for(shared_ptr<Block>& b : commonblocks) {
+    // for(size_t b = 0; b < commonblocks.size(); ++b) {
     //     sum += G.getAdjacencyList(b).size();
     // }
 
@@ -35,22 +27,137 @@ vector<std::shared_ptr<Block>> getOptimalBlocks(StringEncoder& se, int minblocks
     //Get the optimal set of blocks to select
     // DistanceTable disttable(maxblockcount, G, topsort);
     DistanceTable disttable(maxblockcount, commonblocks);
-    vector<shared_ptr<Block>> finalpath = disttable.findOptimalPath(selectionparameter);
+    vector<Block> finalpath = disttable.findOptimalPath(selectionparameter);
 
     cout << "Selected " << finalpath.size() << " blocks" << endl;
 
     return finalpath;
 }
 
+vector<Block> getOptimalBlocks(StringEncoder& se, int minblocksize, int maxblockcount, int selectionparameter) {
+    //Find common blocks between the two files
+    vector<Block> commonblocks = getMaximalBlocks(minblocksize, se);
+    resolveIntersections(commonblocks);
+
+    return selectBlocks(commonblocks, maxblockcount, selectionparameter);
+}
+
+//Whether every window of minsize terms in one version that overlaps the common run [runbegin, runend) is only found
+//in the other version on the diagonal of the run, which is shift terms further. Otherwise the window starts a block
+//that competes with the run. A window is pinned to the diagonal when the part of it in the run holds a term found once
+//in the other version. The other windows are only looked for where the other version holds their rarest term
+static bool isOnDiagonal(StringEncoder& se, bool fromold, int runbegin, int runend, int shift, int minsize) {
+    auto from = fromold ? se.getOldIter() : se.getNewIter();
+    auto to = fromold ? se.getNewIter() : se.getOldIter();
+    int fromsize = fromold ? se.getOldSize() : se.getNewSize();
+    int tosize = fromold ? se.getNewSize() : se.getOldSize();
+
+    auto count = [&](int loc) { return fromold ? se.getNewCount(from[loc]) : se.getOldCount(from[loc]); };
+    //Window starts with the location of the rarest term of their part in the run
+    //Both ends of the part only move forward, so the last pinning term before its end is kept as it moves
+    vector<pair<int, int>> unpinned;
+    int added = runbegin;
+    int lastpinned = -1;
+    for(int start = max(0, runbegin - minsize + 1); start <= min(runend - 1, fromsize - minsize); ++start) {
+        int begin = max(start, runbegin);
+        int end = min(start + minsize, runend);
+        for(; added < end; ++added) {
+            if(count(added) == 1)
+                lastpinned = added;
+        }
+        if(lastpinned >= begin)
+            continue;
+
+        int rarest = begin;
+        for(int loc = begin + 1; loc < end; ++loc) {
+            if(count(loc) < count(rarest))
+                rarest = loc;
+        }
+        unpinned.emplace_back(start, rarest);
+    }
+    if(unpinned.empty())
+        return true;
+
+    vector<char> wanted(se.getTermCount(), false);
+    for(const pair<int, int>& window : unpinned)
+        wanted[from[window.second]] = true;
+    vector<pair<int, int>> occurrences;
+    for(int loc = 0; loc < tosize; ++loc) {
+        if(wanted[to[loc]])
+            occurrences.emplace_back(to[loc], loc);
+    }
+    sort(occurrences.begin(), occurrences.end());
+
+    //Text repeated all over the document is left to the full matching rather than searched at every repeat
+    long budget = tosize;
+    for(const pair<int, int>& window : unpinned) {
+        int offset = window.second - window.first;
+        auto iter = lower_bound(occurrences.begin(), occurrences.end(), make_pair(from[window.second], 0));
+        for(; iter != occurrences.end() && iter->first == from[window.second]; ++iter) {
+            if(--budget < 0)
+                return false;
+            int loc = iter->second - offset;
+            if(loc != window.first + shift && loc >= 0 && loc + minsize <= tosize &&
+                    equal(to + loc, to + loc + minsize, from + window.first))
+                return false;
+        }
+    }
+    return true;
+}
+
+//Whether no common block other than the run itself overlaps the common run in either version
+static bool isIsolated(StringEncoder& se, int oldloc, int newloc, int len, int minsize) {
+    return isOnDiagonal(se, true, oldloc, oldloc + len, newloc - oldloc, minsize) &&
+        isOnDiagonal(se, false, newloc, newloc + len, oldloc - newloc, minsize);
+}
+
+vector<Block> getTrimmedBlocks(StringEncoder& se, int minblocksize, int maxblockcount, int selectionparameter) {
+    int oldsize = se.getOldSize();
+    int newsize = se.getNewSize();
+    int shorter = min(oldsize, newsize);
+
+    //Common text shorter than a block is left to the middle, as is common text that also matches elsewhere
+    //An isolated prefix or suffix is a common block that no other block intersects, so the blocks of the middle
+    //together with it are exactly the blocks the full matching would find
+    int prefix = mismatch(se.getOldIter(), se.getOldIter() + shorter, se.getNewIter()).first - se.getOldIter();
+    if(prefix < minblocksize || !isIsolated(se, 0, 0, prefix, minblocksize))
+        prefix = 0;
+
+    //The suffix may not overlap the prefix
+    auto oldreverse = vector<int>::const_reverse_iterator(se.getOldEnd());
+    auto newreverse = vector<int>::const_reverse_iterator(se.getNewEnd());
+    int suffix = mismatch(oldreverse, oldreverse + (shorter - prefix), newreverse).first - oldreverse;
+    if(suffix < minblocksize || !isIsolated(se, oldsize - suffix, newsize - suffix, suffix, minblocksize))
+        suffix = 0;
+
+    vector<Block> commonblocks;
+    if(prefix + suffix < oldsize && prefix + suffix < newsize) {
+        StringEncoder middle = se.getMiddle(prefix, suffix);
+        commonblocks = getMaximalBlocks(minblocksize, middle);
+        resolveIntersections(commonblocks);
+        for(Block& block : commonblocks) {
+            block.oldloc += prefix;
+            block.newloc += prefix;
+        }
+    }
+    if(prefix > 0)
+        commonblocks.emplace_back(0, 0, prefix);
+    if(suffix > 0)
+        commonblocks.emplace_back(oldsize - suffix, newsize - suffix, suffix);
+
+    //The selection is over the same blocks as the full matching, so it selects the same ones
+    return selectBlocks(commonblocks, maxblockcount, selectionparameter);
+}
+
 //Helper functions to make block traversal more clean
 bool skipBlock(int beginloc, size_t blocklength, int& index, size_t& blockindex);
 
-pair<unordered_map<string, ExternNPposting>, vector<ExternPposting>>
-getPostings(vector<std::shared_ptr<Block>>& commonblocks, unsigned int doc_id, unsigned int &fragID, StringEncoder& se) {
+PostingBatch getPostings(vector<Block>& commonblocks, unsigned int doc_id, unsigned int &fragID, StringEncoder& se) {
     //Which block to skip next
     size_t blockindex = 0;
-    unordered_map<string, ExternNPposting> nppostingsmap;
-    vector<ExternPposting> ppostingslist;
+    PostingBatch postings(doc_id);
+    //Terms are identified by their codes, so no term is decoded
+    vector<bool> indexed(se.getTermCount(), false);
 
     //Sort blocks based on oldindex first
     sort(commonblocks.begin(), commonblocks.end(), compareOld);
@@ -58,21 +165,21 @@ getPostings(vector<std::shared_ptr<Block>>& commonblocks, unsigned int doc_id, u
     //Skip common blocks if they begin at the start of the document
     int index = 0;
     while(blockindex < commonblocks.size() && 
-            skipBlock(commonblocks[blockindex]->oldloc, commonblocks[blockindex]->len, index, blockindex))
+            skipBlock(commonblocks[blockindex].oldloc, commonblocks[blockindex].len, index, blockindex))
             ;
     
     while(index < se.getOldSize()) {
-        string decodedword = se.decodeNum(*(se.getOldIter()+index));
+        int code = *(se.getOldIter()+index);
         //Word not yet indexed
-        if(nppostingsmap.find(decodedword) == nppostingsmap.end()) {
-            ExternNPposting newposting(decodedword, doc_id, se.getNewCount(decodedword));
-            nppostingsmap.emplace(make_pair(decodedword, ExternNPposting{decodedword, doc_id, se.getNewCount(decodedword)}));
+        if(!indexed[code]) {
+            indexed[code] = true;
+            postings.addNonPositional(code, se.getNewCount(code));
         }
 
         index++;
         //Condition prevents attempting to access an empty vector
         while(blockindex < commonblocks.size() && 
-            skipBlock(commonblocks[blockindex]->oldloc, commonblocks[blockindex]->len, index, blockindex))
+            skipBlock(commonblocks[blockindex].oldloc, commonblocks[blockindex].len, index, blockindex))
             ;
     }
 
@@ -81,32 +188,33 @@ getPostings(vector<std::shared_ptr<Block>>& commonblocks, unsigned int doc_id, u
     index = 0;
     blockindex = 0;
     while(blockindex < commonblocks.size() && 
-            skipBlock(commonblocks[blockindex]->newloc, commonblocks[blockindex]->len, index, blockindex))
+            skipBlock(commonblocks[blockindex].newloc, commonblocks[blockindex].len, index, blockindex))
             ;
     
     while(index < se.getNewSize()) {
         //Edited sections in new file are considered "inserted"
-        string decodedword = se.decodeNum(*(se.getNewIter()+index));
-        //Word not yet indexed in nonpositional map
-        if(nppostingsmap.find(decodedword) == nppostingsmap.end()) {
-            nppostingsmap.emplace(make_pair(decodedword, ExternNPposting{decodedword, doc_id, se.getNewCount(decodedword)}));
+        int code = *(se.getNewIter()+index);
+        //Word not yet indexed in nonpositional list
+        if(!indexed[code]) {
+            indexed[code] = true;
+            postings.addNonPositional(code, se.getNewCount(code));
         }
         //Always insert positional posting for a word
-        ppostingslist.emplace_back(decodedword, doc_id, fragID, index);
+        postings.addPositional(code, fragID, index);
 
         index++;
         if(blockindex < commonblocks.size()) {
-            bool skip = skipBlock(commonblocks[blockindex]->newloc, commonblocks[blockindex]->len, index, blockindex);
+            bool skip = skipBlock(commonblocks[blockindex].newloc, commonblocks[blockindex].len, index, blockindex);
             //When we skip a block of common text, we need a new fragID. Only need a new fragID once though, not per skip
             if(skip)
                 ++fragID;
             while(blockindex < commonblocks.size() &&
-                skipBlock(commonblocks[blockindex]->newloc, commonblocks[blockindex]->len, index, blockindex))
+                skipBlock(commonblocks[blockindex].newloc, commonblocks[blockindex].len, index, blockindex))
                 ;
         }
     }
 
-    return make_pair(nppostingsmap, ppostingslist);
+    return postings;
 }
 
 //Helper functions to make block traversal more clean
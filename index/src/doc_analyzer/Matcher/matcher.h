@@ -2,17 +2,20 @@
 #define MATCHER_H
 
 #include <vector>
-#include <memory>
 
 #include "doc_analyzer/externalpostings.h"
 #include "block.h"
 #include "stringencoder.h"
 
 //Gets the optimal set of common blocks of text between the two files
-std::vector<std::shared_ptr<Block>> getOptimalBlocks(StringEncoder& se, int minblocksize, int maxblockcount, int selectionparameter);
+std::vector<Block> getOptimalBlocks(StringEncoder& se, int minblocksize, int maxblockcount, int selectionparameter);
+//Same as getOptimalBlocks, but a common prefix and suffix of the two files that match nowhere else are taken as blocks
+//first, and only the text between them is searched for blocks. Most revisions of a document only change a few terms
+std::vector<Block> getTrimmedBlocks(StringEncoder& se, int minblocksize, int maxblockcount, int selectionparameter);
 //Specifically generates postings given a vector of blocks
 //fragID refers to the next ID to use
-std::pair<std::unordered_map<std::string, ExternNPposting>, std::vector<ExternPposting>>
-    getPostings(std::vector<std::shared_ptr<Block>>& commonblocks, unsigned int doc_id, unsigned int& fragID, StringEncoder& se);
+//There is one nonpositional posting for each term outside the common blocks, and every term with a positional posting
+//has a nonpositional posting
+PostingBatch getPostings(std::vector<Block>& commonblocks, unsigned int doc_id, unsigned int& fragID, StringEncoder& se);
 
 #endif
@@ -1,100 +1,97 @@
 #include "stringencoder.h"
 
-#include <sstream>
 #include <algorithm>
 
-#include "utility/util.hpp"
+#include "utility/tokenizer.hpp"
 
 using namespace std;
 
-//Returns whether punctuation was stripped
-bool stripPunctuation(string& s) {
-    auto from = find_if(s.begin(), s.end(), not1(ptr_fun<int, int>(ispunct)));
-    auto to = find_if(s.rbegin(), s.rend(), not1(ptr_fun<int, int>(ispunct))).base();
-    //Skip if word is just punctuation
-    if(to == s.begin())
-        return false;
-    
-    s = string(from, to);
-    return true;
+StringEncoder::StringEncoder(string_view oldfile, string_view newfile) : nextcode(0) {
+    encodeVersion(oldfile, oldencoded);
+    encodeVersion(newfile, newencoded);
+    findExclusive();
 }
 
-StringEncoder::StringEncoder(string oldfile, string newfile) : nextcode(0) {
-    transform(oldfile.begin(), oldfile.end(), oldfile.begin(), ::tolower);
-    transform(newfile.begin(), newfile.end(), newfile.begin(), ::tolower);
+StringEncoder::StringEncoder(const EncodedDocument& olddoc, string_view newfile)
+    : oldencoded(olddoc.stream), lookup(olddoc.terms), nextcode(olddoc.terms.size())
+{
+    //Codes are assigned in order of first occurrence, so the old version keeps the codes it was stored with
+    dictionary.reserve(lookup.size());
+    for(size_t code = 0; code < lookup.size(); ++code)
+        dictionary.emplace(lookup[code], code);
 
-    vector<string> oldtokens = Utility::splitString(oldfile, " \n\t\r\f");
-    vector<string> newtokens = Utility::splitString(newfile, " \n\t\r\f");
+    encodeVersion(newfile, newencoded);
+    findExclusive();
+}
 
-    for(string& token : oldtokens) {
-        //Strip punctuation
-        if(!stripPunctuation(token))
-            continue;
+StringEncoder::StringEncoder(const EncodedDocument& doc)
+    : oldencoded(doc.stream), newencoded(doc.stream), lookup(doc.terms), nextcode(doc.terms.size())
+{
+    dictionary.reserve(lookup.size());
+    for(size_t code = 0; code < lookup.size(); ++code)
+        dictionary.emplace(lookup[code], code);
 
-        auto results = dictionary.insert(make_pair(token, nextcode));
-        //If inserted
-        if(results.second) {
-            lookup.push_back(token);
-            ++nextcode;
-        }
-        //For clarity
-        auto dictiter = results.first;
-        oldencoded.push_back(dictiter->second);
-        oldexclusive.insert(token);
-    }
-    
-    for(string& token : newtokens) {
-        //Strip punctuation
-        if(!stripPunctuation(token))
-            continue;
-
-        auto results = dictionary.insert(make_pair(token, nextcode));
-        //If inserted
-        if(results.second) {
-            newcount[token] = 1;
-            lookup.push_back(token);
+    //Every term is in both versions, so none are exclusive to either
+    findExclusive();
+}
+
+StringEncoder::StringEncoder() : nextcode(0) {}
+
+void StringEncoder::encodeVersion(string_view file, vector<int>& encoded) {
+    //Terms are folded into the same buffer, so a term is only copied when it is new
+    string folded;
+    string_view term;
+    Utility::Tokenizer tokenizer(file);
+    while(tokenizer.next(term)) {
+        Utility::foldCase(term, folded);
+
+        auto dictiter = dictionary.find(folded);
+        if(dictiter == dictionary.end()) {
+            dictiter = dictionary.emplace(folded, nextcode).first;
+            lookup.push_back(folded);
             ++nextcode;
-        } else {
-            newcount[token] += 1;
         }
-        //For clarity
-        auto dictiter = results.first;
-        newencoded.push_back(dictiter->second);
-        newexclusive.insert(token);
+        encoded.push_back(dictiter->second);
     }
+}
 
-    //Create a pointer to the smaller set so we don't have to iterate through as many elements
-    unordered_set<string>* iterateset;
-    unordered_set<string>* compareset;
-    if(oldexclusive.size() > newexclusive.size()) {
-        iterateset = &newexclusive;
-        compareset = &oldexclusive;
+void StringEncoder::findExclusive() {
+    versions.assign(lookup.size(), 0);
+    oldcounts.assign(lookup.size(), 0);
+    newcounts.assign(lookup.size(), 0);
+    for(int code : oldencoded) {
+        versions[code] |= INOLD;
+        oldcounts[code]++;
     }
-    else {
-        iterateset = &newexclusive;
-        compareset = &oldexclusive;
+    for(int code : newencoded) {
+        versions[code] |= INNEW;
+        newcounts[code]++;
     }
+}
 
-    //Iterate through the smaller set and see if any of its elements are in the other set
-    auto iter = iterateset->begin();
-    while(iter != iterateset->end()) {
-
-        auto compareiter = compareset->find(*iter);
-        if(compareiter != compareset->end()) {
-            compareset->erase(*iter);
-
-            //Store the next position since this iterator will be invalidated
-            auto newiter = iter;
-            newiter++;
+StringEncoder StringEncoder::getMiddle(int prefix, int suffix) {
+    StringEncoder middle;
+    middle.oldencoded.assign(oldencoded.begin() + prefix, oldencoded.end() - suffix);
+    middle.newencoded.assign(newencoded.begin() + prefix, newencoded.end() - suffix);
+    middle.nextcode = nextcode;
+    return middle;
+}
 
-            iterateset->erase(iter);
-            
-            iter = newiter;
-        }
-        else {
-            iter++;
+EncodedDocument StringEncoder::getNewVersion(uint64_t hash) {
+    EncodedDocument version;
+    version.hash = hash;
+
+    //Recode the terms of the new version in their order of first occurrence
+    vector<int> recode(lookup.size(), -1);
+    version.stream.reserve(newencoded.size());
+    for(int code : newencoded) {
+        if(recode[code] < 0) {
+            recode[code] = version.terms.size();
+            version.terms.push_back(lookup[code]);
         }
+        version.stream.push_back(recode[code]);
     }
+    return version;
 }
 
 //Decodes a stream of ints into a list of words
@@ -119,16 +116,33 @@ string StringEncoder::decodeNum(unsigned int num) {
     else return "??";
 }
 
-bool StringEncoder::inOld(string& word) {
-    return oldexclusive.find(word) != oldexclusive.end();
+const string& StringEncoder::getTerm(int code) {
+    return lookup[code];
+}
+
+int StringEncoder::getCode(const string& term) {
+    auto dictiter = dictionary.find(term);
+    return dictiter == dictionary.end() ? -1 : dictiter->second;
+}
+
+int StringEncoder::getTermCount() {
+    return lookup.size();
+}
+
+bool StringEncoder::inOld(int code) {
+    return versions[code] == INOLD;
+}
+
+bool StringEncoder::inNew(int code) {
+    return versions[code] == INNEW;
 }
 
-bool StringEncoder::inNew(string& word) {
-    return newexclusive.find(word) != newexclusive.end();
+int StringEncoder::getOldCount(int code) {
+    return oldcounts[code];
 }
 
-int StringEncoder::getNewCount(string word) {
-    return newcount[word];
+int StringEncoder::getNewCount(int code) {
+    return newcounts[code];
 }
 
 vector<int>::const_iterator StringEncoder::getOldIter() {
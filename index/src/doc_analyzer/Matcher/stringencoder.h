@@ -3,14 +3,40 @@
 
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_set>
+#include <cstdint>
+
+//Compact form of one encoded version of a file
+//It is stored with the document, so the latest version never needs to be tokenized again
+struct EncodedDocument {
+    EncodedDocument() : hash(0) {}
+
+    //Terms of the version in order of first occurrence. The code of a term is its index
+    std::vector<std::string> terms;
+    //The version as a stream of codes
+    std::vector<int> stream;
+    //Hash of the raw text the version was encoded from
+    uint64_t hash;
+};
 
 //Encodes two versions of a file into lists of integers.
 //Also stores information about terms exclusive to either version
 class StringEncoder {
 public:
-    StringEncoder(std::string oldfile, std::string newfile);
+    //Both files are tokenized with Utility::Tokenizer, and terms are folded to lowercase
+    StringEncoder(std::string_view oldfile, std::string_view newfile);
+    //Only the new file is tokenized. The codes are the same as if the old file was given as text
+    StringEncoder(const EncodedDocument& olddoc, std::string_view newfile);
+    //Encodes a file whose previous version was identical, without tokenizing anything
+    explicit StringEncoder(const EncodedDocument& doc);
+
+    //The new version in its compact form
+    EncodedDocument getNewVersion(uint64_t hash);
+
+    //Copy of the encoded versions without their first prefix and last suffix terms
+    //Only the encoded streams are kept, which is all block matching needs; decoding returns ??
+    StringEncoder getMiddle(int prefix, int suffix);
     
     //Decodes a stream of integers into a list of words
     //Unknown ints are replaced with ??
@@ -18,12 +44,19 @@ public:
     //Decodes an individual integer into a single word
     std::string decodeNum(unsigned int num);
 
-    //Get the count of a word in the new document
-    int getNewCount(std::string word);
+    //Term of a code, or the code of a term. getCode returns -1 for unknown terms
+    const std::string& getTerm(int code);
+    int getCode(const std::string& term);
+    //Number of codes, which are 0 up to the count
+    int getTermCount();
 
-    //Sees if a word is in the old document or new document
-    bool inOld(std::string& word);
-    bool inNew(std::string& word);
+    //Get the count of a term in the old or the new document
+    int getOldCount(int code);
+    int getNewCount(int code);
+
+    //Sees if a term is only in the old document or only in the new document
+    bool inOld(int code);
+    bool inNew(int code);
     
     //Iterators for accessing the encoded documents
     std::vector<int>::const_iterator getOldIter();
@@ -36,14 +69,24 @@ public:
     int getNewSize();
     
 private:
+    StringEncoder();
+
+    //Appends the codes of the terms of file to encoded, adding new terms to the dictionary
+    void encodeVersion(std::string_view file, std::vector<int>& encoded);
+    //Fills the versions and counts of each code once both versions are encoded
+    void findExclusive();
+
+    //Versions a code appears in
+    enum : uint8_t { INOLD = 1, INNEW = 2 };
+
     //old and new files in integer form
     std::vector<int> oldencoded;
     std::vector<int> newencoded;
-    //lists of terms that appear only in the old or new file
-    std::unordered_set<std::string> oldexclusive;
-    std::unordered_set<std::string> newexclusive;
-    //list of terms that appear in the new document and their frequency
-    std::unordered_map<std::string, int> newcount;
+    //INOLD and INNEW bits of each code
+    std::vector<uint8_t> versions;
+    //frequency of each code in the old and the new document
+    std::vector<int> oldcounts;
+    std::vector<int> newcounts;
     
     //Maps words to numbers
     std::unordered_map<std::string, int> dictionary;
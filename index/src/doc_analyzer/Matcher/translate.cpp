@@ -1,10 +1,12 @@
 #include "translate.h"
 
 #include <algorithm>
+#include <limits>
+#include <cstdint>
 
 using namespace std;
 
-vector<Translation> getTranslations(int oldfilelen, int newfilelen, vector<std::shared_ptr<Block>> commonblocks) {
+vector<Translation> getTranslations(int oldfilelen, int newfilelen, vector<Block> commonblocks) {
     vector<Translation> translist;
     if(commonblocks.size() == 0)
         return translist;
@@ -16,9 +18,9 @@ vector<Translation> getTranslations(int oldfilelen, int newfilelen, vector<std::
     
     //Likely not necessary, but a useful guarantee
     sort(commonblocks.begin(), commonblocks.end(), compareOld);
-    for(std::shared_ptr<Block> b : commonblocks) {
-        int oldlength = b->oldloc - currentloc;
-        int newlength = b->newloc - (currentloc+shift);
+    for(const Block& b : commonblocks) {
+        int oldlength = b.oldloc - currentloc;
+        int newlength = b.newloc - (currentloc+shift);
         
         if(oldlength != 0 || newlength != 0) {
             Translation trans(
@@ -33,7 +35,7 @@ vector<Translation> getTranslations(int oldfilelen, int newfilelen, vector<std::
         }
         
         //want to go 1 past the edge; do not subtract 1 from run_size
-        currentloc = b->oldloc + b->len;
+        currentloc = b.oldloc + b.len;
     }
     
     //Add the last edit region if a common block does not extend to the end
@@ -50,6 +52,17 @@ vector<Translation> getTranslations(int oldfilelen, int newfilelen, vector<std::
     return translist;
 }
 
+int applyTranslations(int position, size_t fragID, const vector<Translation>& translations) {
+    for(size_t i = fragID; i < translations.size(); ++i) {
+        position = applyTranslation(position, translations[i]);
+        //return if position becomes invalidated
+        //cannot keep running; position might accidentally become revalidated
+        if(position < 0)
+            return position;
+    }
+    return position;
+}
+
 int applyTranslation(int oldindex, Translation t) {
     if(oldindex < t.loc)
         return oldindex;
@@ -57,4 +70,177 @@ int applyTranslation(int oldindex, Translation t) {
         return oldindex + (t.newlen - t.oldlen);
     else
         return -1;
+}
+
+CompiledTranslations::CompiledTranslations() {}
+
+CompiledTranslations::CompiledTranslations(const vector<Translation>& translations) {
+    append(translations);
+}
+
+void CompiledTranslations::append(const vector<Translation>& newtranslations) {
+    for(const Translation& t : newtranslations)
+        append(t);
+}
+
+void CompiledTranslations::append(const Translation& translation) {
+    translations.push_back(translation);
+    if(translations.size() > TRANSLATION_COMPILE_LIMIT) {
+        //Too long a chain to compile. Free the maps, if it just crossed the limit
+        if(!maps.empty())
+            vector<Map>().swap(maps);
+        return;
+    }
+
+    for(Map& map : maps)
+        map = compose(map, translation);
+
+    //Positions of the newest fragment only go through its own translation
+    Map identity = {Piece{0, 0, false}};
+    maps.push_back(compose(identity, translation));
+}
+
+CompiledTranslations::Map CompiledTranslations::compose(const Map& map, const Translation& translation) {
+    Map composed;
+    auto add = [&composed](int start, int offset, bool removed) {
+        //Drop empty pieces and merge pieces that map the same way
+        if(!composed.empty() && composed.back().start == start)
+            composed.pop_back();
+        if(!composed.empty() && composed.back().offset == offset && composed.back().removed == removed)
+            return;
+        composed.push_back(Piece{start, offset, removed});
+    };
+
+    for(size_t i = 0; i < map.size(); ++i) {
+        const Piece& piece = map[i];
+        int end = (i + 1 < map.size()) ? map[i + 1].start : numeric_limits<int>::max();
+        if(piece.removed) {
+            add(piece.start, 0, true);
+            continue;
+        }
+
+        //The edited block of the translation, in positions before the piece's offset
+        long long editbegin = (long long)translation.loc - piece.offset;
+        long long editend = editbegin + translation.oldlen;
+
+        int shifted = piece.offset + translation.newlen - translation.oldlen;
+        if(editend <= piece.start) {
+            //The whole piece is after the edited block
+            add(piece.start, shifted, false);
+            continue;
+        }
+
+        add(piece.start, piece.offset, false);
+        if(editbegin < end) {
+            add(max<long long>(editbegin, piece.start), 0, true);
+            if(editend < end)
+                add(editend, shifted, false);
+        }
+    }
+    return composed;
+}
+
+int CompiledTranslations::apply(int position, size_t fragID) const {
+    if(!isCompiled())
+        return applyTranslations(position, fragID, translations);
+    if(fragID >= maps.size())
+        return position;
+
+    const Map& map = maps[fragID];
+    auto iter = upper_bound(map.begin(), map.end(), position, [](int pos, const Piece& piece) {
+        return pos < piece.start;
+    });
+    if(iter == map.begin())
+        return position;
+    --iter;
+    if(iter->removed)
+        return -1;
+    return position + iter->offset;
+}
+
+vector<int> CompiledTranslations::applyBatch(const vector<FragmentPosition>& positions) const {
+    vector<int> mapped(positions.size());
+    if(!isCompiled()) {
+        for(size_t i = 0; i < positions.size(); ++i)
+            mapped[i] = applyTranslations(positions[i].second, positions[i].first, translations);
+        return mapped;
+    }
+
+    //Postings of a document usually come sorted by fragment and position, which needs a single sweep
+    if(is_sorted(positions.begin(), positions.end())) {
+        size_t i = 0;
+        while(i < positions.size() && positions[i].first < maps.size()) {
+            unsigned int fragID = positions[i].first;
+            const Map& map = maps[fragID];
+            size_t piece = 0;
+            for(; i < positions.size() && positions[i].first == fragID; ++i) {
+                int position = positions[i].second;
+                while(piece + 1 < map.size() && map[piece + 1].start <= position)
+                    ++piece;
+                mapped[i] = map[piece].removed ? -1 : position + map[piece].offset;
+            }
+        }
+        for(; i < positions.size(); ++i)
+            mapped[i] = positions[i].second;
+        return mapped;
+    }
+
+    //Bucket the positions by fragment. Fragments newer than every translation share the last, unchanged, bucket
+    size_t fragcount = maps.size() + 1;
+    vector<size_t> bucketstart(fragcount + 1, 0);
+    for(const FragmentPosition& p : positions)
+        bucketstart[min<size_t>(p.first, maps.size()) + 1]++;
+    for(size_t f = 0; f < fragcount; ++f)
+        bucketstart[f + 1] += bucketstart[f];
+
+    //Each key holds the position in its high bits and the input index in its low bits
+    vector<uint64_t> keys(positions.size());
+    vector<size_t> next(bucketstart.begin(), bucketstart.end() - 1);
+    for(size_t i = 0; i < positions.size(); ++i) {
+        const FragmentPosition& p = positions[i];
+        keys[next[min<size_t>(p.first, maps.size())]++] = ((uint64_t)p.second << 32) | i;
+    }
+
+    for(size_t f = 0; f < fragcount; ++f) {
+        auto begin = keys.begin() + bucketstart[f];
+        auto end = keys.begin() + bucketstart[f + 1];
+        if(f == maps.size()) {
+            for(; begin != end; ++begin)
+                mapped[(uint32_t)*begin] = *begin >> 32;
+            break;
+        }
+        const Map& map = maps[f];
+        if(!is_sorted(begin, end)) {
+            //Searching each position is cheaper than sorting them
+            for(; begin != end; ++begin)
+                mapped[(uint32_t)*begin] = apply(*begin >> 32, f);
+            continue;
+        }
+
+        //Positions are increasing, so the current piece only moves forward
+        size_t piece = 0;
+        for(; begin != end; ++begin) {
+            int position = *begin >> 32;
+            while(piece + 1 < map.size() && map[piece + 1].start <= position)
+                ++piece;
+            mapped[(uint32_t)*begin] = map[piece].removed ? -1 : position + map[piece].offset;
+        }
+    }
+    return mapped;
+}
+
+size_t CompiledTranslations::size() const {
+    return translations.size();
+}
+
+size_t CompiledTranslations::bytes() const {
+    size_t total = sizeof(CompiledTranslations) + translations.capacity() * sizeof(Translation)
+        + maps.capacity() * sizeof(Map);
+    for(const Map& map : maps)
+        total += map.capacity() * sizeof(Piece);
+    return total;
+}
+
+bool CompiledTranslations::isCompiled() const {
+    return translations.size() <= TRANSLATION_COMPILE_LIMIT;
 }
\ No newline at end of file
@@ -2,8 +2,10 @@
 #define TRANSLATE_H
 
 #include <vector>
+#include <utility>
 
 #include "block.h"
+#include "global_parameters.hpp"
 
 //Represents a translation that can be applied to an old posting to find its new
 //position
@@ -18,10 +20,66 @@ struct Translation {
     int newlen;
 };
 
+//(fragID, position) of a positional posting
+using FragmentPosition = std::pair<unsigned int, unsigned int>;
+
 //Get a list of translations given a list of common blocks between two files
-std::vector<Translation> getTranslations(int oldfilelen, int newfilelen, std::vector<std::shared_ptr<Block>> commonblocks);
+std::vector<Translation> getTranslations(int oldfilelen, int newfilelen, std::vector<Block> commonblocks);
 //Applys a translation to a given index
 //Returns a negative number if the index is invalid
 int applyTranslation(int oldindex, Translation t);
+//Applys every translation from fragID onwards, in order, to a position of the given fragment
+//Returns a negative number if the position was removed by a later edit
+int applyTranslations(int position, size_t fragID, const std::vector<Translation>& translations);
+
+/**
+ * Every translation of a document, compiled so that positions can be mapped without walking the translations.
+ * For each fragment, the translations from that fragment onwards are composed into a single piecewise linear map:
+ * a sorted list of breakpoints, each starting a range of positions that is either shifted by the same offset or
+ * removed. Mapping a position is a binary search over the breakpoints of its fragment.
+ * Memory: every translation can add two breakpoints to each older map, so k translations take O(k^2) pieces of 12
+ * bytes. Past TRANSLATION_COMPILE_LIMIT translations the maps are dropped, and positions are mapped by walking the
+ * translations as applyTranslations does, in O(k) memory.
+ */
+class CompiledTranslations {
+public:
+    CompiledTranslations();
+    explicit CompiledTranslations(const std::vector<Translation>& translations);
+
+    //Adds the translations of a newer version of the document, updating the existing maps in place
+    void append(const std::vector<Translation>& translations);
+    void append(const Translation& translation);
+
+    //Same result as applyTranslations(position, fragID, translations) over every appended translation
+    int apply(int position, size_t fragID) const;
+    //Maps many positions of the document at once. Positions are grouped by fragment, and the map of a fragment whose
+    //positions are increasing (as they are in a posting list) is swept once instead of searched once per position
+    //Returns the mapped positions in input order, negative for removed positions
+    std::vector<int> applyBatch(const std::vector<FragmentPosition>& positions) const;
+
+    //Number of translations appended
+    size_t size() const;
+    //Memory used, in bytes
+    size_t bytes() const;
+
+private:
+    //Positions from start up to the start of the next piece are shifted by offset, unless they were removed
+    struct Piece {
+        int start;
+        int offset;
+        bool removed;
+    };
+    using Map = std::vector<Piece>;
+
+    //Composes translation after the map
+    static Map compose(const Map& map, const Translation& translation);
+
+    //Whether positions are mapped with maps, rather than by walking translations
+    bool isCompiled() const;
+
+    //maps[f] applies translations f onwards. Empty past TRANSLATION_COMPILE_LIMIT translations
+    std::vector<Map> maps;
+    std::vector<Translation> translations;
+};
 
 #endif
\ No newline at end of file
@@ -1,12 +1,22 @@
 #include "analyzer.h"
 
+#include <optional>
+#include <unordered_set>
+
 #include "Matcher/matcher.h"
 #include "global_parameters.hpp"
+#include "utility/metrics.hpp"
+#include "utility/parallel.hpp"
+#include "utility/tokenizer.hpp"
+#include "utility/util.hpp"
 
 using namespace std;
 
 //Assumed this is called from the index when a new document arrives
-MatcherInfo indexUpdate(string& url, string& newpage, string& timestamp, DocumentStore& docstore, TranslationTable& transtable) {
+MatcherInfo indexUpdate(string& url, string_view newpage, string& timestamp, DocumentStore& docstore, TranslationTable& transtable) {
+    static Metrics::Histogram& updatehist = Metrics::histogram("analyzer.index_update_ns");
+    Metrics::ScopedTimer timer(updatehist);
+
     //-fetch the previous version, and the did of the document, from a tuple store or database (TBD)
     DocumentTuple olddoc = docstore.getDocument(url);
     //Document does not exist yet
@@ -16,7 +26,8 @@ MatcherInfo indexUpdate(string& url, string& newpage, string& timestamp, Documen
     }
     
     //-call makePosts(URL, did, currentpage, previouspage), which generates and returns the new postings that you are creating by your matching algorithm (that is, non-positional and position postings) and the additional translation statements to be appended.
-    MatcherInfo info = makePosts(olddoc, newpage);
+    uint64_t hash = Utility::hashString(newpage);
+    MatcherInfo info = makePosts(olddoc, newpage, hash);
 
     //-now you can directly call Fengyuan's code to insert those posts(to be done later)
 
@@ -24,31 +35,133 @@ MatcherInfo indexUpdate(string& url, string& newpage, string& timestamp, Documen
     transtable.insert(info.translations, olddoc.docID);
 
     //-and store the currentpage instead of the previouspage in the tuple store.
-    docstore.insertDocument(url, newpage, info.se.getNewSize(), info.maxfragID, timestamp);
+    //It is stored already encoded, so the next update only has to tokenize its own page
+    docstore.insertDocument(url, info.se.getNewVersion(hash), info.se.getNewSize(), info.maxfragID, timestamp);
 
     info.docID = olddoc.docID;
 
     return info;
 }
 
-MatcherInfo makePosts(DocumentTuple& olddoc, string& newpage) {
+vector<pair<size_t, size_t>> splitBatchRounds(const vector<DocumentInput>& batch) {
+    vector<pair<size_t, size_t>> rounds;
+    size_t begin = 0;
+    while(begin < batch.size()) {
+        unordered_set<string_view> urls;
+        size_t end = begin;
+        while(end < batch.size() && urls.insert(batch[end].url).second)
+            end++;
+        rounds.emplace_back(begin, end);
+        begin = end;
+    }
+    return rounds;
+}
+
+vector<MatcherInfo> indexUpdateBatch(const vector<DocumentInput>& batch, size_t begin, size_t end, string& timestamp,
+    DocumentStore& docstore, TranslationTable& transtable)
+{
+    static Metrics::Histogram& updatehist = Metrics::histogram("analyzer.index_update_batch_ns");
+    Metrics::ScopedTimer timer(updatehist);
+
+    size_t count = end - begin;
+    vector<string> urls;
+    for(size_t i = begin; i < end; ++i)
+        urls.push_back(batch[i].url);
+    vector<DocumentTuple> olddocs = docstore.getDocuments(urls);
+
+    //The store gives new documents consecutive docIDs, in order
+    unsigned int nextdocID = docstore.getNextDocID();
+    for(DocumentTuple& olddoc : olddocs) {
+        if(olddoc.timestamp.empty())
+            olddoc.docID = nextdocID++;
+    }
+
+    //Pages are analyzed on every core
+    vector<optional<MatcherInfo>> analyzed(count);
+    vector<EncodedDocument> versions(count);
+    Utility::parallelFor(count, [&](size_t i) {
+        uint64_t hash = Utility::hashString(batch[begin + i].page);
+        analyzed[i].emplace(makePosts(olddocs[i], batch[begin + i].page, hash));
+        versions[i] = analyzed[i]->se.getNewVersion(hash);
+    });
+
+    vector<MatcherInfo> results;
+    vector<pair<int, vector<Translation>>> translations;
+    vector<DocumentUpdate> updates;
+    results.reserve(count);
+    for(size_t i = 0; i < count; ++i) {
+        MatcherInfo& info = *analyzed[i];
+        info.docID = olddocs[i].docID;
+        translations.emplace_back(info.docID, info.translations);
+        updates.push_back({urls[i], olddocs[i].doclength, std::move(versions[i]), info.se.getNewSize(),
+            (unsigned int)info.maxfragID, timestamp});
+        results.push_back(std::move(info));
+    }
+
+    transtable.insertBatch(translations);
+    docstore.insertDocuments(updates);
+
+    return results;
+}
+
+//Whether page tokenizes to exactly the terms of the stored version. No dictionary is built
+static bool sameTerms(const EncodedDocument& doc, string_view page) {
+    Utility::Tokenizer tokenizer(page);
+    string_view term;
+    string folded;
+    for(int code : doc.stream) {
+        if(!tokenizer.next(term))
+            return false;
+        Utility::foldCase(term, folded);
+        if(folded != doc.terms[code])
+            return false;
+    }
+    return !tokenizer.next(term);
+}
+
+MatcherInfo makePosts(DocumentTuple& olddoc, string_view newpage, uint64_t hash) {
     //-check if there was a previous version, if not create postings with fragid = 0
+    static Metrics::Histogram& encodehist = Metrics::histogram("analyzer.encode_ns");
+    static Metrics::Histogram& matchhist = Metrics::histogram("analyzer.match_ns");
+    static Metrics::Histogram& translatehist = Metrics::histogram("analyzer.translations_ns");
+    static Metrics::Histogram& postingshist = Metrics::histogram("analyzer.postings_ns");
+    static Metrics::Counter& unchangedcount = Metrics::counter("analyzer.unchanged_documents");
+
     unsigned int fragID = olddoc.maxfragID;
 
-    StringEncoder se(olddoc.doc, newpage);
+    //Recrawled pages are often unchanged, in which case nothing is encoded or matched
+    //Equal hashes are confirmed against the stored terms, since a collision would lose the changes
+    bool unchanged = !olddoc.doc.stream.empty() && olddoc.doc.hash == hash && sameTerms(olddoc.doc, newpage);
+
+    //The previous version is stored encoded, so only the new page is tokenized
+    auto stagebegin = std::chrono::steady_clock::now();
+    StringEncoder se = unchanged ? StringEncoder(olddoc.doc) : StringEncoder(olddoc.doc, newpage);
+    encodehist.record(Metrics::nanosSince(stagebegin));
 
-    vector<std::shared_ptr<Block>> commonblocks;
-    if(olddoc.doc.length() != 0) {
+    vector<Block> commonblocks;
+    if(unchanged) {
+        unchangedcount.add();
+        //The whole document is common, so there are no translations or postings
+        if(se.getNewSize() > 0)
+            commonblocks.emplace_back(0, 0, se.getNewSize());
+    }
+    else if(!olddoc.doc.stream.empty()) {
         //-else, run the graph based matching algorithm on the two versions
-        commonblocks = getOptimalBlocks(se, MIN_BLOCK_SIZE, MAX_BLOCK_COUNT, 0.5);
+        //Only the text between the common prefix and suffix is matched
+        Metrics::ScopedTimer matchtimer(matchhist);
+        commonblocks = getTrimmedBlocks(se, MIN_BLOCK_SIZE, MAX_BLOCK_COUNT, 0.5);
     }
 
     //Get the translation and posting list
+    stagebegin = std::chrono::steady_clock::now();
     vector<Translation> translist = getTranslations(se.getOldSize(), se.getNewSize(), commonblocks);
-    auto postingslist = getPostings(commonblocks, olddoc.docID, fragID, se);
+    translatehist.record(Metrics::nanosSince(stagebegin));
 
-    //-generate postings and translation statements, and return them. (Question: how do we know the previous largest fragid for this document, so we know what to use as the next fragid? Maybe store with did in the tuple store?)
-    MatcherInfo posts(postingslist.first, postingslist.second, translist, se, fragID);
+    stagebegin = std::chrono::steady_clock::now();
+    PostingBatch postings = getPostings(commonblocks, olddoc.docID, fragID, se);
+    postingshist.record(Metrics::nanosSince(stagebegin));
 
-    return posts;
+    //-generate postings and translation statements, and return them. (Question: how do we know the previous largest fragid for this document, so we know what to use as the next fragid? Maybe store with did in the tuple store?)
+    //Nothing is copied on the way out
+    return MatcherInfo(std::move(postings), std::move(translist), std::move(se), fragID);
 }
@@ -2,7 +2,9 @@
 #define ANALYZER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <utility>
 
 #include "externalpostings.h"
 #include "Matcher/translate.h"
@@ -11,21 +13,37 @@
 
 //A collection of positional/nonpositional postings and translation vector
 struct MatcherInfo {
-    MatcherInfo(std::unordered_map<std::string, ExternNPposting> n, std::vector<ExternPposting> p, std::vector<Translation> t, StringEncoder s, int m)
-        : NPpostings(n), Ppostings(p), translations(t), se(s), maxfragID(m) {}
+    MatcherInfo(PostingBatch p, std::vector<Translation> t, StringEncoder s, int m)
+        : postings(std::move(p)), translations(std::move(t)), se(std::move(s)), maxfragID(m) {}
 
-    std::unordered_map<std::string, ExternNPposting> NPpostings;
-    std::vector<ExternPposting> Ppostings;
+    PostingBatch postings;
     std::vector<Translation> translations;
     StringEncoder se;
+    //Lexicon termID of each code of se that has postings. Filled in by the index when it inserts the postings
+    std::vector<unsigned int> termIDs;
 
     int maxfragID;
     unsigned int docID;
 };
 
+//A page to index, and the url it was crawled from
+struct DocumentInput {
+    std::string url;
+    std::string_view page;
+};
+
 //Updates the index given a new page
-MatcherInfo indexUpdate(std::string& url, std::string& newpage, std::string& timestamp, DocumentStore& docstore, TranslationTable& transtable);
+MatcherInfo indexUpdate(std::string& url, std::string_view newpage, std::string& timestamp, DocumentStore& docstore, TranslationTable& transtable);
+//Same as indexUpdate for documents begin to end of batch, whose urls must all be different. The pages are analyzed in
+//parallel, and each store is read and written with one round trip for the whole range. Results are in batch order
+std::vector<MatcherInfo> indexUpdateBatch(const std::vector<DocumentInput>& batch, size_t begin, size_t end,
+    std::string& timestamp, DocumentStore& docstore, TranslationTable& transtable);
+//Splits a batch into the ranges of documents that indexUpdateBatch can analyze together, in order. A document is
+//analyzed against its stored version, so a url that repeats starts a new range. Ranges are (begin, end)
+std::vector<std::pair<size_t, size_t>> splitBatchRounds(const std::vector<DocumentInput>& batch);
 //Generates new postings and translations from the new page
-MatcherInfo makePosts(DocumentTuple& olddoc, std::string& newpage);
+//hash is the Utility::hashString of the new page, which is unchanged if it matches the hash of the stored version
+//and the page has the same terms
+MatcherInfo makePosts(DocumentTuple& olddoc, std::string_view newpage, uint64_t hash);
 
 #endif
@@ -0,0 +1,34 @@
+#include "externalpostings.h"
+
+void PostingBatch::addNonPositional(unsigned int term, int freq) {
+    npterms.push_back(term);
+    freqs.push_back(freq);
+}
+
+void PostingBatch::addPositional(unsigned int term, unsigned int fragID, unsigned int pos) {
+    pterms.push_back(term);
+    fragIDs.push_back(fragID);
+    positions.push_back(pos);
+}
+
+size_t PostingBatch::nonPositionalSize() const {
+    return npterms.size();
+}
+
+size_t PostingBatch::positionalSize() const {
+    return pterms.size();
+}
+
+std::vector<unsigned int> PostingBatch::groupPositional(unsigned int termcount, std::vector<unsigned int>& runstarts) const {
+    runstarts.assign(termcount + 1, 0);
+    for(unsigned int term : pterms)
+        runstarts[term + 1]++;
+    for(unsigned int term = 0; term < termcount; ++term)
+        runstarts[term + 1] += runstarts[term];
+
+    std::vector<unsigned int> next(runstarts.begin(), runstarts.end() - 1);
+    std::vector<unsigned int> order(pterms.size());
+    for(unsigned int i = 0; i < pterms.size(); ++i)
+        order[next[pterms[i]]++] = i;
+    return order;
+}
\ No newline at end of file
@@ -1,35 +1,43 @@
 #ifndef EXTERNALPOSTINGS_H
 #define EXTERNALPOSTINGS_H
-#include <string>
 
-//These structs define the format of the posting returned by the matcher to the index
-//The index uses a different form of postings, and must convert these postings
-//when receiving them from the matcher
+#include <vector>
+#include <cstddef>
 
-struct ExternNPposting {
-    ExternNPposting(std::string id, unsigned int d, int fr = 0) {
-        term = id;
-        docID = d;
-        freq = fr;
-    }
+/**
+ * Postings of one document returned by the matcher to the index, stored as columns.
+ * The index uses a different form of postings, and must convert these postings when receiving them from the matcher.
+ * Terms are codes in the StringEncoder of the document, which the index maps to its termIDs.
+ * A batch can be large, so it is built in place and only ever moved.
+ */
+struct PostingBatch {
+    explicit PostingBatch(unsigned int d) : docID(d) {}
 
-    std::string term;
-    unsigned int docID;
-    int freq;
-};
+    PostingBatch(PostingBatch&&) = default;
+    PostingBatch& operator=(PostingBatch&&) = default;
+    PostingBatch(const PostingBatch&) = delete;
+    PostingBatch& operator=(const PostingBatch&) = delete;
+
+    void addNonPositional(unsigned int term, int freq);
+    void addPositional(unsigned int term, unsigned int fragID, unsigned int pos);
 
-struct ExternPposting {
-    ExternPposting(std::string id, unsigned int d, unsigned int f, unsigned int p) {
-        term = id;
-        docID = d;
-        fragID = f;
-        pos = p;
-    }
+    size_t nonPositionalSize() const;
+    size_t positionalSize() const;
+
+    //Indexes of the positional postings grouped by term with a counting sort, keeping their order within a term.
+    //Terms must be less than termcount. runstarts is set to the start of the run of each term, followed by the end
+    std::vector<unsigned int> groupPositional(unsigned int termcount, std::vector<unsigned int>& runstarts) const;
 
-    std::string term;
     unsigned int docID;
-    unsigned int fragID;
-    unsigned int pos;
+
+    //Nonpositional postings
+    std::vector<unsigned int> npterms;
+    std::vector<int> freqs;
+
+    //Positional postings
+    std::vector<unsigned int> pterms;
+    std::vector<unsigned int> fragIDs;
+    std::vector<unsigned int> positions;
 };
 
-#endif
+#endif
\ No newline at end of file
@@ -1,104 +1,132 @@
 #include "RAWreader.hpp"
 
 #include <algorithm>
+#include <functional>
+#include <stdexcept>
 
 #include "utility/util.hpp"
 
-RAWReader::RAWReader(std::string dir) : docdir(dir), doc_index(0) {
-    doc_collection = Utility::readDirectory(dir);
-    std::sort(doc_collection.begin(), doc_collection.end());
-    file.open("./" + dir + "/" + doc_collection[doc_index]);
-    if(!file)
-        throw std::runtime_error("Error opening file in document collection");
-
-    //Read url from first header
-    std::getline(file, nextline);
-    auto tokens = Utility::splitString(nextline, ' ');
-    if(tokens.size() != 3)
-        throw std::runtime_error("Error, invalid document header in raw file");
-    url = tokens[2];
+namespace {
 
-    //Read first document
-    std::string line;
-    while(line.compare(0, 32, "df6fa1abb58549287111ba8d776733e9") != 0) {
-        docbuffer += (line + "\n");
-        std::getline(file, line);
-    }
+//Starts every header after the first one of a file
+const std::string SEPARATOR = "\ndf6fa1abb58549287111ba8d776733e9";
 
-    //Store over-read line
-    nextline = line;
+std::vector<std::string> listFiles(const std::string& dir) {
+    std::vector<std::string> files = Utility::readDirectory(dir);
+    std::sort(files.begin(), files.end());
+    return files;
 }
 
-std::string RAWReader::getCurrentDocument() {
-    return docbuffer;
 }
 
-std::string RAWReader::getURL() {
+RAWReader::RAWReader(std::string dir) : RAWReader(dir, indexCollection(dir)) {}
+
+RAWReader::RAWReader(std::string dir, std::vector<RawDocumentOffset> documents) : docdir(dir),
+    documents(std::move(documents)), doc_index(0), fileindex(0), nextfileindex(0)
+{
+    doc_collection = listFiles(dir);
+    if(doc_index < this->documents.size())
+        readDocument();
+}
+
+std::vector<RawDocumentOffset> RAWReader::indexCollection(const std::string& dir) {
+    //Skips ahead by up to the length of the separator on every mismatch, so most bytes are never compared
+    std::boyer_moore_horspool_searcher<std::string::const_iterator> searcher(SEPARATOR.begin(), SEPARATOR.end());
+
+    std::vector<std::string> files = listFiles(dir);
+    std::vector<RawDocumentOffset> offsets;
+    for(size_t i = 0; i < files.size(); ++i) {
+        Utility::MappedFile mapped("./" + dir + "/" + files[i]);
+        std::string_view contents = mapped.getContents();
+        if(contents.empty())
+            continue;
+
+        //The first document of a file starts right away, without the magic number
+        const char* begin = contents.data();
+        const char* end = contents.data() + contents.size();
+        const char* docbegin = begin;
+        while(true) {
+            const char* separator = std::search(docbegin, end, searcher);
+            const char* docend = separator == end ? end : separator + 1;
+            offsets.push_back({i, (size_t)(docbegin - begin), (size_t)(docend - begin)});
+            if(docend == end)
+                break;
+            docbegin = docend;
+        }
+    }
+    return offsets;
+}
+
+std::string_view RAWReader::getCurrentDocument() {
+    return document;
+}
+
+std::string_view RAWReader::getURL() {
     return url;
 }
 
 bool RAWReader::nextDocument() {
-    if(doc_index >= doc_collection.size())
+    if(doc_index >= documents.size())
         return false;
 
-    docbuffer.clear();
-
-    //Get url from old header. Assume already have
-    auto tokens = Utility::splitString(nextline, ' ');
-    if(tokens.size() != 3)
-        throw std::runtime_error("Error, invalid document header in raw file");
-    url = tokens[2];
-
-    //Read lines until magic number is found
-    std::string line;
-    std::getline(file, line);
-    
-    while(line.compare(0, 32, "df6fa1abb58549287111ba8d776733e9") != 0) {
-        docbuffer += (line + "\n");
-        std::getline(file, line);
-
-        //Break on end-of-file
-        if(!file)
-            break;
-    }
-    
-    //Store the over-read line
-    nextline = line;
-
-    if(!file) {
-        file.close();
-        file.clear();
-
-        doc_index++;
-        //Return true here since a valid document was still read, but we don't want to try reading the next file
-        if(doc_index >= doc_collection.size())
-            return true;
-        
-        file.open("./" + docdir + "/" + doc_collection[doc_index]);
-        if(!file)
-            throw std::runtime_error("Error opening file in document collection, " + doc_collection[doc_index]);
-        
-        //Read url from first header
-        std::getline(file, nextline);
-        auto tokens = Utility::splitString(nextline, ' ');
-        if(tokens.size() != 3)
-            throw std::runtime_error("Error, invalid document header in raw file");
-        url = tokens[2];
-
-        //Read first document
-        std::string line;
-        while(line.compare(0, 32, "df6fa1abb58549287111ba8d776733e9") != 0) {
-            docbuffer += (line + "\n");
-            std::getline(file, line);
-        }
-
-        //Store over-read line
-        nextline = line;
+    doc_index++;
+    if(doc_index >= documents.size()) {
+        file.reset();
+        nextfile.reset();
+        url = std::string_view();
+        document = std::string_view();
+        return false;
     }
 
+    readDocument();
     return true;
 }
 
 bool RAWReader::isValid() {
-    return doc_index < doc_collection.size();
+    return doc_index < documents.size();
+}
+
+void RAWReader::readDocument() {
+    const RawDocumentOffset& offset = documents[doc_index];
+    if(!file || offset.file != fileindex)
+        openFile(offset.file);
+
+    std::string_view contents = file->getContents();
+    if(offset.begin > offset.end || offset.end > contents.size())
+        throw std::runtime_error("Error, document offset is outside of " + doc_collection[offset.file]);
+    contents = contents.substr(offset.begin, offset.end - offset.begin);
+
+    //The document is everything after its header line
+    size_t headerend = contents.find('\n');
+    std::string_view header = contents.substr(0, headerend);
+    document = headerend == std::string_view::npos ? std::string_view() : contents.substr(headerend + 1);
+
+    //The header has three fields separated by spaces, the last of which is the url
+    size_t first = header.find(' ');
+    size_t second = first == std::string_view::npos ? first : header.find(' ', first + 1);
+    if(second == std::string_view::npos || header.find(' ', second + 1) != std::string_view::npos)
+        throw std::runtime_error("Error, invalid document header in raw file");
+    url = header.substr(second + 1);
+}
+
+void RAWReader::openFile(size_t index) {
+    if(index >= doc_collection.size())
+        throw std::runtime_error("Error, document offset refers to a file not in " + docdir);
+
+    if(nextfile && nextfileindex == index)
+        file = std::move(nextfile);
+    else
+        file = std::make_unique<Utility::MappedFile>("./" + docdir + "/" + doc_collection[index]);
+    fileindex = index;
+
+    //Start reading the next file in the background
+    nextfile.reset();
+    for(size_t i = doc_index; i < documents.size(); ++i) {
+        if(documents[i].file != index && documents[i].file < doc_collection.size()) {
+            nextfileindex = documents[i].file;
+            nextfile = std::make_unique<Utility::MappedFile>("./" + docdir + "/" + doc_collection[nextfileindex]);
+            nextfile->prefetch();
+            break;
+        }
+    }
 }
\ No newline at end of file
@@ -3,31 +3,61 @@
 
 #include <vector>
 #include <string>
-#include <fstream>
+#include <string_view>
+#include <memory>
 
 #include "reader_interface.hpp"
+#include "utility/mapped_file.hpp"
+
+//Where a document is in a directory of RAW files
+struct RawDocumentOffset {
+    //Index of the file in the sorted directory
+    size_t file;
+    //Offset of the document's header line, and one past its last byte
+    size_t begin;
+    size_t end;
+};
 
+/**
+ * Reads a directory of RAW files. Every document starts with a header line whose third field is its url, and every
+ * header after the first one of a file starts with a magic number. Headers are found with a Boyer-Moore-Horspool
+ * search over the memory mapped files, and documents are handed out as views into the mappings.
+ * The offsets of every document are found up front, so a collection can be split between several readers by
+ * giving each one a range of indexCollection.
+ */
 class RAWReader : public ReaderInterface {
 public:
     //Can only read directories in the same directory as the executable TODO: Make directory support better
     RAWReader(std::string dir);
+    //Only reads the given documents of dir, in order. They are read fastest when sorted by file
+    RAWReader(std::string dir, std::vector<RawDocumentOffset> documents);
+
+    //Finds every document in dir, in reading order
+    static std::vector<RawDocumentOffset> indexCollection(const std::string& dir);
 
-    std::string getURL();
-    std::string getCurrentDocument();
+    std::string_view getURL();
+    std::string_view getCurrentDocument();
     bool nextDocument();
     bool isValid();
 
 private:
+    //Sets the url and the document to the ones at doc_index, mapping its file if needed
+    void readDocument();
+    //Maps the file at index of doc_collection, and prefetches the next file that will be read
+    void openFile(size_t index);
+
     std::string docdir;
     std::vector<std::string> doc_collection;
+    std::vector<RawDocumentOffset> documents;
     size_t doc_index;
 
-    std::ifstream file;
+    std::unique_ptr<Utility::MappedFile> file;
+    size_t fileindex;
+    std::unique_ptr<Utility::MappedFile> nextfile;
+    size_t nextfileindex;
 
-    std::string docbuffer;
-    std::string url;
-    //Stores the line associated with the next document
-    std::string nextline;
+    std::string_view url;
+    std::string_view document;
 };
 
 #endif
\ No newline at end of file
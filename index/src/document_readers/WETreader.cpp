@@ -1,101 +1,196 @@
 #include "WETreader.hpp"
 
 #include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
 
 #include "utility/util.hpp"
 
-WETReader::WETReader(std::string dir) : docdir(dir), doc_index(0) {
-    doc_collection = Utility::readDirectory(dir);
-    std::sort(doc_collection.begin(), doc_collection.end());
-    file.open("./" + dir + "/" + doc_collection[doc_index]);
-    if(!file)
-        throw std::runtime_error("Error opening file in document collection");
-    
-    //Skip first 18 lines
-    std::string line;
-    for(int i = 0; i < 18; i++)
-        std::getline(file, line);
+namespace {
 
-    nextDocument();
+//Sets line to the line starting at pos, without its line ending, and moves pos past it
+//A line without a line ending is only returned if complete is set, since the rest of it may not have been read yet
+bool nextLine(std::string_view contents, size_t& pos, std::string_view& line, bool complete) {
+    if(pos >= contents.size())
+        return false;
+
+    const char* begin = contents.data() + pos;
+    size_t remaining = contents.size() - pos;
+    const char* end = static_cast<const char*>(std::memchr(begin, '\n', remaining));
+    if(!end && !complete)
+        return false;
+    size_t length = end ? end - begin : remaining;
+    pos += end ? length + 1 : length;
+
+    line = std::string_view(begin, length);
+    //WARC lines end with \r\n
+    if(!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    return true;
+}
+
+bool startsWith(std::string_view line, std::string_view prefix) {
+    return line.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string_view trim(std::string_view str) {
+    size_t first = str.find_first_not_of(" \t");
+    if(first == std::string_view::npos)
+        return std::string_view();
+    size_t last = str.find_last_not_of(" \t");
+    return str.substr(first, last - first + 1);
 }
 
-std::string WETReader::getCurrentDocument() {
-    return docbuffer;
 }
 
-std::string WETReader::getURL() {
-    if(doc_index >= doc_collection.size())
-        return "";
+WETReader::WETReader(std::string dir, size_t shard, size_t shardcount) : docdir(dir), doc_index(0), complete(true),
+    filepos(0)
+{
+    if(shardcount == 0 || shard >= shardcount)
+        throw std::invalid_argument("Error, invalid shard " + std::to_string(shard) + " of " + std::to_string(shardcount));
 
-    size_t splitloc = header[2].find_first_of(':', 0);
-    if(splitloc == std::string::npos)
-        throw std::runtime_error("Error parsing WET header");
+    std::vector<std::string> files = Utility::readDirectory(dir);
+    std::sort(files.begin(), files.end());
+    for(size_t i = shard; i < files.size(); i += shardcount)
+        doc_collection.push_back(files[i]);
 
-    //Advance beyond the first colon
-    splitloc++;
+    if(!doc_collection.empty()) {
+        next = openFile(doc_index);
+        beginFile();
+    }
 
-    return Utility::trim(header[2].substr(splitloc, header[2].size()-splitloc));
+    nextDocument();
 }
 
-bool WETReader::nextDocument() {
-    if(doc_index >= doc_collection.size())
-        return false;
+std::string_view WETReader::getCurrentDocument() {
+    return document;
+}
 
-    header.clear();
+std::string_view WETReader::getURL() {
+    return url;
+}
 
-    std::string line;
-    //Read header
-    while(header.size() < 9) {
-        if(!std::getline(file, line))
-            throw std::runtime_error("Error getting header in nextDocument");
+bool WETReader::nextDocument() {
+    while(doc_index < doc_collection.size()) {
+        RecordResult result = parseRecord();
+        if(result == FOUND)
+            return true;
+        if(result == SKIPPED)
+            continue;
+        if(!complete) {
+            readMore();
+            continue;
+        }
 
-        header.push_back(line);
+        doc_index++;
+        if(doc_index < doc_collection.size())
+            beginFile();
     }
 
-    //Throw away line after header
-    std::getline(file, line);
+    current = InputFile();
+    contents = std::string_view();
+    url = std::string_view();
+    document = std::string_view();
+    return false;
+}
 
-    //Get number of bytes to read
-    std::vector<std::string> splitstr = Utility::splitString(header[8], ':');
-    if(splitstr.size() != 2)
-        throw std::runtime_error("Error parsing WET header");
-    
-    int docsize = std::stoi(splitstr[1]);
+bool WETReader::isValid() {
+    return doc_index < doc_collection.size();
+}
 
-    std::vector<char> buf(docsize);
-    docbuffer.clear();
-    file.read(&buf.front(), docsize);
+WETReader::InputFile WETReader::openFile(size_t index) {
+    const std::string& name = doc_collection[index];
+    std::string path = "./" + docdir + "/" + name;
 
-    docbuffer = std::string(buf.begin(), buf.end());
+    InputFile input;
+    //Decompression starts right away, on the gzip reader's own thread
+    if(name.size() > 3 && name.compare(name.size() - 3, 3, ".gz") == 0) {
+        input.gzip = std::make_unique<Utility::GzipReader>(path);
+    }
+    else {
+        input.mapped = std::make_unique<Utility::MappedFile>(path);
+        input.mapped->prefetch();
+    }
+    return input;
+}
 
-    //Throw away two lines after document
-    std::getline(file, line);
-    std::getline(file, line);
-    //Read extra newline
-    file.get();
+void WETReader::beginFile() {
+    current = std::move(next);
+    next = InputFile();
+    if(doc_index + 1 < doc_collection.size())
+        next = openFile(doc_index + 1);
 
-    //If next char is invalid, begin reading next file
-    if(file.peek() < 0) {
-        file.close();
-        file.clear();
+    buffer.clear();
+    filepos = 0;
+    complete = current.mapped != nullptr;
+    contents = complete ? current.mapped->getContents() : std::string_view();
+}
 
-        doc_index++;
-        if(doc_index >= doc_collection.size())
-            return false;
-        
-        file.open("./" + docdir + "/" + doc_collection[doc_index]);
-        if(!file)
-            throw std::runtime_error("Error opening file in document collection, " + doc_collection[doc_index]);
-        
-        //Skip first 18 lines
-        std::string line;
-        for(int i = 0; i < 18; i++)
-            std::getline(file, line);
+void WETReader::readMore() {
+    //Views into the records already read are no longer handed out, so they can be dropped
+    buffer.erase(0, filepos);
+    filepos = 0;
+    if(!current.gzip->read(buffer))
+        complete = true;
+    contents = buffer;
+}
+
+WETReader::RecordResult WETReader::parseRecord() {
+    const std::string& name = doc_collection[doc_index];
+    size_t pos = filepos;
+    std::string_view line;
+
+    //Records are separated by empty lines
+    do {
+        if(!nextLine(contents, pos, line, complete))
+            return NEEDMORE;
+    } while(line.empty());
+
+    if(!startsWith(line, "WARC/"))
+        throw std::runtime_error("Error parsing WET header in " + name + " at " + std::to_string(pos));
+
+    //Header fields end at the first empty line
+    std::string_view target;
+    size_t length = 0;
+    bool haslength = false;
+    while(true) {
+        if(!nextLine(contents, pos, line, complete)) {
+            if(complete)
+                throw std::runtime_error("Error, truncated WET record in " + name);
+            return NEEDMORE;
+        }
+        if(line.empty())
+            break;
+
+        if(startsWith(line, "WARC-Target-URI:")) {
+            target = trim(line.substr(16));
+        }
+        else if(startsWith(line, "Content-Length:")) {
+            std::string_view value = trim(line.substr(15));
+            auto result = std::from_chars(value.data(), value.data() + value.size(), length);
+            if(result.ec != std::errc() || result.ptr != value.data() + value.size())
+                throw std::runtime_error("Error parsing WET header in " + name + " at " + std::to_string(pos));
+            haslength = true;
+        }
     }
 
-    return true;
-}
+    if(!haslength)
+        throw std::runtime_error("Error, WET record without a Content-Length in " + name);
+    if(length > contents.size() - pos) {
+        if(complete)
+            throw std::runtime_error("Error, truncated WET record in " + name);
+        return NEEDMORE;
+    }
 
-bool WETReader::isValid() {
-    return doc_index < doc_collection.size();
+    std::string_view body = contents.substr(pos, length);
+    filepos = pos + length;
+
+    //Only conversion records have a target URI. This skips the warcinfo record at the start of each file
+    if(target.empty())
+        return SKIPPED;
+
+    url = target;
+    document = body;
+    return FOUND;
 }
\ No newline at end of file
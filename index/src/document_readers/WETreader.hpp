@@ -3,30 +3,67 @@
 
 #include <vector>
 #include <string>
-#include <fstream>
+#include <string_view>
+#include <memory>
 
 #include "reader_interface.hpp"
+#include "utility/mapped_file.hpp"
+#include "utility/gzip_reader.hpp"
 
+/**
+ * Reads the conversion records of a directory of WET files. Each file is memory mapped and its records are found
+ * by scanning for line ends, so documents are handed out as views into the mapping without being copied.
+ * Files ending in .gz are decompressed on a background thread instead, and their records are read from a buffer.
+ * The file after the current one is opened ahead of time and prefetched, or decompressed, in the background.
+ * Files can be split between several readers, for example one per thread, by giving each reader its own shard.
+ */
 class WETReader : public ReaderInterface {
 public:
     //Can only read directories in the same directory as the executable TODO: Make directory support better
-    WETReader(std::string dir);
+    //The reader only reads every shardcount-th file of the sorted directory, starting at file shard
+    WETReader(std::string dir, size_t shard = 0, size_t shardcount = 1);
 
-    std::string getURL();
-    std::string getCurrentDocument();
+    std::string_view getURL();
+    std::string_view getCurrentDocument();
     bool nextDocument();
     bool isValid();
 
 private:
+    //A WET file, either mapped or decompressed in the background
+    struct InputFile {
+        std::unique_ptr<Utility::MappedFile> mapped;
+        std::unique_ptr<Utility::GzipReader> gzip;
+    };
+    enum RecordResult { FOUND, SKIPPED, NEEDMORE };
+
+    //Opens the file at index of doc_collection, and starts reading it in the background
+    InputFile openFile(size_t index);
+    //Moves on to the file at doc_index, which was opened ahead of time, and opens the one after it
+    void beginFile();
+    //Drops the records already read from the buffer of a compressed file, and appends the next decompressed chunk
+    void readMore();
+    //Parses the record at filepos. Returns NEEDMORE, without moving filepos, if the rest of the record has not
+    //been decompressed yet, or if there are no records left in the file
+    RecordResult parseRecord();
+
     std::string docdir;
+    //Only the files of this reader's shard
     std::vector<std::string> doc_collection;
     size_t doc_index;
 
-    std::ifstream file;
+    InputFile current;
+    InputFile next;
+    //Decompressed data of a compressed file that has not been read yet
+    std::string buffer;
+    //Data of the current file that can be parsed, either the mapping or the buffer
+    std::string_view contents;
+    //Whether contents holds the rest of the current file
+    bool complete;
+    //Offset of the next record in contents
+    size_t filepos;
 
-    std::string docbuffer;
-    //Header is always 9 lines
-    std::vector<std::string> header;
+    std::string_view url;
+    std::string_view document;
 };
 
 #endif
\ No newline at end of file
@@ -1,16 +1,19 @@
 #ifndef READER_INTERFACE_HPP
 #define READER_INTERFACE_HPP
 
-#include <string>
+#include <string_view>
 
 class ReaderInterface {
 public:
-    //All readers should already have a valid currentDocument after initialization
+    virtual ~ReaderInterface() = default;
+
+    //All readers should already have a valid currentDocument after initialization, unless they have no documents
+    //The views returned by getURL and getCurrentDocument are only valid until the next call to nextDocument
 
     //Returns the url of the current document
-    virtual std::string getURL() = 0;
+    virtual std::string_view getURL() = 0;
     //Returns the current document of the reader
-    virtual std::string getCurrentDocument() = 0;
+    virtual std::string_view getCurrentDocument() = 0;
     //Returns whether a next document was sucessfully gotten
     virtual bool nextDocument() = 0;
     //Returns whether the document reader is in a valid state
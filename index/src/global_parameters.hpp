@@ -9,15 +9,42 @@
 
 #define DAAT_SIZE 10
 
+//How many documents INSERTBATCH inserts at a time when no batch size is given
+#define INSERT_BATCH_SIZE 1000
+//How many documents BULKBUILD inverts into each sorted run when no run size is given
+#define BULK_RUN_SIZE 100000
+//Bytes of compressed blocks a posting list being merged from runs keeps in memory before spilling them to disk
+#define MERGE_SPILL_BYTES (16UL * 1024 * 1024)
+
+//An in-memory posting list is rebuilt once its side buffer of out of order postings holds more than
+//MEMTABLE_SIDE_MIN postings and more than 1/MEMTABLE_SIDE_RATIO of the postings in its sorted run
+#define MEMTABLE_SIDE_MIN 64
+#define MEMTABLE_SIDE_RATIO 8
+
+//How many query results are cached
+#define RESULT_CACHE_SIZE 1024
+//Memory (in bytes) used to cache decoded static posting blocks
+#define BLOCK_CACHE_BYTES (64UL * 1024 * 1024)
+//Memory (in bytes) used to cache compiled translations
+#define TRANSLATION_CACHE_BYTES (64UL * 1024 * 1024)
+//Documents with more translations than this are not compiled, as their maps would take O(n^2) memory
+#define TRANSLATION_COMPILE_LIMIT 128
+
 //How many postings are required to get an entry into the extended lexicon
 #define SPARSE_SIZE 100
 //How many postings must be accumulated without a big entry to insert another pointer
 #define SPARSE_BETWEEN_SIZE 100
 
+//Gzip input is decompressed on a background thread in chunks of GZIP_CHUNK_SIZE bytes, which stays at most
+//GZIP_QUEUE_CHUNKS chunks ahead of the reader
+#define GZIP_CHUNK_SIZE (1UL << 20)
+#define GZIP_QUEUE_CHUNKS 8
+
 #include <vector>
 #include <map>
 #include <queue>
 #include <limits>
+#include <string>
 
 //Type Aliases
 
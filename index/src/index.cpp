@@ -2,26 +2,225 @@
 
 #include <sys/stat.h>
 #include <fstream>
+#include <algorithm>
+#include <numeric>
+#include <unordered_set>
+#include <stdexcept>
 
 #include "utility/util.hpp"
+#include "utility/metrics.hpp"
+#include "utility/parallel.hpp"
 #include "query_processing/DAAT.hpp"
 #include "redis.hpp"
 
 std::vector<unsigned int> Index::query(std::vector<std::string> words) {
+    QueryStats stats;
+    return query(words, stats);
+}
+
+std::vector<unsigned int> Index::query(std::vector<std::string> words, QueryStats& stats) {
+    static Metrics::Counter& querycount = Metrics::counter("query.count");
+    static Metrics::Histogram& totalhist = Metrics::histogram("query.total_ns");
+    static Metrics::Histogram& lexiconhist = Metrics::histogram("query.lexicon_ns");
+    static Metrics::Histogram& openhist = Metrics::histogram("query.open_lists_ns");
+    static Metrics::Histogram& traversehist = Metrics::histogram("query.traverse_ns");
+    static Metrics::Histogram& scorehist = Metrics::histogram("query.score_ns");
+    static Metrics::Histogram& listshist = Metrics::histogram("query.lists_opened");
+    static Metrics::Histogram& blockshist = Metrics::histogram("query.blocks_decoded");
+    static Metrics::Histogram& scannedhist = Metrics::histogram("query.postings_scanned");
+    static Metrics::Histogram& scoredhist = Metrics::histogram("query.docs_scored");
+    static Metrics::Counter& cachehits = Metrics::counter("query.result_cache_hits");
+    static Metrics::Counter& blockcachehits = Metrics::counter("query.block_cache_hits");
+
+    Metrics::ScopedTimer total(totalhist);
+    querycount.add();
+
+    //The snapshot is taken under the shared lock, so it sees either all or none of each inserted document
+    IndexSnapshot snapshot;
+    {
+        Metrics::ScopedTimer lexicontimer(lexiconhist);
+        for(size_t i = 0; i < words.size(); ++i)
+            std::transform(words[i].begin(), words[i].end(), words[i].begin(), ::tolower);
+
+        std::shared_lock<std::shared_timed_mutex> guard(snapshotlock);
+        for(size_t i = 0; i < words.size(); ++i) {
+            const Lex_data* entry = lex.find(words[i]);
+            //A word that was never indexed can't match any document
+            if(entry == nullptr) {
+                stats.lexiconns += lexicontimer.elapsed();
+                stats.totalns += total.elapsed();
+                return std::vector<unsigned int>();
+            }
+
+            std::shared_ptr<const NonPosMemtable::PostingList> memlist = nonpositional_index->find(entry->termid);
+            snapshot.terms.push_back(SnapshotTerm{entry->termid, (unsigned int)entry->f_t, memlist,
+                memlist == nullptr ? 0 : memlist->sortedSize(), memlist == nullptr ? 0 : memlist->sideSize(), nullptr});
+        }
+        snapshot.memtable = nonpositional_index;
+        snapshot.files = nonpositional_files;
+        snapshot.blockcache = &staticwriter.getBlockCache();
+        snapshot.doclengths = doclengths;
+        snapshot.avgdoclength = doccount == 0 ? 0 : totaldoclength / (double)doccount;
+        snapshot.doccount = doccount;
+        snapshot.generation = generation;
+        guard.unlock();
+
+        //Terms are sorted so that queries with the same words in a different order share a cache entry
+        std::sort(snapshot.terms.begin(), snapshot.terms.end(), [](const SnapshotTerm& lhs, const SnapshotTerm& rhs) {
+            return lhs.termID < rhs.termID;
+        });
+        stats.lexiconns += lexicontimer.elapsed();
+    }
+
     std::vector<unsigned int> termIDs;
-    std::vector<unsigned int> docscontaining;
-    for(size_t i = 0; i < words.size(); ++i) {
-        std::transform(words[i].begin(), words[i].end(), words[i].begin(), ::tolower);
-        Lex_data entry = lex.getEntry(words[i]);
-        termIDs.push_back(entry.termid);
-        docscontaining.push_back(entry.f_t);
+    for(auto& term : snapshot.terms)
+        termIDs.push_back(term.termID);
+
+    {
+        std::lock_guard<std::mutex> guard(cachelock);
+        //Queries with an older snapshot neither read nor fill the cache once a newer one has moved it on
+        if(resultcache_generation < snapshot.generation) {
+            resultcache.clear();
+            resultcache_generation = snapshot.generation;
+        }
+        std::vector<unsigned int>* cached = nullptr;
+        if(resultcache_generation == snapshot.generation)
+            cached = resultcache.get(termIDs);
+        if(cached) {
+            stats.cachedresult = true;
+            stats.totalns += total.elapsed();
+            cachehits.add();
+            return *cached;
+        }
     }
 
-    return DAAT(termIDs, docscontaining, nonpositional_index, *(staticwriter.getExLexPointer()),
-        working_dir+GlobalConst::NonPosPath, docstore);
+    std::vector<unsigned int> docs = DAAT(snapshot, stats);
+    {
+        std::lock_guard<std::mutex> guard(cachelock);
+        if(resultcache_generation == snapshot.generation)
+            resultcache.put(termIDs, docs);
+    }
+    stats.totalns += total.elapsed();
+
+    openhist.record(stats.openns);
+    traversehist.record(stats.traversens);
+    scorehist.record(stats.scorens);
+    listshist.record(stats.listsopened);
+    blockshist.record(stats.blocksdecoded);
+    scannedhist.record(stats.postingsscanned);
+    scoredhist.record(stats.docsscored);
+    blockcachehits.add(stats.blockcachehits);
+
+    return docs;
+}
+
+std::vector<unsigned int> Index::phrase_query(std::vector<std::string> words) {
+    QueryStats stats;
+    return positional_query(words, PositionalOperator::PHRASE, 0, stats);
+}
+
+std::vector<unsigned int> Index::proximity_query(std::vector<std::string> words, unsigned int window) {
+    QueryStats stats;
+    return positional_query(words, PositionalOperator::PROXIMITY, window, stats);
 }
 
-Index::Index(std::string directory) : docstore(), transtable(), lex(), staticwriter(directory) {
+std::vector<unsigned int> Index::positional_query(std::vector<std::string> words, PositionalOperator op, unsigned int window,
+    QueryStats& stats)
+{
+    static Metrics::Counter& querycount = Metrics::counter("positional_query.count");
+    static Metrics::Histogram& totalhist = Metrics::histogram("positional_query.total_ns");
+    static Metrics::Histogram& blockshist = Metrics::histogram("positional_query.blocks_decoded");
+    static Metrics::Histogram& positionshist = Metrics::histogram("positional_query.positions_read");
+    static Metrics::Histogram& scoredhist = Metrics::histogram("positional_query.docs_scored");
+
+    Metrics::ScopedTimer total(totalhist);
+    querycount.add();
+
+    //Terms stay in query order, and a word may appear more than once
+    IndexSnapshot snapshot;
+    std::vector<std::shared_ptr<std::vector<Posting>>> memlists;
+    {
+        auto lexiconbegin = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < words.size(); ++i)
+            std::transform(words[i].begin(), words[i].end(), words[i].begin(), ::tolower);
+
+        std::shared_lock<std::shared_timed_mutex> guard(snapshotlock);
+        for(size_t i = 0; i < words.size(); ++i) {
+            const Lex_data* entry = lex.find(words[i]);
+            if(entry == nullptr) {
+                stats.lexiconns += Metrics::nanosSince(lexiconbegin);
+                stats.totalns += total.elapsed();
+                return std::vector<unsigned int>();
+            }
+
+            //The in-memory positional index is neither sorted nor safe to read without the lock, so it is copied,
+            //unless a query since the last insertion already sorted a copy
+            std::shared_ptr<const std::vector<Posting>> sortedlist;
+            std::shared_ptr<std::vector<Posting>> memlist;
+            auto iter = positional_lookup.find(entry->termid);
+            if(iter != positional_lookup.end()) {
+                std::lock_guard<std::mutex> sortedguard(sortedlock);
+                auto sortediter = sortedlists.find(entry->termid);
+                if(sortedlists_generation == generation && sortediter != sortedlists.end())
+                    sortedlist = sortediter->second;
+                else
+                    memlist = std::make_shared<std::vector<Posting>>(iter->second->second);
+            }
+            memlists.push_back(memlist);
+
+            SnapshotTerm term;
+            term.termID = entry->termid;
+            term.f_t = entry->f_t;
+            term.memlength = term.sidelength = 0;
+            term.poslist = sortedlist;
+            snapshot.terms.push_back(term);
+        }
+        snapshot.posfiles = positional_files;
+        snapshot.blockcache = &staticwriter.getBlockCache();
+        snapshot.generation = generation;
+        guard.unlock();
+
+        for(size_t i = 0; i < memlists.size(); ++i) {
+            if(memlists[i] != nullptr) {
+                std::stable_sort(memlists[i]->begin(), memlists[i]->end());
+                snapshot.terms[i].poslist = memlists[i];
+            }
+        }
+
+        //The sorted copies are reused by later queries until the next insertion
+        std::lock_guard<std::mutex> sortedguard(sortedlock);
+        if(sortedlists_generation < snapshot.generation) {
+            sortedlists.clear();
+            sortedlists_generation = snapshot.generation;
+        }
+        if(sortedlists_generation == snapshot.generation) {
+            for(size_t i = 0; i < memlists.size(); ++i) {
+                if(memlists[i] != nullptr)
+                    sortedlists.emplace(snapshot.terms[i].termID, memlists[i]);
+            }
+        }
+        stats.lexiconns += Metrics::nanosSince(lexiconbegin);
+    }
+
+    //Translations are read when a document is matched, so they may be newer than the postings of the snapshot
+    TranslationLookup translations = [this](unsigned int docID) {
+        return transtable.getCompiled(docID);
+    };
+    std::vector<unsigned int> docs = positionalDAAT(snapshot, op, window, translations, stats);
+    stats.totalns += total.elapsed();
+
+    blockshist.record(stats.blocksdecoded);
+    positionshist.record(stats.positionsread);
+    scoredhist.record(stats.docsscored);
+
+    return docs;
+}
+
+Index::Index(std::string directory, unsigned long postinglimit) : nonpositional_index(std::make_shared<NonPosMemtable>()),
+    doclengths(std::make_shared<DocLengthTable>()), totaldoclength(0), doccount(0), bulkfirstdocID(0),
+    posting_limit(postinglimit), postings_inserted(0), generation(0), resultcache(RESULT_CACHE_SIZE),
+    resultcache_generation(0), sortedlists_generation(0), docstore(), transtable(), lex(), staticwriter(directory)
+{
     working_dir = "./" + directory;
 
     //https://stackoverflow.com/a/4980833
@@ -41,98 +240,459 @@ Index::Index(std::string directory) : docstore(), transtable(), lex(), staticwri
 
     positional_size = 0;
     nonpositional_size = 0;
+    nonpositional_files = staticwriter.openNonPosFiles();
+    positional_files = staticwriter.openPosFiles();
 }
 
-void Index::insert_document(std::string& url, std::string& newpage) {
+void Index::insert_document(std::string& url, std::string_view newpage) {
+    static Metrics::Histogram& inserthist = Metrics::histogram("index.insert_document_ns");
+    Metrics::ScopedTimer timer(inserthist);
+
+    if(bulkInProgress())
+        throw std::logic_error("Error, documents can not be inserted until the bulk build is finished");
+
     std::string timestamp = Utility::getTimestamp();
 
     //Perform document analysis
     MatcherInfo results = indexUpdate(url, newpage, timestamp, docstore, transtable);
 
-    std::cerr << "Got P:" << results.Ppostings.size() << " NP:" << results.NPpostings.size() << " Postings" << std::endl;
+    std::cerr << "Got P:" << results.postings.positionalSize() << " NP:" << results.postings.nonPositionalSize() << " Postings" << std::endl;
 
     insertNPPostings(results);
     insertPPostings(results);
 }
 
-void Index::insertNPPostings(MatcherInfo& results) {
+void Index::insert_documents(std::vector<DocumentInput>& batch) {
+    static Metrics::Histogram& inserthist = Metrics::histogram("index.insert_documents_ns");
+    static Metrics::Counter& insertcount = Metrics::counter("index.batch_documents_inserted");
+    Metrics::ScopedTimer timer(inserthist);
+
+    if(bulkInProgress())
+        throw std::logic_error("Error, documents can not be inserted until the bulk build is finished");
+
+    std::string timestamp = Utility::getTimestamp();
+
+    for(auto& round : splitBatchRounds(batch)) {
+        std::vector<MatcherInfo> results = indexUpdateBatch(batch, round.first, round.second, timestamp, docstore,
+            transtable);
+        insertBatchPostings(results);
+        insertcount.add(round.second - round.first);
+    }
+}
+
+void Index::bulk_insert(std::vector<DocumentInput>& batch) {
+    static Metrics::Histogram& inserthist = Metrics::histogram("index.bulk_insert_ns");
+    static Metrics::Histogram& tokenizehist = Metrics::histogram("index.bulk_tokenize_ns");
+    static Metrics::Histogram& inverthist = Metrics::histogram("index.bulk_invert_ns");
+    static Metrics::Counter& insertcount = Metrics::counter("index.bulk_documents_inserted");
+    Metrics::ScopedTimer timer(inserthist);
+
+    if(batch.empty())
+        return;
+    if(staticwriter.getRunCount() == 0 && (doccount > 0 || nonpositional_size > 0 || positional_size > 0
+        || !nonpositional_files->empty() || !positional_files->empty()))
+        throw std::runtime_error("Error, bulk builds need an empty index");
+
+    //Everything is checked before anything is changed
+    std::vector<std::string> urls;
+    std::unordered_set<std::string_view> seen;
+    for(DocumentInput& input : batch) {
+        if(!seen.insert(input.url).second)
+            throw std::invalid_argument("Error, " + input.url + " appears twice in a bulk build");
+        urls.push_back(input.url);
+    }
+    for(DocumentTuple& olddoc : docstore.getDocuments(urls)) {
+        if(!olddoc.timestamp.empty())
+            throw std::invalid_argument("Error, a bulk build can not update a stored document");
+    }
+
+    std::string timestamp = Utility::getTimestamp();
+    //The store gives new documents consecutive docIDs, in order
+    unsigned int firstdocID = docstore.getNextDocID();
+
+    auto stagebegin = std::chrono::steady_clock::now();
+    std::vector<EncodedDocument> encoded(batch.size());
+    Utility::parallelFor(batch.size(), [&](size_t i) {
+        uint64_t hash = Utility::hashString(batch[i].page);
+        encoded[i] = StringEncoder(EncodedDocument(), batch[i].page).getNewVersion(hash);
+    });
+    tokenizehist.record(Metrics::nanosSince(stagebegin));
+
+    stagebegin = std::chrono::steady_clock::now();
+    //The lexicon is shared with queries, so termIDs are assigned in one pass under the lock
+    std::vector<std::vector<unsigned int>> termIDs(batch.size());
+    std::vector<size_t> pbegin(batch.size() + 1, 0);
+    std::vector<size_t> npbegin(batch.size() + 1, 0);
+    {
+        std::unique_lock<std::shared_timed_mutex> guard(snapshotlock);
+        for(size_t i = 0; i < batch.size(); ++i) {
+            for(const std::string& term : encoded[i].terms) {
+                Lex_data& entry = lex.getEntry(term);
+                entry.f_t++;
+                termIDs[i].push_back(entry.termid);
+            }
+            pbegin[i + 1] = pbegin[i] + encoded[i].stream.size();
+            npbegin[i + 1] = npbegin[i] + encoded[i].terms.size();
+
+            doccount++;
+            totaldoclength += encoded[i].stream.size();
+            doclengths->set(firstdocID + i, encoded[i].stream.size());
+        }
+        generation++;
+    }
+
+    //Every term of a new document is in its first fragment, with one positional posting per occurrence
+    std::vector<Posting> ppostings(pbegin.back());
+    std::vector<nPosting> nppostings(npbegin.back());
+    Utility::parallelFor(batch.size(), [&](size_t i) {
+        unsigned int docID = firstdocID + i;
+        const std::vector<int>& stream = encoded[i].stream;
+        std::vector<unsigned int> freqs(encoded[i].terms.size(), 0);
+        Posting* out = ppostings.data() + pbegin[i];
+        for(size_t position = 0; position < stream.size(); ++position) {
+            freqs[stream[position]]++;
+            *out++ = Posting(termIDs[i][stream[position]], docID, 0, position);
+        }
+        for(size_t code = 0; code < freqs.size(); ++code)
+            nppostings[npbegin[i] + code] = nPosting(termIDs[i][code], docID, freqs[code]);
+    });
+
+    //Postings are already in docID order, so a stable sort on termID leaves every list sorted
+    std::stable_sort(ppostings.begin(), ppostings.end(), [](const Posting& a, const Posting& b) {
+        return a.termID < b.termID;
+    });
+    std::stable_sort(nppostings.begin(), nppostings.end(), [](const nPosting& a, const nPosting& b) {
+        return a.termID < b.termID;
+    });
+    staticwriter.write_run(ppostings);
+    staticwriter.write_run(nppostings);
+    inverthist.record(Metrics::nanosSince(stagebegin));
+
+    //Later versions of the documents are matched against these
+    std::vector<DocumentUpdate> updates;
+    for(size_t i = 0; i < batch.size(); ++i) {
+        int doclength = encoded[i].stream.size();
+        updates.push_back({batch[i].url, -1, std::move(encoded[i]), doclength, 0, timestamp});
+    }
+    docstore.insertDocuments(updates);
+
+    if(bulkurls.empty())
+        bulkfirstdocID = firstdocID;
+    for(DocumentInput& input : batch)
+        bulkurls.push_back(input.url);
+
+    postings_inserted += ppostings.size() + nppostings.size();
+    insertcount.add(batch.size());
+}
+
+bool Index::bulkInProgress() {
+    return staticwriter.getRunCount() > 0 || !bulkurls.empty();
+}
+
+void Index::bulk_finish(DocIDOrder order) {
+    static Metrics::Histogram& finishhist = Metrics::histogram("index.bulk_finish_ns");
+    Metrics::ScopedTimer timer(finishhist);
+
+    //docIDmap[docID] is the new docID of each document. Only the documents of the bulk build are renumbered
+    std::vector<unsigned int> docIDmap;
+    std::vector<std::pair<std::string, unsigned int>> moved;
+    if(order == DocIDOrder::URL && !bulkurls.empty()) {
+        std::vector<unsigned int> byurl(bulkurls.size());
+        std::iota(byurl.begin(), byurl.end(), 0);
+        std::sort(byurl.begin(), byurl.end(), [this](unsigned int a, unsigned int b) {
+            return bulkurls[a] < bulkurls[b];
+        });
+
+        docIDmap.resize(bulkfirstdocID + bulkurls.size());
+        std::iota(docIDmap.begin(), docIDmap.end(), 0);
+        for(size_t rank = 0; rank < byurl.size(); ++rank) {
+            unsigned int docID = bulkfirstdocID + rank;
+            docIDmap[bulkfirstdocID + byurl[rank]] = docID;
+            if(byurl[rank] != rank)
+                moved.emplace_back(bulkurls[byurl[rank]], docID);
+        }
+    }
+
+    staticwriter.merge_runs(posting_limit, docIDmap);
+    std::shared_ptr<const StaticFileSet> files = staticwriter.openNonPosFiles();
+    std::shared_ptr<const StaticFileSet> posfiles = staticwriter.openPosFiles();
+
+    //Bulk built documents have no translations, so only the store and the lengths follow the postings
+    std::shared_ptr<DocLengthTable> lengths = doclengths;
+    if(!moved.empty()) {
+        docstore.setDocIDs(moved);
+        lengths = std::make_shared<DocLengthTable>();
+        for(unsigned int docID = 0; docID < doclengths->size(); ++docID) {
+            int length = doclengths->get(docID);
+            if(length >= 0)
+                lengths->set(docID < docIDmap.size() ? docIDmap[docID] : docID, length);
+        }
+    }
+
+    std::unique_lock<std::shared_timed_mutex> guard(snapshotlock);
+    nonpositional_files = files;
+    positional_files = posfiles;
+    doclengths = lengths;
+    generation++;
+    guard.unlock();
+
+    bulkurls = std::vector<std::string>();
+}
+
+void Index::assignTermIDs(MatcherInfo& results) {
     bool isFirstDoc = (results.se.getOldSize() == 0);
-    //Insert NP postings
-    for(auto np_iter = results.NPpostings.begin(); np_iter != results.NPpostings.end(); np_iter++) {
-        Lex_data& entry = lex.getEntry(np_iter->second.term);
+
+    //Every term with postings has a nonpositional posting, so this looks up each term in the lexicon once
+    const PostingBatch& postings = results.postings;
+    results.termIDs.assign(results.se.getTermCount(), 0);
+    for(size_t i = 0; i < postings.nonPositionalSize(); ++i) {
+        unsigned int term = postings.npterms[i];
+        Lex_data& entry = lex.getEntry(results.se.getTerm(term));
+        results.termIDs[term] = entry.termid;
 
         //Update entry freq
         if(isFirstDoc)
             entry.f_t++;
         else
             //In old, not in new
-            if(results.se.inOld(np_iter->second.term) && !results.se.inNew(np_iter->second.term))
+            if(results.se.inOld(term))
                 entry.f_t--;
             //In new, not in old
-            else if(!results.se.inOld(np_iter->second.term) && results.se.inNew(np_iter->second.term))
+            else if(results.se.inNew(term))
                 entry.f_t++;
             //Don't change in other cases
+    }
+}
 
-        GlobalType::NonPosIndex::iterator insertioniter;
-
-        //Lookup where the posting list is in the index for the given termID
-        auto iter_lookup = nonpositional_lookup.find(entry.termid);
-        if(iter_lookup == nonpositional_lookup.end()) {
-            //Construct posting list for the term since it doesn't exist
-            auto results = nonpositional_index.emplace(std::make_pair(entry.termid, std::vector<nPosting>{}));
-            nonpositional_lookup[entry.termid] = results.first;
+void Index::insertNPPostings(MatcherInfo& results) {
+    static Metrics::Histogram& inserthist = Metrics::histogram("index.insert_np_postings_ns");
+    static Metrics::Counter& insertcount = Metrics::counter("index.np_postings_inserted");
+    Metrics::ScopedTimer timer(inserthist);
+
+    {
+        //Queries wait for the whole document, so they never see a partially inserted one
+        std::unique_lock<std::shared_timed_mutex> guard(snapshotlock);
+
+        //Insert NP postings
+        assignTermIDs(results);
+        const PostingBatch& postings = results.postings;
+        for(size_t i = 0; i < postings.nonPositionalSize(); ++i)
+            nonpositional_index->insert(nPosting(results.termIDs[postings.npterms[i]], postings.docID, postings.freqs[i]));
+        nonpositional_index->publish();
+
+        updateDocStats(results);
+        //Document statistics and the in-memory index changed
+        generation++;
+    }
 
-            insertioniter = results.first;
-        }
-        else {
-            insertioniter = iter_lookup->second;
-        }
+    nonpositional_size += results.postings.nonPositionalSize();
+    postings_inserted += results.postings.nonPositionalSize();
+    insertcount.add(results.postings.nonPositionalSize());
+    flushNonPositional();
+}
 
-        insertioniter->second.emplace_back(entry.termid, np_iter->second.docID, np_iter->second.freq);
-    }
+void Index::flushNonPositional() {
+    static Metrics::Gauge& memsize = Metrics::gauge("index.np_memory_postings");
 
-    nonpositional_size += results.NPpostings.size();
-    if(nonpositional_size > POSTING_LIMIT) {
+    if(nonpositional_size > posting_limit) {
         //when dynamic index cannot fit into memory, write to disk
+        //Queries keep reading the full memtable and the old files until the new files are published below
         std::cerr << "Writing non-positional index" << std::endl;
-        staticwriter.write_np_disk(nonpositional_index.begin(), nonpositional_index.end());
-        nonpositional_lookup.clear();
-        nonpositional_index.clear();
+        staticwriter.write_np_disk(*nonpositional_index);
+        std::shared_ptr<const StaticFileSet> files = staticwriter.openNonPosFiles();
+
+        std::unique_lock<std::shared_timed_mutex> guard(snapshotlock);
+        nonpositional_index = std::make_shared<NonPosMemtable>();
+        nonpositional_files = files;
+        generation++;
         nonpositional_size = 0;
     }
+    memsize.set(nonpositional_size);
 }
 
-void Index::insertPPostings(MatcherInfo& results) {
-    //Insert P postings
-    for(auto p_iter = results.Ppostings.begin(); p_iter != results.Ppostings.end(); p_iter++) {
-        Lex_data entry = lex.getEntry(p_iter->term);
+void Index::updateDocStats(MatcherInfo& results) {
+    bool isFirstDoc = (results.se.getOldSize() == 0);
+    int doclength = results.se.getNewSize();
 
-        GlobalType::PosIndex::iterator insertioniter;
+    if(isFirstDoc) {
+        doccount++;
+    }
+    else {
+        //Documents without a recorded length were counted in the average
+        int oldlength = doclengths->get(results.docID);
+        if(oldlength < 0)
+            oldlength = doccount == 0 ? 0 : totaldoclength / doccount;
+        totaldoclength -= std::min<unsigned long long>(oldlength, totaldoclength);
+    }
+    totaldoclength += doclength;
+    doclengths->set(results.docID, doclength);
+}
 
-        //Lookup where the posting list is in the index for the given termID
-        auto iter_lookup = positional_lookup.find(entry.termid);
-        if(iter_lookup == positional_lookup.end()) {
-            //Construct posting list for the term since it doesn't exist
-            auto results = positional_index.emplace(std::make_pair(entry.termid, std::vector<Posting>{}));
-            positional_lookup[entry.termid] = results.first;
+std::vector<Posting>& Index::getPositionalList(unsigned int termID) {
+    //Lookup where the posting list is in the index for the given termID
+    auto iter_lookup = positional_lookup.find(termID);
+    if(iter_lookup != positional_lookup.end())
+        return iter_lookup->second->second;
 
-            insertioniter = results.first;
-        }
-        else {
-            insertioniter = iter_lookup->second;
-        }
+    //Construct posting list for the term since it doesn't exist
+    auto results = positional_index.emplace(std::make_pair(termID, std::vector<Posting>{}));
+    positional_lookup[termID] = results.first;
+    return results.first->second;
+}
 
-        insertioniter->second.emplace_back(entry.termid, p_iter->docID, p_iter->fragID, p_iter->pos);
+void Index::insertPPostings(MatcherInfo& results) {
+    static Metrics::Histogram& inserthist = Metrics::histogram("index.insert_p_postings_ns");
+    static Metrics::Counter& insertcount = Metrics::counter("index.p_postings_inserted");
+    static Metrics::Counter& runcount = Metrics::counter("index.p_term_runs_inserted");
+    Metrics::ScopedTimer timer(inserthist);
+
+    //Group the postings by term, so each term's list is looked up once
+    const PostingBatch& postings = results.postings;
+    std::vector<unsigned int> runstarts;
+    std::vector<unsigned int> order = postings.groupPositional(results.se.getTermCount(), runstarts);
+
+    {
+        //Positional queries copy the in-memory lists
+        std::unique_lock<std::shared_timed_mutex> guard(snapshotlock);
+
+        //Insert P postings
+        //Their termIDs were looked up when the NP postings were inserted
+        for(size_t term = 0; term + 1 < runstarts.size(); ++term) {
+            if(runstarts[term] == runstarts[term + 1])
+                continue;
+            unsigned int termID = results.termIDs[term];
+
+            //Grow the list once for the whole run, then fill it in place
+            std::vector<Posting>& list = getPositionalList(termID);
+            size_t oldsize = list.size();
+            list.resize(oldsize + runstarts[term + 1] - runstarts[term]);
+            Posting* out = list.data() + oldsize;
+            for(unsigned int i = runstarts[term]; i < runstarts[term + 1]; ++i) {
+                unsigned int index = order[i];
+                *out++ = Posting(termID, postings.docID, postings.fragIDs[index], postings.positions[index]);
+            }
+            runcount.add();
+        }
     }
 
-    positional_size += results.Ppostings.size();
-    if(positional_size > POSTING_LIMIT) {
+    positional_size += postings.positionalSize();
+    postings_inserted += postings.positionalSize();
+    insertcount.add(postings.positionalSize());
+    flushPositional();
+}
+
+void Index::flushPositional() {
+    static Metrics::Gauge& memsize = Metrics::gauge("index.p_memory_postings");
+
+    if(positional_size > posting_limit) {
+        //Only the writer changes the positional index, so it can be written out without the lock
         std::cerr << "Writing positional index" << std::endl;
         staticwriter.write_p_disk(positional_index.begin(), positional_index.end());
+        std::shared_ptr<const StaticFileSet> files = staticwriter.openPosFiles();
+
+        std::unique_lock<std::shared_timed_mutex> guard(snapshotlock);
         positional_lookup.clear();
         positional_index.clear();
+        positional_files = files;
+        generation++;
         positional_size = 0;
     }
+    memsize.set(positional_size);
+}
+
+void Index::insertBatchPostings(std::vector<MatcherInfo>& batch) {
+    static Metrics::Histogram& inserthist = Metrics::histogram("index.insert_batch_postings_ns");
+    static Metrics::Counter& npcount = Metrics::counter("index.np_postings_inserted");
+    static Metrics::Counter& pcount = Metrics::counter("index.p_postings_inserted");
+    static Metrics::Counter& runcount = Metrics::counter("index.p_term_runs_inserted");
+    Metrics::ScopedTimer timer(inserthist);
+
+    //Group each document's positional postings by term before taking the lock
+    std::vector<std::vector<unsigned int>> orders(batch.size());
+    std::vector<std::vector<unsigned int>> runstarts(batch.size());
+    size_t npsize = 0;
+    size_t psize = 0;
+    for(size_t doc = 0; doc < batch.size(); ++doc) {
+        orders[doc] = batch[doc].postings.groupPositional(batch[doc].se.getTermCount(), runstarts[doc]);
+        npsize += batch[doc].postings.nonPositionalSize();
+        psize += batch[doc].postings.positionalSize();
+    }
+
+    {
+        //Queries see the whole batch at once
+        std::unique_lock<std::shared_timed_mutex> guard(snapshotlock);
+
+        //The nonpositional postings of every document are sorted by term, so each list is appended to in one go
+        std::vector<nPosting> nppostings;
+        nppostings.reserve(npsize);
+        for(MatcherInfo& results : batch) {
+            assignTermIDs(results);
+            const PostingBatch& postings = results.postings;
+            for(size_t i = 0; i < postings.nonPositionalSize(); ++i)
+                nppostings.emplace_back(results.termIDs[postings.npterms[i]], postings.docID, postings.freqs[i]);
+            updateDocStats(results);
+        }
+        std::sort(nppostings.begin(), nppostings.end(), [](const nPosting& a, const nPosting& b) {
+            return a.termID < b.termID || (a.termID == b.termID && a.docID < b.docID);
+        });
+        for(const nPosting& posting : nppostings)
+            nonpositional_index->insert(posting);
+        nonpositional_index->publish();
+
+        //The runs of a term from every document are appended together, with one list lookup and one resize
+        struct TermRun {
+            unsigned int termID;
+            unsigned int doc;
+            unsigned int term;
+        };
+        std::vector<TermRun> runs;
+        for(size_t doc = 0; doc < batch.size(); ++doc) {
+            const std::vector<unsigned int>& starts = runstarts[doc];
+            for(size_t term = 0; term + 1 < starts.size(); ++term) {
+                if(starts[term] != starts[term + 1])
+                    runs.push_back({batch[doc].termIDs[term], (unsigned int)doc, (unsigned int)term});
+            }
+        }
+        //Positional lists are lazily sorted, but keeping documents in batch order keeps them mostly sorted
+        std::sort(runs.begin(), runs.end(), [](const TermRun& a, const TermRun& b) {
+            return a.termID < b.termID || (a.termID == b.termID && a.doc < b.doc);
+        });
+
+        for(size_t first = 0; first < runs.size();) {
+            unsigned int termID = runs[first].termID;
+            size_t last = first;
+            size_t runlength = 0;
+            for(; last < runs.size() && runs[last].termID == termID; ++last)
+                runlength += runstarts[runs[last].doc][runs[last].term + 1] - runstarts[runs[last].doc][runs[last].term];
+
+            std::vector<Posting>& list = getPositionalList(termID);
+            size_t oldsize = list.size();
+            list.resize(oldsize + runlength);
+            Posting* out = list.data() + oldsize;
+            for(size_t run = first; run < last; ++run) {
+                const PostingBatch& postings = batch[runs[run].doc].postings;
+                const std::vector<unsigned int>& starts = runstarts[runs[run].doc];
+                const std::vector<unsigned int>& order = orders[runs[run].doc];
+                for(unsigned int i = starts[runs[run].term]; i < starts[runs[run].term + 1]; ++i) {
+                    unsigned int index = order[i];
+                    *out++ = Posting(termID, postings.docID, postings.fragIDs[index], postings.positions[index]);
+                }
+            }
+            runcount.add();
+            first = last;
+        }
+
+        generation++;
+    }
+
+    //Flushes are only checked once per batch
+    nonpositional_size += npsize;
+    positional_size += psize;
+    postings_inserted += npsize + psize;
+    npcount.add(npsize);
+    pcount.add(psize);
+    flushNonPositional();
+    flushPositional();
 }
 
 void Index::dump() {
@@ -146,10 +706,20 @@ void Index::dump() {
     jobject["positional_size"] = positional_size;
     jobject["nonpositional_size"] = nonpositional_size;
 
+    //Write document statistics
+    jobject["totaldoclength"] = totaldoclength;
+    jobject["doccount"] = doccount;
+    for(unsigned int docID = 0; docID < doclengths->size(); ++docID) {
+        int doclength = doclengths->get(docID);
+        if(doclength >= 0)
+            jobject["doclengths"][std::to_string(docID)] = doclength;
+    }
+
     //Write in-memory indexes
-    for(auto inditer = nonpositional_index.begin(); inditer != nonpositional_index.end(); inditer++) {
+    for(auto inditer = nonpositional_index->getLists().begin(); inditer != nonpositional_index->getLists().end(); inditer++) {
         std::string key = std::to_string(inditer->first);
-        for(auto postiter = inditer->second.begin(); postiter != inditer->second.end(); postiter++) {
+        std::vector<nPosting> postings = inditer->second->toVector();
+        for(auto postiter = postings.begin(); postiter != postings.end(); postiter++) {
             jobject["nonposindex"][key].push_back(nlohmann::json::object({
                 {"termID", postiter->termID},
                 {"docID", postiter->docID},
@@ -195,20 +765,23 @@ void Index::restore() {
     nonpositional_size = jobject["nonpositional_size"];
 
     //Read in-memory indexes
+    auto memtable = std::make_shared<NonPosMemtable>();
     auto jiter = jobject.find("nonposindex");
     if(jiter != jobject.end()) {
         for(auto inditer = jiter->begin(); inditer != jiter->end(); inditer++) {
-            unsigned int key = std::stoul(inditer.key());
-            std::vector<nPosting> data;
-
             for(auto dataiter = inditer->begin(); dataiter != inditer->end(); dataiter++) {
-                data.emplace_back(dataiter->at("termID"), dataiter->at("docID"), dataiter->at("frequency"));
+                memtable->insert(nPosting(dataiter->at("termID"), dataiter->at("docID"), dataiter->at("frequency")));
             }
-
-            nonpositional_index[key] = data;
         }
     }
+    memtable->publish();
 
+    std::shared_ptr<const StaticFileSet> files = staticwriter.openNonPosFiles(true);
+    std::shared_ptr<const StaticFileSet> posfiles = staticwriter.openPosFiles(true);
+
+    std::unique_lock<std::shared_timed_mutex> guard(snapshotlock);
+    positional_index.clear();
+    positional_lookup.clear();
     jiter = jobject.find("posindex");
     if(jiter != jobject.end()) {
         for(auto inditer = jiter->begin(); inditer != jiter->end(); inditer++) {
@@ -223,22 +796,55 @@ void Index::restore() {
                     dataiter->at("position"));
             }
 
-            positional_index[key] = data;
+            positional_lookup[key] = positional_index.emplace(key, data).first;
         }
     }
+    positional_files = posfiles;
+    guard.unlock();
 
     redisRestoreDatabase(working_dir + "/dump.rdb");
+
+    //Read document statistics. Dumps without them fall back to the averages kept by the document store
+    auto lengths = std::make_shared<DocLengthTable>();
+    unsigned long long totallength;
+    size_t count;
+    jiter = jobject.find("doclengths");
+    if(jiter != jobject.end()) {
+        for(auto lengthiter = jiter->begin(); lengthiter != jiter->end(); lengthiter++)
+            lengths->set(std::stoul(lengthiter.key()), lengthiter.value());
+        totallength = jobject["totaldoclength"];
+        count = jobject["doccount"];
+    }
+    else {
+        count = docstore.getDocumentCount();
+        totallength = docstore.getAverageDocLength() * count;
+    }
+
+    guard.lock();
+    nonpositional_index = memtable;
+    nonpositional_files = files;
+    doclengths = lengths;
+    totaldoclength = totallength;
+    doccount = count;
+    generation++;
 }
 
 void Index::clear() {
-    positional_index.clear();
-    nonpositional_index.clear();
     positional_size = nonpositional_size = 0;
     
     docstore.clear();
     transtable.clear();
-    lex.clear();
     staticwriter.getExLexPointer()->clear();
+
+    std::unique_lock<std::shared_timed_mutex> guard(snapshotlock);
+    positional_index.clear();
+    positional_lookup.clear();
+    nonpositional_index = std::make_shared<NonPosMemtable>();
+    doclengths = std::make_shared<DocLengthTable>();
+    totaldoclength = 0;
+    doccount = 0;
+    lex.clear();
+    generation++;
 }
 
 void Index::printSize() {
@@ -251,4 +857,17 @@ void Index::printSize() {
     staticwriter.getExLexPointer()->printSize();
 
     std::cerr << "redis avgdoclength: " << docstore.getAverageDocLength() << std::endl;
+}
+
+unsigned long long Index::getPostingsInserted() {
+    return postings_inserted;
+}
+
+const StaticIndex::IOStats& Index::getStaticStats() {
+    return staticwriter.getStats();
+}
+
+unsigned long long Index::getGeneration() {
+    std::shared_lock<std::shared_timed_mutex> guard(snapshotlock);
+    return generation;
 }
\ No newline at end of file
@@ -3,6 +3,10 @@
 
 #include <vector>
 #include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
 
 #include "libs/sparsepp/spp.h"
 #include "lexicon.hpp"
@@ -12,15 +16,62 @@
 #include "global_parameters.hpp"
 #include "doc_analyzer/analyzer.h"
 #include "posting.hpp"
+#include "query_processing/query_stats.hpp"
+#include "query_processing/positional_DAAT.hpp"
+#include "Structures/memtable.h"
+#include "Structures/doclengthtable.h"
+#include "utility/lru_cache.hpp"
+
+struct TermIDsHash {
+    size_t operator()(const std::vector<unsigned int>& termIDs) const {
+        size_t h = termIDs.size();
+        for(unsigned int termID : termIDs)
+            h = h * 31 + termID;
+        return h;
+    }
+};
+
+//How a bulk build numbers its documents
+enum class DocIDOrder {
+    //In the order they were inserted
+    ARRIVAL,
+    //In url order, so that pages of the same site, which share many terms, get nearby docIDs. The smaller gaps
+    //between docIDs compress better
+    URL
+};
 
 //This index does not use compression
+//Queries may run from any number of threads while one thread inserts documents. Each query reads a snapshot of the
+//index taken when it starts, so it never sees a document that is only partially inserted
 class Index {
 public:
     //Directory is simply a name that the index will save all of its files under
-    Index(std::string directory);
-    void insert_document(std::string& url, std::string& newpage);
+    //postinglimit is how many postings each in-memory index may hold before it is written to disk
+    Index(std::string directory, unsigned long postinglimit = POSTING_LIMIT);
+    //Both insert functions throw std::logic_error while a bulk build is in progress
+    void insert_document(std::string& url, std::string_view newpage);
+    //Inserts every document of the batch, in order. Pages are analyzed in parallel, the document store and
+    //translation table are updated with one round trip per batch, and flushes are only checked once per batch.
+    //Queries see the batch all at once. A url that appears again is inserted after the documents before it
+    void insert_documents(std::vector<DocumentInput>& batch);
+    //Bulk build of an empty index. Every url must be new, so pages are tokenized in parallel without matching, and
+    //each batch is inverted by sorting its postings into a sorted run on disk. Queries only see the postings once
+    //bulk_finish merges all runs into one index, and nothing else may be inserted until then
+    void bulk_insert(std::vector<DocumentInput>& batch);
+    //Documents are renumbered in the given order, in the postings, the document store and the document lengths
+    void bulk_finish(DocIDOrder order = DocIDOrder::ARRIVAL);
     //Temporary return type: returns docIDs for now
     std::vector<unsigned int> query(std::vector<std::string> words);
+    //Same as above, but also reports the work done by the query in stats
+    std::vector<unsigned int> query(std::vector<std::string> words, QueryStats& stats);
+
+    //Documents containing the words next to each other, in the given order, ranked by number of occurrences
+    std::vector<unsigned int> phrase_query(std::vector<std::string> words);
+    //Documents containing every word within a window of window consecutive words, ranked by number of such windows
+    std::vector<unsigned int> proximity_query(std::vector<std::string> words, unsigned int window);
+    //Evaluates either of the above, and reports the work done by the query in stats. Results are not cached
+    std::vector<unsigned int> positional_query(std::vector<std::string> words, PositionalOperator op, unsigned int window,
+        QueryStats& stats);
 
     void dump();
     void restore();
@@ -28,21 +79,72 @@ public:
 
     void printSize();
 
+    //Totals used for benchmarking
+    unsigned long long getPostingsInserted();
+    const StaticIndex::IOStats& getStaticStats();
+
+    //Changes whenever the result of a query could change: on every insertion (which also covers flushes and merges),
+    //restore and clear
+    unsigned long long getGeneration();
+
 private:
+    //Also fills in the termIDs of the results, so it must be called before insertPPostings
     void insertNPPostings(MatcherInfo& results);
     void insertPPostings(MatcherInfo& results);
+    //Inserts the postings of many documents, merged by term
+    void insertBatchPostings(std::vector<MatcherInfo>& batch);
+    //Whether bulk_insert has written runs that bulk_finish has not merged yet
+    bool bulkInProgress();
+
+    //Looks up the termID of each term with postings, and updates the document frequencies in the lexicon.
+    //Must hold snapshotlock
+    void assignTermIDs(MatcherInfo& results);
+    //Creates the in-memory list if the term has none. Must hold snapshotlock
+    std::vector<Posting>& getPositionalList(unsigned int termID);
+    //Write the in-memory index to disk if it holds more than posting_limit postings
+    void flushNonPositional();
+    void flushPositional();
+
+    //Records the length of a newly analyzed document in the document statistics used for ranking
+    void updateDocStats(MatcherInfo& results);
 
     //Data structures
-    //Note: Posting lists are *lazily sorted*, that is, docIDs are stored randomly until they need to be sorted.
-    //Indexes on disk are guaranteed to be sorted (due to delta compression)
+    //Everything below that queries read is replaced or changed only while the writer holds snapshotlock exclusively.
+    //Queries hold it shared just long enough to take a snapshot, then run without it
+    std::shared_timed_mutex snapshotlock;
+    std::shared_ptr<NonPosMemtable> nonpositional_index;
+    std::shared_ptr<const StaticFileSet> nonpositional_files;
+
+    //Note: Positional posting lists are *lazily sorted*, that is, docIDs are stored randomly until they need to be
+    //sorted. Positional queries sort a copy of the lists they read, which later queries share until the next
+    //insertion (see sortedlists), and indexes on disk are guaranteed to be sorted (due to delta compression)
     GlobalType::PosIndex positional_index;
-    GlobalType::NonPosIndex nonpositional_index;
-    
     spp::sparse_hash_map<unsigned int, GlobalType::PosIndex::iterator> positional_lookup;
-    spp::sparse_hash_map<unsigned int, GlobalType::NonPosIndex::iterator> nonpositional_lookup;
+    std::shared_ptr<const StaticFileSet> positional_files;
+
+    //Document statistics, kept in memory so that queries never wait on the document store
+    std::shared_ptr<DocLengthTable> doclengths;
+    unsigned long long totaldoclength;
+    size_t doccount;
+
+    //Url of every document of the bulk build in progress, in docID order starting at bulkfirstdocID
+    std::vector<std::string> bulkurls;
+    unsigned int bulkfirstdocID;
 
     unsigned long positional_size;
     unsigned long nonpositional_size;
+    unsigned long posting_limit;
+    unsigned long long postings_inserted;
+
+    unsigned long long generation;
+    //Query results keyed by the sorted termIDs of the query. Only valid for resultcache_generation
+    std::mutex cachelock;
+    Utility::LRUCache<std::vector<unsigned int>, std::vector<unsigned int>, TermIDsHash> resultcache;
+    unsigned long long resultcache_generation;
+    //Sorted copies of in-memory positional lists, keyed by termID. Only valid for sortedlists_generation
+    std::mutex sortedlock;
+    std::unordered_map<unsigned int, std::shared_ptr<const std::vector<Posting>>> sortedlists;
+    unsigned long long sortedlists_generation;
 
     std::string working_dir;
 
@@ -4,7 +4,7 @@ using namespace std;
 
 Lexicon::Lexicon() : nextID(0) {}
 
-Lex_data& Lexicon::getEntry(string& term) {
+Lex_data& Lexicon::getEntry(const string& term) {
     auto iter = lex.find(term);
     if(iter == lex.end()) {
         iter = initEntry(term);
@@ -12,8 +12,15 @@ Lex_data& Lexicon::getEntry(string& term) {
     return iter->second;
 }
 
+const Lex_data* Lexicon::find(const string& term) const {
+    auto iter = lex.find(term);
+    if(iter == lex.end())
+        return nullptr;
+    return &iter->second;
+}
+
 //term must *NOT* exist inside of the lexicon already
-spp::sparse_hash_map<std::string, Lex_data>::iterator Lexicon::initEntry(string& term) {
+spp::sparse_hash_map<std::string, Lex_data>::iterator Lexicon::initEntry(const string& term) {
     auto results = lex.emplace(term, Lex_data{nextID, 0});
     nextID++;
     return results.first;
@@ -21,7 +21,9 @@ class Lexicon {
 public:
     Lexicon();
 
-    Lex_data& getEntry(std::string& term);
+    Lex_data& getEntry(const std::string& term);
+    //Returns nullptr if the term is not in the lexicon. Unlike getEntry, it never adds the term
+    const Lex_data* find(const std::string& term) const;
 
     //Dumps contents of lexicon into given json, under the object "lexicon"
     void dump(nlohmann::json& jobject);
@@ -32,7 +34,7 @@ public:
     size_t getSize();
 
 private:
-    spp::sparse_hash_map<std::string, Lex_data>::iterator initEntry(std::string& term);
+    spp::sparse_hash_map<std::string, Lex_data>::iterator initEntry(const std::string& term);
     
     spp::sparse_hash_map<std::string, Lex_data> lex;
     unsigned int nextID;
@@ -18,8 +18,8 @@ std::string getTokenWhitespace(std::string::iterator& iter, std::string::iterato
     return std::string(tokenstart, iter);
 }
 
-DocumentMorpher::DocumentMorpher(std::string& from, std::string& to, int numversions) :
-    olddoc(from), newdoc(to), versionsleft(numversions+1), gen((std::random_device())()), dis(0, 1.0)
+DocumentMorpher::DocumentMorpher(std::string& from, std::string& to, int numversions, unsigned long seed) :
+    olddoc(from), newdoc(to), versionsleft(numversions+1), gen(seed), dis(0, 1.0)
 {
     std::istringstream oldstream(olddoc);
     std::istringstream newstream(newdoc);
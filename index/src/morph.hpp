@@ -7,7 +7,8 @@
 
 class DocumentMorpher {
 public:
-    DocumentMorpher(std::string& from, std::string& to, int numversions);
+    //seed can be fixed to generate the same sequence of versions every run
+    DocumentMorpher(std::string& from, std::string& to, int numversions, unsigned long seed = std::random_device()());
 
     std::string getDocument();
     void nextVersion();
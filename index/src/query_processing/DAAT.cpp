@@ -2,6 +2,7 @@
 
 #include "query_primitive.hpp"
 #include "ranking_functions/BM25.hpp"
+#include "utility/metrics.hpp"
 
 struct ScorePair {
     ScorePair() {}
@@ -18,21 +19,29 @@ public:
     }
 };
 
-std::vector<unsigned int> DAAT(std::vector<unsigned int>& termIDs, std::vector<unsigned int>& docscontaining,
-    GlobalType::NonPosIndex& index, SparseExtendedLexicon& exlex, std::string staticpath, DocumentStore& docstore)
-{
-    if(termIDs.empty()) {
+std::vector<unsigned int> DAAT(const IndexSnapshot& snapshot, QueryStats& stats) {
+    if(snapshot.terms.empty()) {
         return std::vector<unsigned int>();
     }
 
+    std::vector<unsigned int> docscontaining;
+    for(const SnapshotTerm& term : snapshot.terms)
+        docscontaining.push_back(term.f_t);
+
     std::priority_queue<ScorePair, std::vector<ScorePair>, greater_ScorePair> minheap;
 
     std::vector<query_primitive> listpointers;
 
     //Construct listpointers for each termID
-    for(unsigned int i : termIDs) {
-        listpointers.emplace_back(i, index, exlex, staticpath);
+    auto openbegin = std::chrono::steady_clock::now();
+    for(const SnapshotTerm& term : snapshot.terms) {
+        listpointers.emplace_back(term, snapshot, stats);
     }
+    stats.openns += Metrics::nanosSince(openbegin);
+
+    //Scoring time is measured separately and taken out of the traversal time afterwards
+    long long scorens = 0;
+    auto traversebegin = std::chrono::steady_clock::now();
 
     unsigned int did = 0;
 
@@ -48,6 +57,7 @@ std::vector<unsigned int> DAAT(std::vector<unsigned int>& termIDs, std::vector<u
         if(d > did)
             did = d;
         else {
+            auto scorebegin = std::chrono::steady_clock::now();
             std::vector<unsigned int> freqs;
             /* docID is in intersection; now get all frequencies */
             for(size_t i = 0; i < listpointers.size(); i++)
@@ -55,7 +65,11 @@ std::vector<unsigned int> DAAT(std::vector<unsigned int>& termIDs, std::vector<u
 
             /* compute BM25 score from frequencies and other data */
             //TODO: Allow other ranking functions here
-            double score = BM25(freqs, docscontaining, docstore.getDocLength(did), docstore.getAverageDocLength(), docstore.getDocumentCount()); 
+            //Documents without a recorded length (from an index restored without them) get the average length
+            int doclength = snapshot.doclengths->get(did);
+            if(doclength < 0)
+                doclength = snapshot.avgdoclength;
+            double score = BM25(freqs, docscontaining, doclength, snapshot.avgdoclength, snapshot.doccount);
 
             if(minheap.size() < DAAT_SIZE) {
                 minheap.emplace(did, score);
@@ -64,10 +78,15 @@ std::vector<unsigned int> DAAT(std::vector<unsigned int>& termIDs, std::vector<u
                 minheap.pop();
                 minheap.emplace(did, score);
             }
+            stats.docsscored++;
+            scorens += Metrics::nanosSince(scorebegin);
             did++; /* and increase did to search for next post */
         }
     }
 
+    stats.traversens += Metrics::nanosSince(traversebegin) - scorens;
+    stats.scorens += scorens;
+
     std::vector<unsigned int> docs;
     docs.reserve(DAAT_SIZE);
     while(!minheap.empty()) {
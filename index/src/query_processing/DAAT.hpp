@@ -4,12 +4,13 @@
 #include <vector>
 #include <unordered_map>
 
-#include "sparse_lexicon.hpp"
 #include "global_parameters.hpp"
-#include "Structures/documentstore.h"
+#include "snapshot.hpp"
+#include "query_stats.hpp"
 
 //Returns the vector of docIDs that were found, from low-high
-std::vector<unsigned int> DAAT(std::vector<unsigned int>& termIDs, std::vector<unsigned int>& docscontaining,
-    GlobalType::NonPosIndex& index, SparseExtendedLexicon& exlex, std::string staticpath, DocumentStore& docstore);
+//Only reads from the snapshot, so any number of queries can run at the same time as the index writer
+//List opening, traversal and scoring work is added to stats
+std::vector<unsigned int> DAAT(const IndexSnapshot& snapshot, QueryStats& stats);
 
 #endif
\ No newline at end of file
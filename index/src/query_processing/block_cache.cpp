@@ -0,0 +1,113 @@
+#include "block_cache.hpp"
+
+#include "utility/metrics.hpp"
+
+namespace {
+
+//Approximate memory used by a cached block, including bookkeeping
+size_t blockBytes(const DecodedBlock& block) {
+    return block->capacity() * sizeof(unsigned int) + sizeof(std::vector<unsigned int>) + 64;
+}
+
+}
+
+BlockCache::BlockCache(size_t capacitybytes) : capacity(capacitybytes), shardcapacity(capacitybytes / SHARD_COUNT) {
+    for(Shard& shard : shards)
+        shard.hand = shard.ring.end();
+}
+
+BlockCache::Shard& BlockCache::getShard(const BlockKey& key) {
+    //Use the high bits, the low bits are used by the shard's own hash table
+    return shards[(BlockKeyHash()(key) >> 40) % SHARD_COUNT];
+}
+
+DecodedBlock BlockCache::get(const BlockKey& key) {
+    static Metrics::Counter& hits = Metrics::counter("blockcache.hits");
+    static Metrics::Counter& misses = Metrics::counter("blockcache.misses");
+
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    auto iter = shard.lookup.find(key);
+    if(iter == shard.lookup.end()) {
+        misses.add();
+        return nullptr;
+    }
+
+    hits.add();
+    iter->second->referenced = true;
+    return iter->second->block;
+}
+
+void BlockCache::put(const BlockKey& key, DecodedBlock block) {
+    static Metrics::Gauge& cachebytes = Metrics::gauge("blockcache.bytes");
+
+    size_t bytes = blockBytes(block);
+    if(bytes > shardcapacity)
+        return;
+
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    //Another query may have decoded the same block in the meantime
+    if(shard.lookup.find(key) != shard.lookup.end())
+        return;
+
+    makeRoom(shard, bytes);
+
+    //New entries go right behind the hand so that they are the last to be considered for eviction
+    auto inserted = shard.ring.insert(shard.hand, Entry{key, block, bytes, false});
+    shard.lookup.emplace(key, inserted);
+    shard.bytes += bytes;
+    cachebytes.add(bytes);
+}
+
+void BlockCache::makeRoom(Shard& shard, size_t bytes) {
+    static Metrics::Counter& evictions = Metrics::counter("blockcache.evictions");
+    static Metrics::Gauge& cachebytes = Metrics::gauge("blockcache.bytes");
+
+    while(shard.bytes + bytes > shardcapacity && !shard.ring.empty()) {
+        if(shard.hand == shard.ring.end())
+            shard.hand = shard.ring.begin();
+
+        if(shard.hand->referenced) {
+            //Give the block a second chance
+            shard.hand->referenced = false;
+            ++shard.hand;
+        }
+        else {
+            shard.bytes -= shard.hand->bytes;
+            cachebytes.add(-(long long)shard.hand->bytes);
+            evictions.add();
+
+            shard.lookup.erase(shard.hand->key);
+            shard.hand = shard.ring.erase(shard.hand);
+        }
+    }
+}
+
+void BlockCache::clear() {
+    static Metrics::Gauge& cachebytes = Metrics::gauge("blockcache.bytes");
+
+    for(Shard& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        cachebytes.add(-(long long)shard.bytes);
+        shard.lookup.clear();
+        shard.ring.clear();
+        shard.hand = shard.ring.end();
+        shard.bytes = 0;
+    }
+}
+
+size_t BlockCache::getBytes() {
+    size_t total = 0;
+    for(Shard& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        total += shard.bytes;
+    }
+    return total;
+}
+
+size_t BlockCache::getCapacity() {
+    return capacity;
+}
\ No newline at end of file
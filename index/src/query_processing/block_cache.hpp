@@ -0,0 +1,83 @@
+#ifndef BLOCK_CACHE_HPP
+#define BLOCK_CACHE_HPP
+
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+//Blocks are shared so that a query can keep using a block after it is evicted
+using DecodedBlock = std::shared_ptr<const std::vector<unsigned int>>;
+
+//Identifies a decoded docID or frequency block of a static posting list
+//generation identifies the index file, since file names are reused after merges; offset is where the block starts in the file
+struct BlockKey {
+    unsigned long generation;
+    unsigned long offset;
+
+    bool operator==(const BlockKey& rhs) const {
+        return generation == rhs.generation && offset == rhs.offset;
+    }
+};
+
+struct BlockKeyHash {
+    size_t operator()(const BlockKey& key) const {
+        //Mix the bits so that blocks of the same file spread over all shards
+        unsigned long long h = key.generation * 0x9E3779B97F4A7C15ULL + key.offset;
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDULL;
+        h ^= h >> 33;
+        return h;
+    }
+};
+
+/**
+ * Cache of decompressed static posting blocks shared by all queries, bounded by the memory used by the blocks.
+ * The cache is split into shards, each with its own lock, so concurrent queries rarely wait on each other.
+ * Each shard evicts with the CLOCK algorithm: a hit only sets a reference bit, and the hand sweeps the ring
+ * clearing bits until it finds an unreferenced block to evict.
+ */
+class BlockCache {
+public:
+    static const size_t SHARD_COUNT = 16;
+
+    BlockCache(size_t capacitybytes);
+
+    //Returns the cached block, or nullptr if the block is not cached
+    DecodedBlock get(const BlockKey& key);
+    //Blocks larger than a shard are not cached
+    void put(const BlockKey& key, DecodedBlock block);
+    void clear();
+
+    //Memory currently used by cached blocks
+    size_t getBytes();
+    size_t getCapacity();
+
+private:
+    struct Entry {
+        BlockKey key;
+        DecodedBlock block;
+        size_t bytes;
+        bool referenced;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        //Ring of entries, walked by hand
+        std::list<Entry> ring;
+        std::list<Entry>::iterator hand;
+        std::unordered_map<BlockKey, std::list<Entry>::iterator, BlockKeyHash> lookup;
+        size_t bytes = 0;
+    };
+
+    Shard& getShard(const BlockKey& key);
+    //Evicts entries from the shard until bytes more can be added. Shard must be locked
+    void makeRoom(Shard& shard, size_t bytes);
+
+    size_t capacity;
+    size_t shardcapacity;
+    Shard shards[SHARD_COUNT];
+};
+
+#endif
\ No newline at end of file
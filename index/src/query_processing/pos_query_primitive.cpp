@@ -0,0 +1,44 @@
+#include "pos_query_primitive.hpp"
+
+#include <stdexcept>
+
+pos_query_primitive::pos_query_primitive(const SnapshotTerm& term, const IndexSnapshot& snapshot, QueryStats& stats) {
+    if(term.poslist != nullptr && !term.poslist->empty())
+        lists.emplace_back(term.poslist, stats);
+
+    for(auto& file : *snapshot.posfiles) {
+        try {
+            lists.emplace_back(term.termID, file, stats, snapshot.blockcache);
+        }
+        catch(const std::invalid_argument& e) {}
+    }
+
+    stats.listsopened += lists.size();
+    curdocIDs.resize(lists.size());
+    docID = 0;
+}
+
+unsigned int pos_query_primitive::nextGEQ(unsigned int x) {
+    unsigned int min = GlobalConst::UIntMax;
+
+    for(size_t i = 0; i < lists.size(); ++i) {
+        bool failure = false;
+        unsigned int next = lists[i].nextGEQ(x, failure);
+        if(failure)
+            curdocIDs[i] = GlobalConst::UIntMax;
+        else {
+            curdocIDs[i] = next;
+            if(next <= min)
+                min = next;
+        }
+    }
+    docID = min;
+    return min;
+}
+
+void pos_query_primitive::getPositions(std::vector<FragmentPosition>& positions) {
+    for(size_t i = 0; i < lists.size(); ++i) {
+        if(curdocIDs[i] == docID)
+            lists[i].getPositions(positions);
+    }
+}
\ No newline at end of file
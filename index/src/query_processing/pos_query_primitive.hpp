@@ -0,0 +1,28 @@
+#ifndef POS_QUERY_PRIMITIVE_HPP
+#define POS_QUERY_PRIMITIVE_HPP
+
+#include <vector>
+
+#include "snapshot.hpp"
+#include "pos_query_primitive_low.hpp"
+
+//Positional postings of a single term across the in-memory index and every static index of a snapshot.
+//Unlike non-positional postings, where the newest list wins, every list holds a part of the current document:
+//older versions contribute the text that was kept, newer versions the text that was edited
+class pos_query_primitive {
+public:
+    pos_query_primitive(const SnapshotTerm& term, const IndexSnapshot& snapshot, QueryStats& stats);
+
+    //Advances QP to next docID greater than or equal to x
+    unsigned int nextGEQ(unsigned int x);
+    //Appends the postings of the current document from every list
+    void getPositions(std::vector<FragmentPosition>& positions);
+private:
+    std::vector<pos_query_primitive_low> lists;
+    //Contains the current docID that each QP is pointed at
+    std::vector<unsigned int> curdocIDs;
+    //Contains the minimum docID of all QPs
+    unsigned int docID;
+};
+
+#endif
\ No newline at end of file
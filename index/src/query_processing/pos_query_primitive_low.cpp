@@ -0,0 +1,166 @@
+#include "pos_query_primitive_low.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "static_functions/compression.hpp"
+#include "static_functions/compression_functions/varbyte.hpp"
+
+pos_query_primitive_low::pos_query_primitive_low(std::shared_ptr<const std::vector<Posting>> postinglist, QueryStats& stats) {
+    inmemory = true;
+    this->stats = &stats;
+    this->postinglist = postinglist;
+    cache = nullptr;
+    postingindex = 0;
+}
+
+pos_query_primitive_low::pos_query_primitive_low(unsigned int termID, std::shared_ptr<const StaticFileHandle> file,
+    QueryStats& stats, BlockCache* cache)
+{
+    inmemory = false;
+    this->stats = &stats;
+    this->cache = cache;
+    this->file = file;
+
+    size_t pos = file->findPostingList(termID);
+
+    //Skip termID, length, postings count and the three compression methods
+    pos += 24;
+
+    unsigned int lastdocIDlen = file->readValue<unsigned int>(pos);
+    std::vector<uint8_t> buffer = file->readBytes(lastdocIDlen, pos + 4);
+    last_docID = decompress_block(buffer, VBDecode, false);
+    pos += 4 + lastdocIDlen;
+
+    unsigned int blocksizeslen = file->readValue<unsigned int>(pos);
+    buffer = file->readBytes(blocksizeslen, pos + 4);
+    blocksizes = decompress_block(buffer, VBDecode, false);
+    pos += 4 + blocksizeslen;
+
+    if(blocksizes.size() != last_docID.size() * 3)
+        throw std::runtime_error("Error, positional blocksizes do not match the number of blocks in " + file->getPath());
+
+    //Skip postingblockssize var
+    pos += 4;
+
+    for(size_t block = 0; block < last_docID.size(); ++block) {
+        blockpos.push_back(pos);
+        pos += blocksizes[block*3] + blocksizes[block*3 + 1] + blocksizes[block*3 + 2];
+    }
+
+    docIDindex = 0;
+    blockindex = 0;
+    positionsdecompressed = false;
+    docblock = loadBlock(0, DOCID);
+}
+
+DecodedBlock pos_query_primitive_low::loadBlock(size_t block, BlockKind kind) {
+    size_t pos = blockpos[block];
+    for(int i = 0; i < kind; ++i)
+        pos += blocksizes[block*3 + i];
+
+    BlockKey key{file->getGeneration(), (unsigned long)pos};
+    if(cache) {
+        DecodedBlock cached = cache->get(key);
+        if(cached) {
+            stats->blockcachehits++;
+            return cached;
+        }
+    }
+
+    //Only docID blocks are delta compressed
+    std::vector<uint8_t> buffer = file->readBytes(blocksizes[block*3 + kind], pos);
+    DecodedBlock decoded = std::make_shared<const std::vector<unsigned int>>(decompress_block(buffer, VBDecode, kind == DOCID));
+    stats->blocksdecoded++;
+
+    if(cache)
+        cache->put(key, decoded);
+    return decoded;
+}
+
+unsigned int pos_query_primitive_low::nextGEQ(unsigned int x, bool& failure) {
+    failure = false;
+    if(inmemory) {
+        const std::vector<Posting>& postings = *postinglist;
+        size_t oldindex = postingindex;
+        while(postingindex < postings.size() && postings[postingindex].docID < x)
+            ++postingindex;
+        stats->postingsscanned += postingindex - oldindex;
+
+        if(postingindex == postings.size()) {
+            failure = true;
+            return GlobalConst::UIntMax;
+        }
+        return postings[postingindex].docID;
+    }
+
+    size_t oldindex = docIDindex;
+    //The first group whose last docID is at least x holds the first posting of that document
+    //Groups are sorted by their last docID, so long skips are found with a binary search
+    docIDindex = std::lower_bound(last_docID.begin() + docIDindex, last_docID.end(), x) - last_docID.begin();
+    if(docIDindex == last_docID.size()) {
+        failure = true;
+        return GlobalConst::UIntMax;
+    }
+
+    if(oldindex != docIDindex) {
+        docblock = loadBlock(docIDindex, DOCID);
+        blockindex = 0;
+        positionsdecompressed = false;
+    }
+
+    const std::vector<unsigned int>& docIDs = *docblock;
+    size_t oldblockindex = blockindex;
+    while(blockindex < docIDs.size() && docIDs[blockindex] < x)
+        ++blockindex;
+    stats->postingsscanned += blockindex - oldblockindex;
+
+    if(blockindex == docIDs.size()) {
+        failure = true;
+        return GlobalConst::UIntMax;
+    }
+    return docIDs[blockindex];
+}
+
+void pos_query_primitive_low::getPositions(std::vector<FragmentPosition>& positions) {
+    if(inmemory) {
+        const std::vector<Posting>& postings = *postinglist;
+        unsigned int docID = postings[postingindex].docID;
+        for(size_t i = postingindex; i < postings.size() && postings[i].docID == docID; ++i)
+            positions.emplace_back(postings[i].second, postings[i].third);
+        return;
+    }
+
+    if(!positionsdecompressed) {
+        fragblock = loadBlock(docIDindex, FRAGMENT);
+        posblock = loadBlock(docIDindex, POSITION);
+        positionsdecompressed = true;
+    }
+
+    unsigned int docID = (*docblock)[blockindex];
+    const std::vector<unsigned int>& docIDs = *docblock;
+    size_t i = blockindex;
+    for(; i < docIDs.size() && docIDs[i] == docID; ++i)
+        positions.emplace_back((*fragblock)[i], (*posblock)[i]);
+    if(i < docIDs.size())
+        return;
+
+    //The document continues into the following groups. The read pointer stays where it is
+    for(size_t block = docIDindex + 1; block < last_docID.size(); ++block) {
+        if(!appendPositions(block, docID, positions))
+            return;
+    }
+}
+
+bool pos_query_primitive_low::appendPositions(size_t block, unsigned int docID, std::vector<FragmentPosition>& positions) {
+    DecodedBlock docIDs = loadBlock(block, DOCID);
+    if((*docIDs)[0] != docID)
+        return false;
+
+    DecodedBlock fragIDs = loadBlock(block, FRAGMENT);
+    DecodedBlock offsets = loadBlock(block, POSITION);
+    size_t i = 0;
+    for(; i < docIDs->size() && (*docIDs)[i] == docID; ++i)
+        positions.emplace_back((*fragIDs)[i], (*offsets)[i]);
+    return i == docIDs->size();
+}
\ No newline at end of file
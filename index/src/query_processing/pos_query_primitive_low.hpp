@@ -0,0 +1,73 @@
+#ifndef POS_QUERY_PRIMITIVE_LOW_HPP
+#define POS_QUERY_PRIMITIVE_LOW_HPP
+
+#include <vector>
+#include <memory>
+
+#include "posting.hpp"
+#include "global_parameters.hpp"
+#include "static_file.hpp"
+#include "query_stats.hpp"
+#include "block_cache.hpp"
+#include "doc_analyzer/Matcher/translate.h"
+
+/**
+ * Reads a single positional posting list, either in memory or in a static index.
+ * A document has one posting per occurrence of the term, so docIDs repeat. nextGEQ only decodes docID blocks;
+ * the fragID and position blocks of a block are decoded the first time getPositions needs them.
+ */
+class pos_query_primitive_low {
+public:
+    //Work done by the QPL (blocks decoded, postings scanned) is added to stats
+    //Reads an in-memory list, which must be sorted by docID
+    pos_query_primitive_low(std::shared_ptr<const std::vector<Posting>> postinglist, QueryStats& stats);
+    //Decoded blocks are looked up in and added to cache when one is given
+    //Throws std::invalid_argument if the term is not in the file
+    pos_query_primitive_low(unsigned int termID, std::shared_ptr<const StaticFileHandle> file, QueryStats& stats,
+        BlockCache* cache = nullptr);
+
+    //Advances to the first posting with a docID of at least x, and returns that docID. See query_primitive_low::nextGEQ
+    unsigned int nextGEQ(unsigned int x, bool& failure);
+
+    //Appends the fragID and position of every posting of the current document
+    //NOTE: undefined if nextGEQ returned invalid
+    void getPositions(std::vector<FragmentPosition>& positions);
+
+private:
+    //Kinds of blocks stored for each group of BLOCKSIZE postings, in file order
+    enum BlockKind { DOCID = 0, FRAGMENT = 1, POSITION = 2 };
+
+    DecodedBlock loadBlock(size_t block, BlockKind kind);
+    //Appends the postings at the start of block that belong to docID. Returns true if the document may continue
+    //into the next block
+    bool appendPositions(size_t block, unsigned int docID, std::vector<FragmentPosition>& positions);
+
+    bool inmemory;
+    QueryStats* stats;
+
+    //In-memory variables
+    std::shared_ptr<const std::vector<Posting>> postinglist;
+    size_t postingindex;
+
+    //Metadata
+    std::shared_ptr<const StaticFileHandle> file;
+    BlockCache* cache;
+    std::vector<unsigned int> last_docID;
+    std::vector<unsigned int> blocksizes;
+    //File position of the first (docID) block of each group
+    std::vector<size_t> blockpos;
+
+    //State
+    //Current group of blocks
+    size_t docIDindex;
+    //Current posting in the group
+    size_t blockindex;
+
+    //Decompressed blocks of the current group. Fragment and position blocks are only valid if decompressed
+    DecodedBlock docblock;
+    DecodedBlock fragblock;
+    DecodedBlock posblock;
+    bool positionsdecompressed;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include "positional_DAAT.hpp"
+
+#include <algorithm>
+
+#include "pos_query_primitive.hpp"
+#include "utility/metrics.hpp"
+
+struct MatchPair {
+    MatchPair(unsigned int d, unsigned int m) : docID(d), matches(m) {}
+
+    unsigned int docID;
+    unsigned int matches;
+};
+
+class greater_MatchPair {
+public:
+    bool operator()(MatchPair lhs, MatchPair rhs) {
+        return lhs.matches > rhs.matches;
+    }
+};
+
+//Current positions of the postings of a document, sorted
+std::vector<int> translatePositions(const std::vector<FragmentPosition>& postings, const CompiledTranslations& translations) {
+    std::vector<int> positions = translations.applyBatch(postings);
+    positions.erase(std::remove_if(positions.begin(), positions.end(), [](int position) { return position < 0; }),
+        positions.end());
+    std::sort(positions.begin(), positions.end());
+    positions.erase(std::unique(positions.begin(), positions.end()), positions.end());
+    return positions;
+}
+
+unsigned int countPhrase(const std::vector<std::vector<int>>& positions) {
+    unsigned int matches = 0;
+    for(int start : positions[0]) {
+        bool match = true;
+        for(size_t i = 1; i < positions.size() && match; ++i)
+            match = std::binary_search(positions[i].begin(), positions[i].end(), start + (int)i);
+        if(match)
+            matches++;
+    }
+    return matches;
+}
+
+unsigned int countProximity(const std::vector<std::vector<int>>& positions, unsigned int window) {
+    //Every occurrence of every term, in document order
+    std::vector<std::pair<int, size_t>> occurrences;
+    for(size_t term = 0; term < positions.size(); ++term) {
+        for(int position : positions[term])
+            occurrences.emplace_back(position, term);
+    }
+    std::sort(occurrences.begin(), occurrences.end());
+
+    //Sliding window over the occurrences. For each right end, the left end is moved up as long as the window still
+    //contains every term, which gives the shortest window ending there
+    std::vector<unsigned int> counts(positions.size(), 0);
+    size_t covered = 0;
+    size_t left = 0;
+    unsigned int matches = 0;
+    for(size_t right = 0; right < occurrences.size(); ++right) {
+        if(counts[occurrences[right].second]++ == 0)
+            covered++;
+        while(counts[occurrences[left].second] > 1) {
+            counts[occurrences[left].second]--;
+            left++;
+        }
+        if(covered == positions.size() && occurrences[right].first - occurrences[left].first < (int)window)
+            matches++;
+    }
+    return matches;
+}
+
+std::vector<unsigned int> positionalDAAT(const IndexSnapshot& snapshot, PositionalOperator op, unsigned int window,
+    const TranslationLookup& translations, QueryStats& stats)
+{
+    if(snapshot.terms.empty()) {
+        return std::vector<unsigned int>();
+    }
+
+    std::priority_queue<MatchPair, std::vector<MatchPair>, greater_MatchPair> minheap;
+
+    std::vector<pos_query_primitive> listpointers;
+
+    auto openbegin = std::chrono::steady_clock::now();
+    for(const SnapshotTerm& term : snapshot.terms) {
+        listpointers.emplace_back(term, snapshot, stats);
+    }
+    stats.openns += Metrics::nanosSince(openbegin);
+
+    //Position matching time is measured separately and taken out of the traversal time afterwards
+    long long scorens = 0;
+    auto traversebegin = std::chrono::steady_clock::now();
+
+    std::vector<FragmentPosition> postings;
+    std::vector<std::vector<int>> positions(listpointers.size());
+    unsigned int did = 0;
+
+    while(did < GlobalConst::UIntMax) {
+        did = listpointers[0].nextGEQ(did);
+        if(did == GlobalConst::UIntMax)
+            break;
+
+        unsigned int d = 0;
+        for(size_t i = 1; i < listpointers.size() && (d = listpointers[i].nextGEQ(did)) == did; i++)
+            ;
+
+        if(d > did) {
+            did = d;
+            continue;
+        }
+
+        /* docID is in intersection; now decode the positions of every term */
+        auto scorebegin = std::chrono::steady_clock::now();
+        std::shared_ptr<const CompiledTranslations> doctranslations = translations(did);
+        stats.translationlookups++;
+
+        bool empty = false;
+        for(size_t i = 0; i < listpointers.size() && !empty; ++i) {
+            postings.clear();
+            listpointers[i].getPositions(postings);
+            stats.positionsread += postings.size();
+            positions[i] = translatePositions(postings, *doctranslations);
+            //Every occurrence of the term may have been edited away
+            empty = positions[i].empty();
+        }
+
+        unsigned int matches = 0;
+        if(!empty)
+            matches = (op == PositionalOperator::PHRASE) ? countPhrase(positions) : countProximity(positions, window);
+
+        if(matches > 0) {
+            if(minheap.size() < DAAT_SIZE) {
+                minheap.emplace(did, matches);
+            }
+            else if(matches > minheap.top().matches) {
+                minheap.pop();
+                minheap.emplace(did, matches);
+            }
+        }
+        stats.docsscored++;
+        scorens += Metrics::nanosSince(scorebegin);
+        did++; /* and increase did to search for next post */
+    }
+
+    stats.traversens += Metrics::nanosSince(traversebegin) - scorens;
+    stats.scorens += scorens;
+
+    std::vector<unsigned int> docs;
+    docs.reserve(DAAT_SIZE);
+    while(!minheap.empty()) {
+        docs.push_back(minheap.top().docID);
+        minheap.pop();
+    }
+
+    return docs;
+}
\ No newline at end of file
@@ -0,0 +1,36 @@
+#ifndef POSITIONAL_DAAT_HPP
+#define POSITIONAL_DAAT_HPP
+
+#include <vector>
+#include <functional>
+#include <memory>
+
+#include "global_parameters.hpp"
+#include "snapshot.hpp"
+#include "query_stats.hpp"
+#include "doc_analyzer/Matcher/translate.h"
+
+enum class PositionalOperator {
+    //The terms appear next to each other, in query order
+    PHRASE,
+    //Every term appears within a window of consecutive words, in any order
+    PROXIMITY
+};
+
+//Returns every translation of a document, compiled
+using TranslationLookup = std::function<std::shared_ptr<const CompiledTranslations>(unsigned int docID)>;
+
+//Evaluates a phrase or proximity query over the positional index. The terms of the snapshot are read in query order.
+//Postings store the position a word had in the version of the document it was indexed with, so positions are mapped to
+//the current document through its translations before they are compared. Postings removed by later edits are dropped.
+//window is the size of the window for PROXIMITY, and is ignored for PHRASE.
+//Returns the docIDs that were found, ranked by their number of matches from low-high
+std::vector<unsigned int> positionalDAAT(const IndexSnapshot& snapshot, PositionalOperator op, unsigned int window,
+    const TranslationLookup& translations, QueryStats& stats);
+
+//Number of positions at which the terms start an exact phrase. positions holds the sorted positions of each term
+unsigned int countPhrase(const std::vector<std::vector<int>>& positions);
+//Number of positions at which a window of at most window words, ending at that position, contains every term
+unsigned int countProximity(const std::vector<std::vector<int>>& positions, unsigned int window);
+
+#endif
\ No newline at end of file
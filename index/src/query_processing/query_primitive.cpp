@@ -1,29 +1,19 @@
 #include "query_primitive.hpp"
 
-#include "utility/util.hpp"
+#include <stdexcept>
 
-query_primitive::query_primitive(unsigned int termID, GlobalType::NonPosIndex& index, SparseExtendedLexicon& exlex, std::string staticpath) {
-    lists.emplace_back(termID, index);
-
-    std::vector<std::string> indexnames = Utility::readDirectory(staticpath);
-
-    for(std::string& name : indexnames) {
-        bool isZindex;
-        if(name[0] == 'Z')
-            isZindex = true;
-        else if(name[0] == 'I')
-            isZindex = false;
-        else
-            throw std::invalid_argument("Error, index name " + name + " is invalid");
-
-        unsigned int indexnum = std::stoul(name.substr(1));
+query_primitive::query_primitive(const SnapshotTerm& term, const IndexSnapshot& snapshot, QueryStats& stats) {
+    if(term.memlist != nullptr)
+        lists.emplace_back(*term.memlist, term.memlength, term.sidelength, stats);
 
+    for(auto& file : *snapshot.files) {
         try {
-            lists.emplace_back(termID, staticpath + "/" + name, exlex.getNonPosLEQOffset(termID, indexnum, isZindex));
+            lists.emplace_back(term.termID, file, stats, snapshot.blockcache);
         }
         catch(const std::invalid_argument& e) {}
     }
 
+    stats.listsopened += lists.size();
     curdocIDs.resize(lists.size());
     docID = 0;
 }
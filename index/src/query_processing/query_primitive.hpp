@@ -4,12 +4,13 @@
 #include <vector>
 
 #include "posting.hpp"
-#include "sparse_lexicon.hpp"
+#include "snapshot.hpp"
 #include "query_primitive_low.hpp"
 
 class query_primitive {
 public:
-    query_primitive(unsigned int termID, GlobalType::NonPosIndex& index, SparseExtendedLexicon& exlex, std::string staticpath);
+    //Reads the term from the in-memory index and every static index of the snapshot
+    query_primitive(const SnapshotTerm& term, const IndexSnapshot& snapshot, QueryStats& stats);
 
     //Advances QP to next docID greater than x
     unsigned int nextGEQ(unsigned int x);
@@ -2,99 +2,102 @@
 
 #include <algorithm>
 
-#include "static_functions/postingIO.hpp"
-#include "static_functions/bytesIO.hpp"
+#include "static_functions/compression.hpp"
 #include "static_functions/compression_functions/varbyte.hpp"
 
-query_primitive_low::query_primitive_low(unsigned int termID, GlobalType::NonPosIndex& index) {
+query_primitive_low::query_primitive_low(const NonPosMemtable::PostingList& list, size_t sortedlength, size_t sidelength,
+    QueryStats& stats)
+{
     inmemory = true;
-    //Do *not* assume that in-memory posting lists are sorted
-    std::sort(index[termID].begin(), index[termID].end());
-    postinglist = index[termID];
-    postingindex = 0;
+    this->stats = &stats;
+    cache = nullptr;
+    cursor.reset(new MemPostingList::Cursor(list, sortedlength, sidelength));
 }
 
-//filepath: The path to the index that the QPL points to
-//LEQpos: Pointer to the closest termID that is less than or equal to the desired termID. May be greater than termID if termID
-//          is smaller than all termIDs in the block
-query_primitive_low::query_primitive_low(unsigned int termID, std::string path, size_t LEQpos) {
+//file: The index that the QPL points to. The closest termID that is less than or equal to the desired termID is found
+//      through the file's part of the extended lexicon, and the list is searched for from there
+query_primitive_low::query_primitive_low(unsigned int termID, std::shared_ptr<const StaticFileHandle> file, QueryStats& stats,
+    BlockCache* cache)
+{
     inmemory = false;
-    filepath = path;
+    this->stats = &stats;
+    this->cache = cache;
+    this->file = file;
+    filegeneration = file->getGeneration();
 
     //Can assume that static posting lists are sorted
 
     //Determine if term exists in index
-    ifile.open(filepath);
-    if(!ifile)
-        throw std::invalid_argument("Error: invalid filepath in query_primitive_low: " + filepath);
+    size_t pos = file->findPostingList(termID);
 
-    ifile.seekg(LEQpos);
-
-    unsigned int disktermID;
-    readFromBytes(disktermID, ifile);
-    unsigned int postinglistlength;
-
-    while(ifile && disktermID < termID) {
-        readFromBytes(postinglistlength, ifile);
-        ifile.seekg(postinglistlength-8, std::ios_base::cur);
-
-        readFromBytes(disktermID, ifile);
-    }
-
-    if(disktermID != termID) {
-        throw std::invalid_argument("Error, term does not exist in index");
-    }
-
-    readFromBytes(postinglistlength, ifile);
-    //Skip postings count and compression methods
+    //Skip termID, length, postings count and compression methods
     //WARNING: Assumed non-positional postings here
-    ifile.seekg(12, std::ios_base::cur);
+    pos += 20;
 
     //Save last_docID array in memory
-    unsigned int lastdocIDlen;
-    readFromBytes(lastdocIDlen, ifile);
-    last_docID = read_block(lastdocIDlen, ifile, VBDecode, false);
+    unsigned int lastdocIDlen = file->readValue<unsigned int>(pos);
+    std::vector<uint8_t> buffer = file->readBytes(lastdocIDlen, pos + 4);
+    last_docID = decompress_block(buffer, VBDecode, false);
+    pos += 4 + lastdocIDlen;
 
     //Get blocksizes array
-    unsigned int blocksizeslen;
-    readFromBytes(blocksizeslen, ifile);
-    blocksizes = read_block(blocksizeslen, ifile, VBDecode, false);
+    unsigned int blocksizeslen = file->readValue<unsigned int>(pos);
+    buffer = file->readBytes(blocksizeslen, pos + 4);
+    blocksizes = decompress_block(buffer, VBDecode, false);
+    pos += 4 + blocksizeslen;
 
     //Skip postingblockssize var
-    ifile.seekg(4, std::ios_base::cur);
+    pos += 4;
 
     //Store some metadata
     docIDindex = 0;
-    docblockpos = ifile.tellg();
+    docblockpos = pos;
     blockindex = 0;
     freqdecompressed = false;
 
     //Decompress and store the first docID
     //Only decompress frequency block if getFreq is called
-    size_t buffersize = blocksizes[0];
-    docblock = read_block(buffersize, ifile, VBDecode, true);
+    docblock = loadBlock(0, false, docblockpos);
+}
+
+DecodedBlock query_primitive_low::loadBlock(size_t block, bool isfreq, size_t pos) {
+    BlockKey key{filegeneration, (unsigned long)pos};
+    if(cache) {
+        DecodedBlock cached = cache->get(key);
+        if(cached) {
+            stats->blockcachehits++;
+            return cached;
+        }
+    }
+
+    //docID blocks are delta compressed, frequency blocks are not
+    std::vector<uint8_t> buffer = file->readBytes(blocksizes[(block*2) + isfreq], pos);
+    DecodedBlock decoded = std::make_shared<const std::vector<unsigned int>>(decompress_block(buffer, VBDecode, !isfreq));
+    stats->blocksdecoded++;
+
+    if(cache)
+        cache->put(key, decoded);
+    return decoded;
 }
 
 unsigned int query_primitive_low::nextGEQ(unsigned int pos, bool& failure) {
     //Reset to clear previous value
     failure = false;
     if(inmemory) {
-        while(postingindex < postinglist.size() && postinglist[postingindex].docID < pos) {
-            ++postingindex;
-        }
+        stats->postingsscanned += cursor->skipTo(pos);
         //Notify failure upon return
-        if(postingindex == postinglist.size()) {
+        if(!cursor->valid()) {
             failure = true;
             return GlobalConst::UIntMax;
         }
-        return postinglist[postingindex].docID;
+        return cursor->get().docID;
     }
     else {
         size_t oldindex = docIDindex;
         //Find the correct block to look at
         while(docIDindex < last_docID.size() && last_docID[docIDindex] < pos) {
-            //Move the docID block pointer
-            docblockpos += blocksizes[(docIDindex*2)-1] + blocksizes[(docIDindex*2)];
+            //Move the docID block pointer past the docID and frequency blocks of the current block
+            docblockpos += blocksizes[docIDindex*2] + blocksizes[(docIDindex*2)+1];
 
             ++docIDindex;
         }
@@ -105,24 +108,24 @@ unsigned int query_primitive_low::nextGEQ(unsigned int pos, bool& failure) {
 
         //If it's different than our current block then decompress new block
         if(oldindex != docIDindex) {
-            //Move the filestream to the new position
-            ifile.seekg(docblockpos);
-            size_t buffersize = blocksizes[docIDindex*2];
-            docblock = read_block(buffersize, ifile, VBDecode, true);
+            docblock = loadBlock(docIDindex, false, docblockpos);
 
             blockindex = 0;
             freqdecompressed = false;
         }
         //Perform standard docID searching
-        while(blockindex < docblock.size() && docblock[blockindex] < pos)
+        const std::vector<unsigned int>& docIDs = *docblock;
+        size_t oldblockindex = blockindex;
+        while(blockindex < docIDs.size() && docIDs[blockindex] < pos)
             ++blockindex;
+        stats->postingsscanned += blockindex - oldblockindex;
 
-        if(blockindex == docblock.size()) {
+        if(blockindex == docIDs.size()) {
             failure = true;
             return GlobalConst::UIntMax;
         }
 
-        return docblock[blockindex];
+        return docIDs[blockindex];
     }
 }
 
@@ -130,15 +133,15 @@ unsigned int query_primitive_low::nextGEQ(unsigned int pos, bool& failure) {
 //Undefined if nextGEQ returned invalid
 unsigned int query_primitive_low::getFreq() {
     if(inmemory) {
-        return postinglist[postingindex].second;
+        return cursor->get().second;
     }
     else {
         if(!freqdecompressed) {
-            size_t buffersize = blocksizes[(docIDindex*2)+1];
-            freqblock = read_block(buffersize, ifile, VBDecode, false);
+            //The frequency block directly follows its docID block
+            freqblock = loadBlock(docIDindex, true, docblockpos + blocksizes[docIDindex*2]);
             freqdecompressed = true;
         }
-        return freqblock[blockindex];
+        return (*freqblock)[blockindex];
     }
 }
 
@@ -146,8 +149,5 @@ int query_primitive_low::getIndexNumber() {
     if(inmemory)
         return -1;
 
-    //WARNING: Uses unix-specific file separators
-    std::string filename = std::string(std::find( filepath.rbegin(), filepath.rend(), '/' ).base(), filepath.end());
-
-    return std::stoi(filename.substr(1, filename.length()));
+    return file->getIndexNumber();
 }
\ No newline at end of file
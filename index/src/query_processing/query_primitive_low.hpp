@@ -2,16 +2,26 @@
 #define QUERY_PRIMITIVE_LOW_HPP
 
 #include <vector>
-#include <fstream>
 #include <string>
+#include <memory>
 
 #include "posting.hpp"
 #include "global_parameters.hpp"
+#include "static_file.hpp"
+#include "Structures/memtable.h"
+#include "query_stats.hpp"
+#include "block_cache.hpp"
 
 class query_primitive_low {
 public:
-    query_primitive_low(unsigned int termID, GlobalType::NonPosIndex& index);
-    query_primitive_low(unsigned int termID, std::string path, size_t LEQpos);
+    //Work done by the QPL (blocks decoded, postings scanned) is added to stats
+    //Reads the first sortedlength postings of an in-memory list and the first sidelength postings of its side buffer.
+    //The list is read in place, so it must outlive the QPL
+    query_primitive_low(const NonPosMemtable::PostingList& list, size_t sortedlength, size_t sidelength, QueryStats& stats);
+    //Decoded blocks are looked up in and added to cache when one is given
+    //Throws std::invalid_argument if the term is not in the file
+    query_primitive_low(unsigned int termID, std::shared_ptr<const StaticFileHandle> file, QueryStats& stats,
+        BlockCache* cache = nullptr);
 
     //Advances the read pointer of lp to the posting with the smallest docID that is at least x, and then returns that docID.
     //Note that read pointers only move forward; thus, if the pointer currently points to a posting with docID y > x, then the
@@ -28,14 +38,19 @@ public:
     int getIndexNumber();
 
 private:
+    //Gets the given docID or frequency block, either from the cache or by decoding it from pos in the file
+    DecodedBlock loadBlock(size_t block, bool isfreq, size_t pos);
+
     bool inmemory;
+    QueryStats* stats;
 
     //In-memory variables
-    std::vector<nPosting> postinglist;
-    size_t postingindex;
+    std::unique_ptr<MemPostingList::Cursor> cursor;
 
     //Metadata
-    std::string filepath;
+    std::shared_ptr<const StaticFileHandle> file;
+    BlockCache* cache;
+    unsigned long filegeneration;
     std::vector<unsigned int> last_docID;
     std::vector<unsigned int> blocksizes;
 
@@ -46,17 +61,14 @@ private:
     size_t docIDindex;
     //Which number in the block we are currently pointed to
     size_t blockindex;
-    //File pointer position pointing to the beginning of a docID block
-    long docblockpos;
+    //File position of the beginning of the current docID block
+    size_t docblockpos;
     //Determines if frequency block has been decompressed/is valid
     bool freqdecompressed;
 
-    //Vectors to hold decompressed blocks
-    std::vector<unsigned int> docblock;
-    std::vector<unsigned int> freqblock;
-
-    //Filestream
-    std::ifstream ifile;
+    //Decompressed blocks
+    DecodedBlock docblock;
+    DecodedBlock freqblock;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef QUERY_STATS_HPP
+#define QUERY_STATS_HPP
+
+#include "libs/json.hpp"
+
+//Work done by a single query, filled in as the query runs
+//Times are in nanoseconds
+struct QueryStats {
+    unsigned long listsopened = 0;
+    unsigned long blocksdecoded = 0;
+    unsigned long postingsscanned = 0;
+    unsigned long docsscored = 0;
+    unsigned long blockcachehits = 0;
+    //Positional queries only
+    unsigned long positionsread = 0;
+    unsigned long translationlookups = 0;
+    bool cachedresult = false;
+
+    long long lexiconns = 0;
+    long long openns = 0;
+    long long traversens = 0;
+    long long scorens = 0;
+    long long totalns = 0;
+
+    nlohmann::json toJson() const {
+        return nlohmann::json::object({
+            {"lists_opened", listsopened},
+            {"blocks_decoded", blocksdecoded},
+            {"postings_scanned", postingsscanned},
+            {"docs_scored", docsscored},
+            {"block_cache_hits", blockcachehits},
+            {"positions_read", positionsread},
+            {"translation_lookups", translationlookups},
+            {"cached_result", cachedresult},
+            {"lexicon_ns", lexiconns},
+            {"open_lists_ns", openns},
+            {"traverse_ns", traversens},
+            {"score_ns", scorens},
+            {"total_ns", totalns},
+        });
+    }
+};
+
+#endif
\ No newline at end of file
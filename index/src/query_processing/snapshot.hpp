@@ -0,0 +1,49 @@
+#ifndef SNAPSHOT_HPP
+#define SNAPSHOT_HPP
+
+#include <vector>
+#include <memory>
+
+#include "static_file.hpp"
+#include "Structures/memtable.h"
+#include "Structures/doclengthtable.h"
+#include "posting.hpp"
+#include "block_cache.hpp"
+
+//A query term as seen by a snapshot
+struct SnapshotTerm {
+    unsigned int termID;
+    //How many documents the term appeared in
+    unsigned int f_t;
+    //In-memory postings of the term, nullptr if there are none
+    std::shared_ptr<const NonPosMemtable::PostingList> memlist;
+    //Number of in-memory postings visible to the snapshot, in the sorted run and in the side buffer of the list
+    size_t memlength;
+    size_t sidelength;
+    //In-memory positional postings of the term sorted by docID, only taken for positional queries
+    std::shared_ptr<const std::vector<Posting>> poslist;
+};
+
+/**
+ * Everything a query reads, captured at a single point in time (between two document insertions).
+ * The snapshot keeps the in-memory index and the static files it refers to alive, so it stays valid and unchanged
+ * while the writer keeps inserting, flushing and merging.
+ */
+struct IndexSnapshot {
+    std::vector<SnapshotTerm> terms;
+
+    std::shared_ptr<const NonPosMemtable> memtable;
+    std::shared_ptr<const StaticFileSet> files;
+    //Positional index files, only taken for positional queries
+    std::shared_ptr<const StaticFileSet> posfiles;
+    BlockCache* blockcache;
+
+    //Document statistics used for ranking
+    std::shared_ptr<const DocLengthTable> doclengths;
+    double avgdoclength;
+    size_t doccount;
+
+    unsigned long long generation;
+};
+
+#endif
\ No newline at end of file
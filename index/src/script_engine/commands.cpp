@@ -1,7 +1,11 @@
 #include "commands.hpp"
 
+#include <algorithm>
+#include <fstream>
+
 #include "morph.hpp"
 #include "utility/timer.hpp"
+#include "utility/metrics.hpp"
 
 void commandInsert(std::unique_ptr<Index>& indexptr, std::unique_ptr<ReaderInterface>& docreader, std::vector<std::string>& arguments) {
     //Check that arguments are valid
@@ -22,19 +26,15 @@ void commandInsert(std::unique_ptr<Index>& indexptr, std::unique_ptr<ReaderInter
     Utility::Timer stopwatch;
 
     int docsinserted = 0;
-    std::string nexturl = docreader->getURL();
-    std::string nextdoc = docreader->getCurrentDocument();
-
     for(int i = 0; i < doccount && docreader->isValid(); i++) {
-        std::string currenturl = nexturl;
-        std::string currentdoc = nextdoc;
-
-        docreader->nextDocument();
-        nexturl = docreader->getURL();
-        nextdoc = docreader->getCurrentDocument();
+        std::string currenturl(docreader->getURL());
 
         //If there are versions, generate them based on the next document
         if(versioncount > 0) {
+            std::string currentdoc(docreader->getCurrentDocument());
+            if(!docreader->nextDocument())
+                break;
+            std::string nextdoc(docreader->getCurrentDocument());
             DocumentMorpher morpher(currentdoc, nextdoc, versioncount);
 
             while(true) {
@@ -51,13 +51,15 @@ void commandInsert(std::unique_ptr<Index>& indexptr, std::unique_ptr<ReaderInter
                 morpher.nextVersion();
             }
         }
-        //Otherwise just insert the document
+        //Otherwise just insert the document, straight from the reader
         else {
             std::cout << "Inserting file #" << docsinserted << ": " << currenturl << std::endl;
             stopwatch.start();
-            indexptr->insert_document(currenturl, currentdoc);
+            indexptr->insert_document(currenturl, docreader->getCurrentDocument());
             stopwatch.stop();
             docsinserted++;
+
+            docreader->nextDocument();
         }
     }
 
@@ -79,4 +81,190 @@ void commandInsert(std::unique_ptr<Index>& indexptr, std::unique_ptr<ReaderInter
 
 
     indexptr->printSize();
+}
+
+//Reads up to count documents into batch, whose pages point into pages
+//The reader's views are only valid until it moves on, so the pages are copied
+static void readBatch(std::unique_ptr<ReaderInterface>& docreader, size_t count, std::vector<std::string>& pages,
+    std::vector<DocumentInput>& batch)
+{
+    pages.clear();
+    batch.clear();
+    while(batch.size() < count && docreader->isValid()) {
+        batch.push_back({std::string(docreader->getURL()), std::string_view()});
+        pages.emplace_back(docreader->getCurrentDocument());
+        docreader->nextDocument();
+    }
+    for(size_t i = 0; i < batch.size(); ++i)
+        batch[i].page = pages[i];
+}
+
+void commandInsertBatch(std::unique_ptr<Index>& indexptr, std::unique_ptr<ReaderInterface>& docreader, std::vector<std::string>& arguments) {
+    //Check that arguments are valid
+    if(indexptr == nullptr)
+        throw std::runtime_error("Error: index is not initialized");
+    if(docreader == nullptr)
+        throw std::runtime_error("Error: no docreader specified");
+    if(arguments.size() < 2 || arguments.size() > 3)
+        throw std::invalid_argument("Error: invalid number of arguments to insertbatch");
+
+    //Parse args
+    size_t doccount = stoul(arguments[1]);
+    size_t batchsize = INSERT_BATCH_SIZE;
+    if(arguments.size() >= 3)
+        batchsize = stoul(arguments[2]);
+    if(batchsize == 0)
+        throw std::invalid_argument("Error: batch size must be positive");
+
+    //Begin timed section
+    Utility::Timer stopwatch;
+
+    size_t docsinserted = 0;
+    std::vector<std::string> pages;
+    std::vector<DocumentInput> batch;
+    while(docsinserted < doccount && docreader->isValid()) {
+        readBatch(docreader, std::min(batchsize, doccount - docsinserted), pages, batch);
+
+        std::cout << "Inserting files #" << docsinserted << " to #" << docsinserted + batch.size() - 1 << std::endl;
+        stopwatch.start();
+        indexptr->insert_documents(batch);
+        stopwatch.stop();
+        docsinserted += batch.size();
+    }
+
+    std::cout << "Inserted " << docsinserted << " documents in " << stopwatch.getCumulative() << "ms for an average of "
+        << stopwatch.getCumulative() / (double)docsinserted << " ms/doc\n";
+
+    indexptr->printSize();
+}
+
+void commandBulkBuild(std::unique_ptr<Index>& indexptr, std::unique_ptr<ReaderInterface>& docreader, std::vector<std::string>& arguments) {
+    //Check that arguments are valid
+    if(indexptr == nullptr)
+        throw std::runtime_error("Error: index is not initialized");
+    if(docreader == nullptr)
+        throw std::runtime_error("Error: no docreader specified");
+    if(arguments.size() < 2 || arguments.size() > 4)
+        throw std::invalid_argument("Error: invalid number of arguments to bulkbuild");
+
+    //Parse args
+    size_t doccount = stoul(arguments[1]);
+    size_t runsize = BULK_RUN_SIZE;
+    if(arguments.size() >= 3)
+        runsize = stoul(arguments[2]);
+    if(runsize == 0)
+        throw std::invalid_argument("Error: run size must be positive");
+    DocIDOrder order = DocIDOrder::ARRIVAL;
+    if(arguments.size() >= 4) {
+        std::string ordername = arguments[3];
+        std::transform(ordername.begin(), ordername.end(), ordername.begin(), ::tolower);
+        if(ordername == "url")
+            order = DocIDOrder::URL;
+        else if(ordername != "arrival")
+            throw std::invalid_argument("Error: unknown docID order " + arguments[3]);
+    }
+
+    //Begin timed section
+    Utility::Timer stopwatch;
+
+    size_t docsinserted = 0;
+    std::vector<std::string> pages;
+    std::vector<DocumentInput> batch;
+    while(docsinserted < doccount && docreader->isValid()) {
+        readBatch(docreader, std::min(runsize, doccount - docsinserted), pages, batch);
+
+        std::cout << "Inverting files #" << docsinserted << " to #" << docsinserted + batch.size() - 1 << std::endl;
+        stopwatch.start();
+        indexptr->bulk_insert(batch);
+        stopwatch.stop();
+        docsinserted += batch.size();
+    }
+
+    std::cout << "Merging runs" << std::endl;
+    stopwatch.start();
+    indexptr->bulk_finish(order);
+    stopwatch.stop();
+
+    std::cout << "Built an index of " << docsinserted << " documents in " << stopwatch.getCumulative()
+        << "ms for an average of " << stopwatch.getCumulative() / (double)docsinserted << " ms/doc\n";
+
+    indexptr->printSize();
+}
+
+void commandQuery(std::unique_ptr<Index>& indexptr, std::vector<std::string>& arguments) {
+    if(indexptr == nullptr)
+        throw std::runtime_error("Error: index is not initialized");
+    if(arguments.size() < 2)
+        throw std::invalid_argument("Error: invalid number of arguments to query");
+
+    std::vector<std::string> words(arguments.begin() + 1, arguments.end());
+    QueryStats stats;
+    std::vector<unsigned int> docs = indexptr->query(words, stats);
+
+    std::cout << "Found " << docs.size() << " documents:";
+    for(unsigned int docID : docs)
+        std::cout << " " << docID;
+    std::cout << std::endl;
+    std::cout << stats.toJson().dump() << std::endl;
+}
+
+void commandPhrase(std::unique_ptr<Index>& indexptr, std::vector<std::string>& arguments) {
+    if(indexptr == nullptr)
+        throw std::runtime_error("Error: index is not initialized");
+    if(arguments.size() < 2)
+        throw std::invalid_argument("Error: invalid number of arguments to phrase");
+
+    std::vector<std::string> words(arguments.begin() + 1, arguments.end());
+    QueryStats stats;
+    std::vector<unsigned int> docs = indexptr->positional_query(words, PositionalOperator::PHRASE, 0, stats);
+
+    std::cout << "Found " << docs.size() << " documents:";
+    for(unsigned int docID : docs)
+        std::cout << " " << docID;
+    std::cout << std::endl;
+    std::cout << stats.toJson().dump() << std::endl;
+}
+
+void commandNear(std::unique_ptr<Index>& indexptr, std::vector<std::string>& arguments) {
+    if(indexptr == nullptr)
+        throw std::runtime_error("Error: index is not initialized");
+    if(arguments.size() < 3)
+        throw std::invalid_argument("Error: invalid number of arguments to near");
+
+    unsigned int window = stoul(arguments[1]);
+    std::vector<std::string> words(arguments.begin() + 2, arguments.end());
+    QueryStats stats;
+    std::vector<unsigned int> docs = indexptr->positional_query(words, PositionalOperator::PROXIMITY, window, stats);
+
+    std::cout << "Found " << docs.size() << " documents:";
+    for(unsigned int docID : docs)
+        std::cout << " " << docID;
+    std::cout << std::endl;
+    std::cout << stats.toJson().dump() << std::endl;
+}
+
+void commandMetrics(std::vector<std::string>& arguments) {
+    if(arguments.size() > 2)
+        throw std::invalid_argument("Error: invalid number of arguments to metrics");
+
+    if(arguments.size() == 1) {
+        Metrics::print(std::cout);
+        return;
+    }
+
+    std::ofstream ofile(arguments[1], std::ios::out | std::ios::trunc);
+    if(!ofile)
+        throw std::runtime_error("Error: could not open metrics file " + arguments[1]);
+    ofile << Metrics::toJson().dump(4);
+}
+
+void commandMetricsDump(std::vector<std::string>& arguments) {
+    if(arguments.size() != 3)
+        throw std::invalid_argument("Error: invalid number of arguments to metricsdump");
+
+    unsigned int interval = stoul(arguments[2]);
+    if(interval == 0)
+        Metrics::stopPeriodicDump();
+    else
+        Metrics::startPeriodicDump(arguments[1], interval);
 }
\ No newline at end of file
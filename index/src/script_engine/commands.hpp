@@ -9,5 +9,12 @@
 #include "document_readers/WETreader.hpp"
 
 void commandInsert(std::unique_ptr<Index>& indexptr, std::unique_ptr<ReaderInterface>& docreader, std::vector<std::string>& arguments);
+void commandInsertBatch(std::unique_ptr<Index>& indexptr, std::unique_ptr<ReaderInterface>& docreader, std::vector<std::string>& arguments);
+void commandBulkBuild(std::unique_ptr<Index>& indexptr, std::unique_ptr<ReaderInterface>& docreader, std::vector<std::string>& arguments);
+void commandQuery(std::unique_ptr<Index>& indexptr, std::vector<std::string>& arguments);
+void commandPhrase(std::unique_ptr<Index>& indexptr, std::vector<std::string>& arguments);
+void commandNear(std::unique_ptr<Index>& indexptr, std::vector<std::string>& arguments);
+void commandMetrics(std::vector<std::string>& arguments);
+void commandMetricsDump(std::vector<std::string>& arguments);
 
 #endif
\ No newline at end of file
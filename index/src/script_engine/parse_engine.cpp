@@ -1,5 +1,7 @@
 #include "parse_engine.hpp"
 
+#include <fstream>
+
 #include "index.hpp"
 #include "document_readers/WETreader.hpp"
 #include "document_readers/RAWreader.hpp"
@@ -54,8 +56,32 @@ void parseCode(std::vector<std::string>& code, size_t begin, size_t end, std::st
             commandInsert(indexptr, docreader, arguments);
             linenum++;
         }
+        else if(command == "insertbatch") {
+            commandInsertBatch(indexptr, docreader, arguments);
+            linenum++;
+        }
+        else if(command == "bulkbuild") {
+            commandBulkBuild(indexptr, docreader, arguments);
+            linenum++;
+        }
         else if(command == "query") {
-            std::cout << "Query not implemented!" << std::endl;
+            commandQuery(indexptr, arguments);
+            linenum++;
+        }
+        else if(command == "phrase") {
+            commandPhrase(indexptr, arguments);
+            linenum++;
+        }
+        else if(command == "near") {
+            commandNear(indexptr, arguments);
+            linenum++;
+        }
+        else if(command == "metrics") {
+            commandMetrics(arguments);
+            linenum++;
+        }
+        else if(command == "metricsdump") {
+            commandMetricsDump(arguments);
             linenum++;
         }
         else if(command == "setdir") {
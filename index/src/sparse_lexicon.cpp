@@ -104,6 +104,22 @@ void SparseExtendedLexicon::printSize() {
     std::cerr << "inonposlex: " << counter << std::endl;
 }
 
+std::map<unsigned int, unsigned long> SparseExtendedLexicon::getPosEntries(unsigned int indexnum, bool isZindex) {
+    std::vector<std::map<unsigned int, unsigned long>>& lex = isZindex ? zposlex : iposlex;
+
+    if(indexnum >= lex.size())
+        return std::map<unsigned int, unsigned long>();
+    return lex[indexnum];
+}
+
+std::map<unsigned int, unsigned long> SparseExtendedLexicon::getNonPosEntries(unsigned int indexnum, bool isZindex) {
+    std::vector<std::map<unsigned int, unsigned long>>& lex = isZindex ? znonposlex : inonposlex;
+
+    if(indexnum >= lex.size())
+        return std::map<unsigned int, unsigned long>();
+    return lex[indexnum];
+}
+
 void SparseExtendedLexicon::dump(nlohmann::json& jobject) {
     for(size_t i = 0; i < zposlex.size(); i++) {
         for(auto mapiter = zposlex[i].begin(); mapiter != zposlex[i].end(); mapiter++) {
@@ -17,6 +17,10 @@ public:
     unsigned long getPosLEQOffset(unsigned int termID, unsigned int indexnum, bool isZindex);
     unsigned long getNonPosLEQOffset(unsigned int termID, unsigned int indexnum, bool isZindex);
 
+    //Copy of the entries of a single index
+    std::map<unsigned int, unsigned long> getPosEntries(unsigned int indexnum, bool isZindex);
+    std::map<unsigned int, unsigned long> getNonPosEntries(unsigned int indexnum, bool isZindex);
+
     void dump(nlohmann::json& jobject);
     void restore(nlohmann::json& jobject);
     void clear();
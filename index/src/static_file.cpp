@@ -0,0 +1,101 @@
+#include "static_file.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+StaticFileHandle::StaticFileHandle(const std::string& path, unsigned long generation,
+    std::map<unsigned int, unsigned long> sparselex) : path(path), generation(generation), sparselex(sparselex)
+{
+    //WARNING: Uses unix-specific file separators
+    std::string filename = path.substr(path.find_last_of('/') + 1);
+    if(filename.size() < 2 || (filename[0] != 'Z' && filename[0] != 'I'))
+        throw std::invalid_argument("Error, index name " + filename + " is invalid");
+    zindex = (filename[0] == 'Z');
+    indexnum = std::stoul(filename.substr(1));
+
+    fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("Error: could not open static index " + path + ": " + std::strerror(errno));
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Error: could not stat static index " + path);
+    }
+    size = st.st_size;
+}
+
+StaticFileHandle::~StaticFileHandle() {
+    close(fd);
+}
+
+void StaticFileHandle::read(void* buffer, size_t n, size_t offset) const {
+    char* dest = static_cast<char*>(buffer);
+    while(n > 0) {
+        ssize_t got = pread(fd, dest, n, offset);
+        if(got < 0 && errno == EINTR)
+            continue;
+        if(got <= 0)
+            throw std::runtime_error("Error: short read from static index " + path + " at " + std::to_string(offset));
+        dest += got;
+        offset += got;
+        n -= got;
+    }
+}
+
+std::vector<uint8_t> StaticFileHandle::readBytes(size_t n, size_t offset) const {
+    std::vector<uint8_t> buffer(n);
+    if(n > 0)
+        read(buffer.data(), n, offset);
+    return buffer;
+}
+
+unsigned long StaticFileHandle::getLEQOffset(unsigned int termID) const {
+    auto iter = sparselex.upper_bound(termID);
+    //No entry at or before termID, so the list can only be found by scanning from the start
+    if(iter == sparselex.begin())
+        return 0;
+    iter--;
+    return iter->second;
+}
+
+size_t StaticFileHandle::findPostingList(unsigned int termID) const {
+    //Every posting list starts with its termID and its length in bytes
+    size_t pos = getLEQOffset(termID);
+    while(true) {
+        if(pos + 8 > size)
+            throw std::invalid_argument("Error, term does not exist in index");
+
+        unsigned int disktermID = readValue<unsigned int>(pos);
+        if(disktermID == termID)
+            return pos;
+        if(disktermID > termID)
+            throw std::invalid_argument("Error, term does not exist in index");
+
+        pos += readValue<unsigned int>(pos + 4);
+    }
+}
+
+const std::string& StaticFileHandle::getPath() const {
+    return path;
+}
+
+size_t StaticFileHandle::getSize() const {
+    return size;
+}
+
+unsigned long StaticFileHandle::getGeneration() const {
+    return generation;
+}
+
+unsigned int StaticFileHandle::getIndexNumber() const {
+    return indexnum;
+}
+
+bool StaticFileHandle::isZindex() const {
+    return zindex;
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef STATIC_FILE_HPP
+#define STATIC_FILE_HPP
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdint>
+
+/**
+ * Read-only handle to a static index file, shared by every snapshot that includes the file.
+ * The file stays open until the last snapshot using it is released, so queries can keep reading a file
+ * after a merge has deleted it. Reads use pread and can be made from any thread.
+ */
+class StaticFileHandle {
+public:
+    //sparselex is the part of the extended lexicon that points into this file
+    StaticFileHandle(const std::string& path, unsigned long generation, std::map<unsigned int, unsigned long> sparselex);
+    ~StaticFileHandle();
+
+    StaticFileHandle(const StaticFileHandle&) = delete;
+    StaticFileHandle& operator=(const StaticFileHandle&) = delete;
+
+    //Reads n bytes at offset into buffer. Throws if the file is shorter
+    void read(void* buffer, size_t n, size_t offset) const;
+    std::vector<uint8_t> readBytes(size_t n, size_t offset) const;
+    template <typename T>
+    T readValue(size_t offset) const {
+        T value;
+        read(&value, sizeof(value), offset);
+        return value;
+    }
+
+    //Offset of the closest posting list with a termID less than or equal to termID
+    unsigned long getLEQOffset(unsigned int termID) const;
+    //Offset of the posting list of termID, found by walking the lists from getLEQOffset.
+    //Throws std::invalid_argument if the term is not in the file
+    size_t findPostingList(unsigned int termID) const;
+
+    const std::string& getPath() const;
+    size_t getSize() const;
+    unsigned long getGeneration() const;
+    //Order of the index, parsed from the file name, which always follows the format (Z|I)(number)
+    unsigned int getIndexNumber() const;
+    bool isZindex() const;
+
+private:
+    std::string path;
+    int fd;
+    size_t size;
+    unsigned long generation;
+    unsigned int indexnum;
+    bool zindex;
+    std::map<unsigned int, unsigned long> sparselex;
+};
+
+//Every static index file that a snapshot can read
+using StaticFileSet = std::vector<std::shared_ptr<const StaticFileHandle>>;
+
+#endif
\ No newline at end of file
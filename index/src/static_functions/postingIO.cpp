@@ -1,6 +1,9 @@
 #include "postingIO.hpp"
 
 #include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
 
 #include "global_parameters.hpp"
 #include "compression_functions/varbyte.hpp"
@@ -16,6 +19,74 @@ std::vector<unsigned int> read_block(size_t buffersize, std::ifstream& ifile, st
 //Writes a posting list to disk with compression
 template <typename T>
 void write_postinglist(std::ofstream& ofile, unsigned int termID, std::vector<T>& postinglist, bool positional) {
+    PostingListWriter<T> writer(ofile, positional);
+    for(const T& posting : postinglist)
+        writer.add(posting);
+    writer.finish(termID);
+}
+
+template <typename T>
+PostingListWriter<T>::PostingListWriter(std::ofstream& ofile, bool positional, std::string spillpath)
+    : ofile(ofile), positional(positional), spillpath(spillpath), spilledbytes(0), postingcount(0) {}
+
+template <typename T>
+PostingListWriter<T>::~PostingListWriter() {
+    if(spill.is_open()) {
+        spill.close();
+        std::remove(spillpath.c_str());
+    }
+}
+
+template <typename T>
+void PostingListWriter<T>::add(const T& posting) {
+    blockdocID.push_back(posting.docID);
+    blocksecond.push_back(posting.second);
+    if(positional) blockthird.push_back(posting.third);
+    postingcount++;
+    if(blockdocID.size() == BLOCKSIZE)
+        compressBlock();
+}
+
+template <typename T>
+void PostingListWriter<T>::compressBlock() {
+    std::vector<uint8_t> compresseddocID = compress_block(blockdocID, VBEncode, true);
+    std::vector<uint8_t> compressedsecond = compress_block(blocksecond, VBEncode, false);
+    std::vector<uint8_t> compressedthird;
+    if(positional) compressedthird = compress_block(blockthird, VBEncode, false);
+
+    //Store the three vectors into the compressedblocks vector
+    compressedblocks.insert(compressedblocks.end(), compresseddocID.begin(), compresseddocID.end());
+    compressedblocks.insert(compressedblocks.end(), compressedsecond.begin(), compressedsecond.end());
+    if(positional) compressedblocks.insert(compressedblocks.end(), compressedthird.begin(), compressedthird.end());
+
+    //Store metadata
+    compressedblocksizes.push_back(compresseddocID.size());
+    compressedblocksizes.push_back(compressedsecond.size());
+    if(positional) compressedblocksizes.push_back(compressedthird.size());
+    lastdocID.push_back(blockdocID.back());
+
+    blockdocID.clear();
+    blocksecond.clear();
+    blockthird.clear();
+
+    if(!spillpath.empty() && compressedblocks.size() > MERGE_SPILL_BYTES) {
+        if(!spill.is_open()) {
+            spill.open(spillpath, std::ios::in | std::ios::out | std::ios::trunc | std::ios::binary);
+            if(!spill)
+                throw std::runtime_error("Error, could not create spill file " + spillpath);
+        }
+        spill.write(reinterpret_cast<const char*>(compressedblocks.data()), compressedblocks.size());
+        spilledbytes += compressedblocks.size();
+        compressedblocks.clear();
+    }
+}
+
+template <typename T>
+unsigned int PostingListWriter<T>::finish(unsigned int termID) {
+    //Extra postings at end of block
+    if(!blockdocID.empty())
+        compressBlock();
+
     //initialize compression method, 1: varbyte
     //compression method for docID
     unsigned int doc_method = 1;
@@ -24,78 +95,6 @@ void write_postinglist(std::ofstream& ofile, unsigned int termID, std::vector<T>
     //compression method for position
     unsigned int third_method = 1;
 
-    //Construct compressed blocks of postings in memory
-    std::vector<uint8_t> compressedblocks;
-    std::vector<unsigned int> lastdocID;
-    std::vector<unsigned int> compressedblocksizes;
-
-    //Begin inclusive, End exclusive
-    size_t blockbegin = 0;
-    size_t blockend = BLOCKSIZE;
-
-    while(blockend <= postinglist.size()) {
-        std::vector<unsigned int> blockdocID;
-        std::vector<unsigned int> blocksecond;
-        std::vector<unsigned int> blockthird;
-
-        //Grab blocksize number of postings
-        for(auto postingiter = postinglist.begin() + blockbegin; postingiter != postinglist.begin() + blockend; postingiter++) {
-            blockdocID.push_back(postingiter->docID);
-            blocksecond.push_back(postingiter->second);
-            if(positional) blockthird.push_back(postingiter->third);
-        }
-
-        //Compress the three vectors
-        std::vector<uint8_t> compresseddocID = compress_block(blockdocID, VBEncode, true);
-        std::vector<uint8_t> compressedsecond = compress_block(blocksecond, VBEncode, false);
-        std::vector<uint8_t> compressedthird;
-        if(positional) compressedthird = compress_block(blockthird, VBEncode, false);
-
-        //Store the three vectors into the compressedblocks vector
-        compressedblocks.insert(compressedblocks.end(), compresseddocID.begin(), compresseddocID.end());
-        compressedblocks.insert(compressedblocks.end(), compressedsecond.begin(), compressedsecond.end());
-        if(positional) compressedblocks.insert(compressedblocks.end(), compressedthird.begin(), compressedthird.end());
-
-        //Store metadata
-        compressedblocksizes.push_back(compresseddocID.size());
-        compressedblocksizes.push_back(compressedsecond.size());
-        if(positional) compressedblocksizes.push_back(compressedthird.size());
-        lastdocID.push_back(blockdocID.back());
-
-        blockbegin += BLOCKSIZE;
-        blockend += BLOCKSIZE;
-    }
-
-    //Extra postings at end of block
-    if(blockbegin != postinglist.size()) {
-        std::vector<unsigned int> blockdocID;
-        std::vector<unsigned int> blocksecond;
-        std::vector<unsigned int> blockthird;
-
-        for(auto postingiter = postinglist.begin() + blockbegin; postingiter != postinglist.end(); postingiter++) {
-            blockdocID.push_back(postingiter->docID);
-            blocksecond.push_back(postingiter->second);
-            if(positional) blockthird.push_back(postingiter->third);
-        }
-
-        //Compress the three vectors
-        std::vector<uint8_t> compresseddocID = compress_block(blockdocID, VBEncode, true);
-        std::vector<uint8_t> compressedsecond = compress_block(blocksecond, VBEncode, false);
-        std::vector<uint8_t> compressedthird;
-        if(positional) compressedthird = compress_block(blockthird, VBEncode, false);
-
-        //Store the three vectors into the compressedblocks vector
-        compressedblocks.insert(compressedblocks.end(), compresseddocID.begin(), compresseddocID.end());
-        compressedblocks.insert(compressedblocks.end(), compressedsecond.begin(), compressedsecond.end());
-        if(positional) compressedblocks.insert(compressedblocks.end(), compressedthird.begin(), compressedthird.end());
-
-        //Store metadata
-        compressedblocksizes.push_back(compresseddocID.size());
-        compressedblocksizes.push_back(compressedsecond.size());
-        if(positional) compressedblocksizes.push_back(compressedthird.size());
-        lastdocID.push_back(blockdocID.back());
-    }
-
     //Compress the lastdocID and blocksize vectors
     std::vector<uint8_t> b_compressedblocksizes = compress_block(compressedblocksizes, VBEncode, false);
     std::vector<uint8_t> b_lastdocID = compress_block(lastdocID, VBEncode, false);
@@ -104,8 +103,8 @@ void write_postinglist(std::ofstream& ofile, unsigned int termID, std::vector<T>
     //4 bytes per int * 8 plain ints = 32
     unsigned int lastdocIDlength = b_lastdocID.size();
     unsigned int blocksizeslength = b_compressedblocksizes.size();
-    unsigned int blockslength = compressedblocks.size();
-    unsigned int totalbytes = 32 + b_lastdocID.size() + b_compressedblocksizes.size() + compressedblocks.size();
+    unsigned int blockslength = spilledbytes + compressedblocks.size();
+    unsigned int totalbytes = 32 + b_lastdocID.size() + b_compressedblocksizes.size() + blockslength;
     //Add extra int for positional
     if(positional) totalbytes += 4;
 
@@ -113,7 +112,7 @@ void write_postinglist(std::ofstream& ofile, unsigned int termID, std::vector<T>
     //TODO: Compress metadata
     writeAsBytes(termID, ofile);
     writeAsBytes(totalbytes, ofile);
-    writeAsBytes((unsigned int)postinglist.size(), ofile);
+    writeAsBytes(postingcount, ofile);
     writeAsBytes(doc_method, ofile);
     writeAsBytes(second_method, ofile);
     if(positional) writeAsBytes(third_method, ofile);
@@ -124,7 +123,76 @@ void write_postinglist(std::ofstream& ofile, unsigned int termID, std::vector<T>
     writeAsBytes(blocksizeslength, ofile);
     writeBytesBlock(b_compressedblocksizes, ofile);
     writeAsBytes(blockslength, ofile);
+    if(spilledbytes > 0) {
+        //Spilled blocks come first, and the spill file is reused by the next list
+        spill.flush();
+        spill.seekg(0);
+        std::vector<char> buffer(std::min<unsigned long>(spilledbytes, 1UL << 20));
+        for(unsigned long copied = 0; copied < spilledbytes; copied += buffer.size()) {
+            size_t count = std::min<unsigned long>(buffer.size(), spilledbytes - copied);
+            spill.read(buffer.data(), count);
+            ofile.write(buffer.data(), count);
+        }
+        spill.clear();
+        spill.seekp(0);
+    }
     writeBytesBlock(compressedblocks, ofile);
+
+    unsigned int count = postingcount;
+    compressedblocks.clear();
+    lastdocID.clear();
+    compressedblocksizes.clear();
+    spilledbytes = 0;
+    postingcount = 0;
+    return count;
+}
+
+template <typename T>
+PostingListReader<T>::PostingListReader(std::ifstream& ifile, unsigned int termID, bool positional)
+    : ifile(ifile), termID(termID), positional(positional), nextfield(0), index(0)
+{
+    unsigned int totalbytes;
+    readFromBytes(totalbytes, ifile);
+    if(totalbytes <= (positional ? 36u : 32u))
+        throw std::runtime_error("Error, invalid posting list size in static block: " + std::to_string(totalbytes));
+
+    //Skip the posting count, compression methods and lastdocID
+    ifile.ignore(positional ? 16 : 12);
+    unsigned int lastdocIDlen;
+    readFromBytes(lastdocIDlen, ifile);
+    ifile.ignore(lastdocIDlen);
+
+    unsigned int blocksizeslength;
+    readFromBytes(blocksizeslength, ifile);
+    std::vector<uint8_t> b_blocksizes = readBytesBlock(blocksizeslength, ifile);
+    blocksizes = decompress_block(b_blocksizes, VBDecode, false);
+    if(blocksizes.size() % (positional ? 3 : 2) != 0)
+        throw std::invalid_argument("Error, blocksize array does not match the posting fields: " + std::to_string(blocksizes.size()));
+
+    //Skip blocks int
+    unsigned int blockslength;
+    readFromBytes(blockslength, ifile);
+}
+
+template <typename T>
+bool PostingListReader<T>::next(T& posting) {
+    if(index == docIDs.size()) {
+        if(nextfield == blocksizes.size())
+            return false;
+        docIDs = read_block(blocksizes[nextfield++], ifile, VBDecode, true);
+        secondvec = read_block(blocksizes[nextfield++], ifile, VBDecode, false);
+        if(positional) thirdvec = read_block(blocksizes[nextfield++], ifile, VBDecode, false);
+        if(docIDs.size() != secondvec.size() || (positional && secondvec.size() != thirdvec.size()))
+            throw std::invalid_argument("Error, vectors mismatched in size while reading index");
+        index = 0;
+    }
+
+    posting.termID = termID;
+    posting.docID = docIDs[index];
+    posting.second = secondvec[index];
+    if(positional) posting.third = thirdvec[index];
+    index++;
+    return true;
 }
 
 //Given an ifstream, read the positional posting list indicated by the metadata
@@ -276,4 +344,8 @@ std::vector<nPosting> read_nonpos_postinglist(std::ifstream& ifile, unsigned int
 
 //Explicitly instantiate templates for write_postinglist
 template void write_postinglist<Posting>(std::ofstream& ofile, unsigned int termID, std::vector<Posting>& postinglist, bool positional);
-template void write_postinglist<nPosting>(std::ofstream& ofile, unsigned int termID, std::vector<nPosting>& postinglist, bool positional);
\ No newline at end of file
+template void write_postinglist<nPosting>(std::ofstream& ofile, unsigned int termID, std::vector<nPosting>& postinglist, bool positional);
+template class PostingListWriter<Posting>;
+template class PostingListWriter<nPosting>;
+template class PostingListReader<Posting>;
+template class PostingListReader<nPosting>;
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <fstream>
+#include <string>
+#include <cstdint>
 
 #include "posting.hpp"
 
@@ -19,6 +21,66 @@ std::vector<unsigned int> read_block(size_t buffersize, std::ifstream& ifile, st
 template <typename T>
 void write_postinglist(std::ofstream& ofile, unsigned int termID, std::vector<T>& postinglist, bool positional);
 
+//Writes posting lists one posting at a time, in the layout of write_postinglist. Each block is compressed as soon as it
+//is full, so a list's postings are never all in memory. The compressed blocks follow the metadata in the layout, so
+//they are kept until the list is finished. Past MERGE_SPILL_BYTES they are moved to the file at spillpath, if given
+template <typename T>
+class PostingListWriter {
+public:
+    PostingListWriter(std::ofstream& ofile, bool positional, std::string spillpath = "");
+    ~PostingListWriter();
+
+    //Postings must be added in docID order
+    void add(const T& posting);
+    //Writes the list of termID and returns its length in postings. The next posting added starts a new list
+    unsigned int finish(unsigned int termID);
+
+private:
+    void compressBlock();
+
+    std::ofstream& ofile;
+    bool positional;
+    std::string spillpath;
+    std::fstream spill;
+    unsigned long spilledbytes;
+
+    //Fields of the postings of the block being filled
+    std::vector<unsigned int> blockdocID;
+    std::vector<unsigned int> blocksecond;
+    std::vector<unsigned int> blockthird;
+
+    std::vector<uint8_t> compressedblocks;
+    std::vector<unsigned int> lastdocID;
+    std::vector<unsigned int> compressedblocksizes;
+    unsigned int postingcount;
+};
+
+//Reads a posting list one block at a time
+//Assumes file stream is pointing to the unsigned int after termID, and leaves it after the list once all are read
+template <typename T>
+class PostingListReader {
+public:
+    PostingListReader(std::ifstream& ifile, unsigned int termID, bool positional);
+
+    //Sets posting to the next posting of the list. Returns false once there are none left
+    bool next(T& posting);
+
+private:
+    std::ifstream& ifile;
+    unsigned int termID;
+    bool positional;
+
+    //Compressed sizes of each field of each block
+    std::vector<unsigned int> blocksizes;
+    size_t nextfield;
+
+    //Fields of the current block
+    std::vector<unsigned int> docIDs;
+    std::vector<unsigned int> secondvec;
+    std::vector<unsigned int> thirdvec;
+    size_t index;
+};
+
 //Reads a posting list from disk
 //Assumes file stream is pointing to the unsigned int after termID
 std::vector<Posting> read_pos_postinglist(std::ifstream& ifile, unsigned int termID);
@@ -1,10 +1,15 @@
 #include "static_index.hpp"
 
 #include <iostream>
+#include <algorithm>
+#include <queue>
+#include <cstdio>
 
 #include "static_functions/postingIO.hpp"
 #include "static_functions/bytesIO.hpp"
 #include "utility/util.hpp"
+#include "utility/timer.hpp"
+#include "utility/metrics.hpp"
 
 //Copies n bytes from the ifstream to the ofstream
 //Returns 0 on success
@@ -47,17 +52,178 @@ unsigned int copyPostingList(unsigned int termID, std::ifstream& ifile, std::ofs
     return postinglistcount;
 }
 
+//Renumbers the postings of a list with docIDmap, then sorts them again
+//The sort is stable, so the positions of each document stay in order
+template <typename T>
+void remapDocIDs(std::vector<T>& postinglist, const std::vector<unsigned int>& docIDmap) {
+    for(T& posting : postinglist) {
+        if(posting.docID < docIDmap.size())
+            posting.docID = docIDmap[posting.docID];
+    }
+    std::stable_sort(postinglist.begin(), postinglist.end());
+}
+
+//Renumbers the documents of a run file with docIDmap, so that each of its lists is sorted by the new docIDs
+//Lists are read and sorted one at a time, so memory only grows with the longest list of the run
+template <typename T>
+void remapRun(const std::string& path, bool positional, const std::vector<unsigned int>& docIDmap) {
+    std::string remappedpath = path + "remapped";
+    std::ifstream ifile(path);
+    std::ofstream ofile(remappedpath);
+    if(!ofile)
+        throw std::runtime_error("Error, could not create run " + remappedpath);
+
+    std::vector<T> postinglist;
+    unsigned int termID;
+    readFromBytes(termID, ifile);
+    while(ifile) {
+        PostingListReader<T> reader(ifile, termID, positional);
+        postinglist.clear();
+        T posting;
+        while(reader.next(posting))
+            postinglist.push_back(posting);
+        remapDocIDs(postinglist, docIDmap);
+        write_postinglist(ofile, termID, postinglist, positional);
+        readFromBytes(termID, ifile);
+    }
+
+    ifile.close();
+    ofile.close();
+    if(std::rename(remappedpath.c_str(), path.c_str()) != 0)
+        throw std::runtime_error("Error, could not replace run " + path);
+}
+
+//Merges the lists of termID in the given runs by docID, reading and writing them a block at a time
+//A document is only ever in one run, so its postings are taken together and keep their order
+template <typename T>
+unsigned int mergeRunLists(unsigned int termID, std::vector<std::ifstream>& inputs, const std::vector<size_t>& sources,
+    PostingListWriter<T>& writer, bool positional)
+{
+    std::vector<PostingListReader<T>> readers;
+    readers.reserve(sources.size());
+    std::vector<T> current(sources.size());
+    //The docID of the next posting of each source, smallest first
+    using Head = std::pair<unsigned int, size_t>;
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for(size_t i = 0; i < sources.size(); ++i) {
+        readers.emplace_back(inputs[sources[i]], termID, positional);
+        if(readers[i].next(current[i]))
+            heads.emplace(current[i].docID, i);
+    }
+
+    while(!heads.empty()) {
+        size_t i = heads.top().second;
+        heads.pop();
+        unsigned int docID = current[i].docID;
+        bool more;
+        do {
+            writer.add(current[i]);
+            more = readers[i].next(current[i]);
+        } while(more && current[i].docID == docID);
+        if(more)
+            heads.emplace(current[i].docID, i);
+    }
+    return writer.finish(termID);
+}
+
+//Records a flush of the in-memory index into the metrics registry
+void recordFlush(long long ns, unsigned long bytes) {
+    static Metrics::Histogram& flushhist = Metrics::histogram("static.flush_ns");
+    static Metrics::Counter& flushbytes = Metrics::counter("static.flush_bytes");
+    static Metrics::Counter& flushcount = Metrics::counter("static.flush_count");
+    flushhist.record(ns);
+    flushbytes.add(bytes);
+    flushcount.add();
+}
+
+//Gets the type and order of an index from its name, which always follows the format (Z|I)(number)
+void parseIndexName(std::string& indexname, bool& isZindex, unsigned int& indexnum) {
+    if(indexname.empty())
+        throw std::invalid_argument("Error, index name is empty");
+
+    if(indexname[0] == 'Z')
+        isZindex = true;
+    else if(indexname[0] == 'I')
+        isZindex = false;
+    else
+        throw std::invalid_argument("Error, index name " + indexname + " is invalid");
+
+    indexnum = std::stoul(indexname.substr(1));
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 StaticIndex::StaticIndex(std::string& working_dir) : INDEXDIR("./" + working_dir + GlobalConst::IndexPath),
     PDIR("./" + working_dir + GlobalConst::PosPath),
-    NPDIR("./" + working_dir + GlobalConst::NonPosPath)
+    NPDIR("./" + working_dir + GlobalConst::NonPosPath), blockcache(BLOCK_CACHE_BYTES), nextgeneration(0),
+    posrunpostings(0), nonposrunpostings(0)
 {}
 
 SparseExtendedLexicon* StaticIndex::getExLexPointer() {
     return &spexlex;
 }
 
+const StaticIndex::IOStats& StaticIndex::getStats() const {
+    return stats;
+}
+
+std::string StaticIndex::getNonPosDir() {
+    return NPDIR;
+}
+
+BlockCache& StaticIndex::getBlockCache() {
+    return blockcache;
+}
+
+unsigned long StaticIndex::getFileGeneration(const std::string& path) {
+    //Files left over from a previous run get their generation on first use
+    auto iter = filegenerations.find(path);
+    if(iter == filegenerations.end())
+        iter = filegenerations.emplace(path, nextgeneration++).first;
+    return iter->second;
+}
+
+std::shared_ptr<const StaticFileSet> StaticIndex::openNonPosFiles(bool reopen) {
+    return openFiles(false, reopen);
+}
+
+std::shared_ptr<const StaticFileSet> StaticIndex::openPosFiles(bool reopen) {
+    return openFiles(true, reopen);
+}
+
+std::shared_ptr<const StaticFileSet> StaticIndex::openFiles(bool positional, bool reopen) {
+    std::string directory = positional ? PDIR : NPDIR;
+    std::map<std::string, std::shared_ptr<const StaticFileHandle>>& openfiles = positional ? openposfiles : opennonposfiles;
+
+    auto files = std::make_shared<StaticFileSet>();
+    std::map<std::string, std::shared_ptr<const StaticFileHandle>> stillopen;
+
+    for(std::string& name : Utility::readDirectory(directory)) {
+        std::string path = directory + name;
+        unsigned long generation = getFileGeneration(path);
+
+        auto iter = openfiles.find(path);
+        std::shared_ptr<const StaticFileHandle> handle;
+        if(!reopen && iter != openfiles.end() && iter->second->getGeneration() == generation) {
+            handle = iter->second;
+        }
+        else {
+            bool isZindex;
+            unsigned int indexnum;
+            parseIndexName(name, isZindex, indexnum);
+            handle = std::make_shared<const StaticFileHandle>(path, generation,
+                positional ? spexlex.getPosEntries(indexnum, isZindex) : spexlex.getNonPosEntries(indexnum, isZindex));
+        }
+
+        files->push_back(handle);
+        stillopen[path] = handle;
+    }
+
+    //Handles of deleted files are closed once the last snapshot using them is gone
+    openfiles.swap(stillopen);
+    return files;
+}
+
 //Writes the positional index to disk, which means it is saved either in file Z0 or I0.
 void StaticIndex::write_p_disk(GlobalType::PosMapIter indexbegin, GlobalType::PosMapIter indexend) {
     std::string filename = PDIR;
@@ -69,11 +235,20 @@ void StaticIndex::write_p_disk(GlobalType::PosMapIter indexbegin, GlobalType::Po
         indexname = "Z0";
 
     std::ofstream ofile(filename + indexname);
+    filegenerations[filename + indexname] = nextgeneration++;
 
     if (ofile.is_open()){
+        Utility::Timer stopwatch;
+        stopwatch.start();
         write_index<GlobalType::PosMapIter>(indexname, ofile, true, indexbegin, indexend);
+        unsigned long flushbytes = ofile.tellp();
+        stats.flushbytes += flushbytes;
 
         ofile.close();
+        stopwatch.stop();
+        stats.flushns += stopwatch.getCumulativeNanos();
+        stats.flushcount++;
+        recordFlush(stopwatch.getCumulativeNanos(), flushbytes);
     }else{
         std::cerr << "File cannot be opened." << std::endl;
     }
@@ -82,7 +257,7 @@ void StaticIndex::write_p_disk(GlobalType::PosMapIter indexbegin, GlobalType::Po
 }
 
 //Writes the non-positional index to disk, which is saved in either file Z0 or I0
-void StaticIndex::write_np_disk(GlobalType::NonPosMapIter indexbegin, GlobalType::NonPosMapIter indexend) {
+void StaticIndex::write_np_disk(const NonPosMemtable& memtable) {
     std::string filename = NPDIR;
     std::string indexname;
     //Z0 exists
@@ -92,11 +267,20 @@ void StaticIndex::write_np_disk(GlobalType::NonPosMapIter indexbegin, GlobalType
         indexname = "Z0";
 
     std::ofstream ofile(filename + indexname);
+    filegenerations[filename + indexname] = nextgeneration++;
 
     if (ofile.is_open()){
-        write_index<GlobalType::NonPosMapIter>(indexname, ofile, false, indexbegin, indexend);
+        Utility::Timer stopwatch;
+        stopwatch.start();
+        write_memtable(indexname, ofile, memtable);
+        unsigned long flushbytes = ofile.tellp();
+        stats.flushbytes += flushbytes;
 
         ofile.close();
+        stopwatch.stop();
+        stats.flushns += stopwatch.getCumulativeNanos();
+        stats.flushcount++;
+        recordFlush(stopwatch.getCumulativeNanos(), flushbytes);
     }else{
         std::cerr << "File cannot be opened." << std::endl;
     }
@@ -108,18 +292,9 @@ void StaticIndex::write_np_disk(GlobalType::NonPosMapIter indexbegin, GlobalType
 //indexname: The name of the index being written to. Always follows the format (Z|I)(number)
 template <typename T>
 void StaticIndex::write_index(std::string& indexname, std::ofstream& ofile, bool positional, T indexbegin, T indexend) {
-    if(indexname.empty())
-        throw std::invalid_argument("Error, index name is empty");
-    
     bool isZindex;
-    if(indexname[0] == 'Z')
-        isZindex = true;
-    else if(indexname[0] == 'I')
-        isZindex = false;
-    else
-        throw std::invalid_argument("Error, index name " + indexname + " is invalid");
-
-    unsigned int indexnum = std::stoul(indexname.substr(1));
+    unsigned int indexnum;
+    parseIndexName(indexname, isZindex, indexnum);
 
     //Counts how many postings have accumulated since the last pointer inserted in the extended lexicon
     size_t postingcount = 0;
@@ -128,14 +303,190 @@ void StaticIndex::write_index(std::string& indexname, std::ofstream& ofile, bool
 
     //for each posting list in the index
     for(auto postinglistiter = indexbegin; postinglistiter != indexend; postinglistiter++) {
-        shouldGetLexEntry(postinglistiter->second.size(), postinglistiter->first, indexnum, isZindex, ofile.tellp(),
+        //In-memory lists are in insertion order, but docIDs are delta compressed on disk.
+        //The list is sorted as a copy since queries may be reading the in-memory index
+        auto postinglist = postinglistiter->second;
+        std::stable_sort(postinglist.begin(), postinglist.end());
+
+        shouldGetLexEntry(postinglist.size(), postinglistiter->first, indexnum, isZindex, ofile.tellp(),
             positional, postingcount, lastlisthadpointer);
 
         //Write out the posting list to disk
-        write_postinglist(ofile, postinglistiter->first, postinglistiter->second, positional);
+        write_postinglist(ofile, postinglistiter->first, postinglist, positional);
     }
 }
 
+//Writes the in-memory non-positional index to disk. Its posting lists are already kept sorted
+void StaticIndex::write_memtable(std::string& indexname, std::ofstream& ofile, const NonPosMemtable& memtable) {
+    bool isZindex;
+    unsigned int indexnum;
+    parseIndexName(indexname, isZindex, indexnum);
+
+    size_t postingcount = 0;
+    bool lastlisthadpointer = false;
+
+    for(auto& entry : memtable.getLists()) {
+        std::vector<nPosting> postinglist = entry.second->toVector();
+
+        shouldGetLexEntry(postinglist.size(), entry.first, indexnum, isZindex, ofile.tellp(),
+            false, postingcount, lastlisthadpointer);
+
+        write_postinglist(ofile, entry.first, postinglist, false);
+    }
+}
+
+void StaticIndex::write_run(std::vector<Posting>& postings) {
+    write_run(postings, true);
+}
+
+void StaticIndex::write_run(std::vector<nPosting>& postings) {
+    write_run(postings, false);
+}
+
+size_t StaticIndex::getRunCount() const {
+    return std::max(posruns.size(), nonposruns.size());
+}
+
+//Runs are written like any other index, but without extended lexicon entries since they are only read sequentially
+template <typename T>
+void StaticIndex::write_run(std::vector<T>& postings, bool positional) {
+    std::vector<std::string>& runs = positional ? posruns : nonposruns;
+    std::string path = INDEXDIR + (positional ? "posrun" : "nonposrun") + std::to_string(runs.size());
+
+    Utility::Timer stopwatch;
+    stopwatch.start();
+    std::ofstream ofile(path);
+    if(!ofile)
+        throw std::runtime_error("Error, could not create run " + path);
+
+    std::vector<T> postinglist;
+    for(size_t begin = 0; begin < postings.size();) {
+        unsigned int termID = postings[begin].termID;
+        size_t end = begin;
+        while(end < postings.size() && postings[end].termID == termID)
+            end++;
+
+        postinglist.assign(postings.begin() + begin, postings.begin() + end);
+        write_postinglist(ofile, termID, postinglist, positional);
+        begin = end;
+    }
+
+    unsigned long flushbytes = ofile.tellp();
+    ofile.close();
+    stopwatch.stop();
+
+    runs.push_back(path);
+    (positional ? posrunpostings : nonposrunpostings) += postings.size();
+    stats.flushbytes += flushbytes;
+    stats.flushns += stopwatch.getCumulativeNanos();
+    stats.flushcount++;
+    recordFlush(stopwatch.getCumulativeNanos(), flushbytes);
+}
+
+void StaticIndex::merge_runs(unsigned long postinglimit, const std::vector<unsigned int>& docIDmap) {
+    if(!Utility::readDirectory(PDIR).empty() || !Utility::readDirectory(NPDIR).empty())
+        throw std::runtime_error("Error, runs can only be merged into an empty index");
+
+    merge_run_files(true, postinglimit, docIDmap);
+    merge_run_files(false, postinglimit, docIDmap);
+}
+
+void StaticIndex::merge_run_files(bool positional, unsigned long postinglimit, const std::vector<unsigned int>& docIDmap) {
+    std::vector<std::string>& runs = positional ? posruns : nonposruns;
+    unsigned long long& runpostings = positional ? posrunpostings : nonposrunpostings;
+    if(runs.empty())
+        return;
+
+    Utility::Timer stopwatch;
+    stopwatch.start();
+
+    //Later flushes then start their own Z0 and only merge into this index once they have grown as large
+    unsigned int indexnum = 0;
+    while(indexnum < 63 && ((unsigned long long)std::max(postinglimit, 1UL) << indexnum) < runpostings)
+        indexnum++;
+
+    std::string dir = positional ? PDIR : NPDIR;
+    std::string path = dir + "Z" + std::to_string(indexnum);
+    std::ofstream ofile(path);
+    if(!ofile)
+        throw std::runtime_error("Error, could not create index " + path);
+    filegenerations[path] = nextgeneration++;
+
+    //Renumbered runs are sorted again first, so that every run stays sorted by docID for the merge
+    if(!docIDmap.empty()) {
+        for(std::string& run : runs) {
+            if(positional)
+                remapRun<Posting>(run, true, docIDmap);
+            else
+                remapRun<nPosting>(run, false, docIDmap);
+        }
+    }
+
+    //The next termID of each run, smallest first
+    using RunHead = std::pair<unsigned int, size_t>;
+    std::priority_queue<RunHead, std::vector<RunHead>, std::greater<RunHead>> heads;
+    std::vector<std::ifstream> inputs;
+    for(size_t run = 0; run < runs.size(); ++run) {
+        inputs.emplace_back(runs[run]);
+        unsigned int termID;
+        readFromBytes(termID, inputs[run]);
+        if(inputs[run])
+            heads.emplace(termID, run);
+    }
+
+    std::string spillpath = INDEXDIR + "mergespill";
+    PostingListWriter<Posting> poswriter(ofile, true, spillpath);
+    PostingListWriter<nPosting> nonposwriter(ofile, false, spillpath);
+    size_t postingcount = 0;
+    bool lastlisthadpointer = false;
+    std::vector<size_t> sources;
+    while(!heads.empty()) {
+        unsigned int termID = heads.top().first;
+        //Ties are broken by run, so the sources come out in docID order
+        sources.clear();
+        while(!heads.empty() && heads.top().first == termID) {
+            sources.push_back(heads.top().second);
+            heads.pop();
+        }
+
+        unsigned long pos = ofile.tellp();
+        unsigned int postingsize;
+        if(sources.size() == 1)
+            postingsize = copyPostingList(termID, inputs[sources[0]], ofile);
+        else if(positional)
+            postingsize = mergeRunLists(termID, inputs, sources, poswriter, true);
+        else
+            postingsize = mergeRunLists(termID, inputs, sources, nonposwriter, false);
+        shouldGetLexEntry(postingsize, termID, indexnum, true, pos, positional, postingcount, lastlisthadpointer);
+
+        for(size_t run : sources) {
+            unsigned int nexttermID;
+            readFromBytes(nexttermID, inputs[run]);
+            if(inputs[run])
+                heads.emplace(nexttermID, run);
+        }
+    }
+
+    unsigned long mergebytes = ofile.tellp();
+    ofile.close();
+    inputs.clear();
+    for(std::string& run : runs) {
+        if(remove(run.c_str()) != 0)
+            std::cerr << "Error deleting run " << run << std::endl;
+    }
+    runs.clear();
+    runpostings = 0;
+
+    stopwatch.stop();
+    stats.mergebytes += mergebytes;
+    stats.mergens += stopwatch.getCumulativeNanos();
+    stats.mergecount++;
+
+    Metrics::histogram("static.bulk_merge_ns").record(stopwatch.getCumulativeNanos());
+    Metrics::counter("static.bulk_merge_bytes").add(mergebytes);
+    Metrics::counter("static.merge_count").add();
+}
+
 /**
  * Test if there are two files of same index number on disk.
  * If there is, merge them and then call merge_test again until
@@ -172,6 +523,9 @@ void StaticIndex::merge_test(bool isPositional) {
  * this method is called.
  */
 void StaticIndex::merge(int indexnum, bool positional) {
+    Utility::Timer stopwatch;
+    stopwatch.start();
+
     std::ifstream zfilestream;
     std::ifstream ifilestream;
     std::ofstream ofile;
@@ -189,6 +543,7 @@ void StaticIndex::merge(int indexnum, bool positional) {
     bool isZindex = (flag == 'Z');
 
     ofile.open(dir + flag + std::to_string(indexnum + 1));
+    filegenerations[dir + flag + std::to_string(indexnum + 1)] = nextgeneration++;
 
     //Counts how many postings have accumulated since the last pointer inserted in the extended lexicon
     size_t postingcount = 0;
@@ -272,6 +627,9 @@ void StaticIndex::merge(int indexnum, bool positional) {
         readFromBytes(ItermID, ifilestream);
     }
 
+    unsigned long mergebytes = ofile.tellp();
+    stats.mergebytes += mergebytes;
+
     zfilestream.close();
     ifilestream.close();
     ofile.close();
@@ -283,6 +641,18 @@ void StaticIndex::merge(int indexnum, bool positional) {
     //deleting two files
     if( remove( filename1.c_str() ) != 0 ) std::cout << "Error deleting file" << std::endl;
     if( remove( filename2.c_str() ) != 0 ) std::cout << "Error deleting file" << std::endl;
+    filegenerations.erase(filename1);
+    filegenerations.erase(filename2);
+
+    stopwatch.stop();
+    stats.mergens += stopwatch.getCumulativeNanos();
+    stats.mergecount++;
+
+    //Merges are rare, so looking the per-level metrics up by name every time is fine
+    std::string level = "static.merge_level" + std::to_string(indexnum + 1);
+    Metrics::histogram(level + "_ns").record(stopwatch.getCumulativeNanos());
+    Metrics::counter(level + "_bytes").add(mergebytes);
+    Metrics::counter("static.merge_count").add();
 }
 
 //TODO: Refactor into class
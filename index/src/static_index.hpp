@@ -3,9 +3,13 @@
 
 #include <string>
 #include <vector>
+#include <map>
 
 #include "global_parameters.hpp"
 #include "sparse_lexicon.hpp"
+#include "static_file.hpp"
+#include "Structures/memtable.h"
+#include "query_processing/block_cache.hpp"
 
 /**
  * Responsible for writing and managing the static indexes on disk
@@ -15,24 +19,82 @@
 class StaticIndex {
 
 public:
+    //Running totals of the disk work done by the static index
+    struct IOStats {
+        unsigned long flushcount = 0;
+        unsigned long long flushbytes = 0;
+        long long flushns = 0;
+
+        unsigned long mergecount = 0;
+        unsigned long long mergebytes = 0;
+        long long mergens = 0;
+    };
+
     StaticIndex(std::string& workind_dir);
 
     void write_p_disk(GlobalType::PosMapIter indexbegin, GlobalType::PosMapIter indexend);
-    void write_np_disk(GlobalType::NonPosMapIter indexbegin, GlobalType::NonPosMapIter indexend);
+    //Each list is written sorted by docID. The memtable is only read, so queries may keep using it while it is written
+    void write_np_disk(const NonPosMemtable& memtable);
+
+    //Bulk builds write each batch of documents as a sorted run, which is not part of the index until merge_runs.
+    //Postings must be sorted by termID, then docID, and every docID of a run must be above those of earlier runs
+    void write_run(std::vector<Posting>& postings);
+    void write_run(std::vector<nPosting>& postings);
+    //Merges all runs into a single Z-index of each kind, of the order the usual chain of merges would have given
+    //it with in-memory indexes of postinglimit postings, and deletes the runs. There must be no other index files
+    //If docIDmap is not empty, every docID below its size is renumbered to docIDmap[docID] as lists are merged
+    void merge_runs(unsigned long postinglimit, const std::vector<unsigned int>& docIDmap = {});
+    //How many runs were written since the last merge_runs
+    size_t getRunCount() const;
 
     SparseExtendedLexicon* getExLexPointer();
+    const IOStats& getStats() const;
+
+    std::string getNonPosDir();
+    BlockCache& getBlockCache();
+    //Identifies the current contents of an index file. A file gets a new generation every time it is written,
+    //so cached data from an older file with the same name is never reused
+    unsigned long getFileGeneration(const std::string& path);
+
+    //Opens handles to every non-positional (or positional) index file currently on disk. Handles of unchanged files
+    //are reused, unless reopen is set, which is needed after the extended lexicon was replaced
+    std::shared_ptr<const StaticFileSet> openNonPosFiles(bool reopen = false);
+    std::shared_ptr<const StaticFileSet> openPosFiles(bool reopen = false);
 
 private:
 
     SparseExtendedLexicon spexlex;
+    IOStats stats;
 
     const std::string INDEXDIR;
     const std::string PDIR;
     const std::string NPDIR;
 
+    //Decoded blocks of static posting lists, shared by all queries
+    BlockCache blockcache;
+    std::map<std::string, unsigned long> filegenerations;
+    unsigned long nextgeneration;
+    std::map<std::string, std::shared_ptr<const StaticFileHandle>> opennonposfiles;
+    std::map<std::string, std::shared_ptr<const StaticFileHandle>> openposfiles;
+
+    //Sorted runs of a bulk build, in docID order, and the number of postings in them
+    std::vector<std::string> posruns;
+    std::vector<std::string> nonposruns;
+    unsigned long long posrunpostings;
+    unsigned long long nonposrunpostings;
+
+    std::shared_ptr<const StaticFileSet> openFiles(bool positional, bool reopen);
+
     //Writes an index (stored as a map of wordIDs to posting lists) to disk
     template <typename T>
     void write_index(std::string& indexname, std::ofstream& ofile, bool positional, T indexbegin, T indexend);
+    void write_memtable(std::string& indexname, std::ofstream& ofile, const NonPosMemtable& memtable);
+
+    template <typename T>
+    void write_run(std::vector<T>& postings, bool positional);
+    //Merges the runs of one kind with a multiway merge on termID, and a term's lists with a multiway merge on docID
+    //Renumbered runs are sorted again first. Lists are streamed a block at a time, so they are never all in memory
+    void merge_run_files(bool positional, unsigned long postinglimit, const std::vector<unsigned int>& docIDmap);
 
     //Checks whether there are any indexes that need to be merged (which is indicated by I-indexes)
     //and merges them until there are no more indexes to merge (no more I-indexes)
@@ -1,5 +1,8 @@
 #include "libs/catch.hpp"
 
+#include <random>
+#include <algorithm>
+
 #include "doc_analyzer/Matcher/blockmatching.hpp"
 
 //Test returns size of input
@@ -9,20 +12,20 @@ size_t getCommonBlocksSize(std::string a, std::string b, int blocksize) {
     return result.size();
 }
 
-std::vector<std::shared_ptr<Block>> getCommonBlocksTest(std::string a, std::string b, int blocksize) {
+std::vector<Block> getCommonBlocksTest(std::string a, std::string b, int blocksize) {
     StringEncoder se(a, b);
     auto result = getCommonBlocks(blocksize, se);
     return result;
 }
 
-void extendBlocksTest(std::vector<std::shared_ptr<Block>>& allblocks, std::string a, std::string b, int blocksize) {
+void extendBlocksTest(std::vector<Block>& allblocks, std::string a, std::string b, int blocksize) {
     StringEncoder se(a, b);
     allblocks = getCommonBlocks(blocksize, se);
     extendBlocks(allblocks, se);
 }
 
 //Simulates running all three functions to produce a final list of blocks
-void resolveIntersectionsTest(std::vector<std::shared_ptr<Block>>& allblocks, std::string a, std::string b, int blocksize) {
+void resolveIntersectionsTest(std::vector<Block>& allblocks, std::string a, std::string b, int blocksize) {
     StringEncoder se(a, b);
     allblocks = getCommonBlocks(blocksize, se);
     extendBlocks(allblocks, se);
@@ -45,7 +48,7 @@ TEST_CASE("Test getCommonBlocks", "[block]") {
 }
 
 TEST_CASE("Test extendBlocks", "[block]") {
-    std::vector<std::shared_ptr<Block>> testvec;
+    std::vector<Block> testvec;
 
     extendBlocksTest(testvec, "", "", 0);
     REQUIRE(testvec.size() == 0);
@@ -80,8 +83,8 @@ TEST_CASE("Test extendBlocks", "[block]") {
 
     extendBlocksTest(testvec, "a b b e f d e g r", "a b b e g r", 2);
     REQUIRE(testvec.size() == 2);
-    REQUIRE(testvec[0]->len == 4);
-    REQUIRE(testvec[1]->len == 3);
+    REQUIRE(testvec[0].len == 4);
+    REQUIRE(testvec[1].len == 3);
     testvec.clear();
 
     extendBlocksTest(testvec, "a b", "a b a b a b", 2);
@@ -122,7 +125,7 @@ TEST_CASE("Test extendBlocks", "[block]") {
 }
 
 TEST_CASE("Test resolveIntersections", "[block]") {
-    std::vector<std::shared_ptr<Block>> testvec;
+    std::vector<Block> testvec;
     
     resolveIntersectionsTest(testvec, "", "", 2);
     REQUIRE(testvec.size() == 0);
@@ -155,4 +158,55 @@ TEST_CASE("Test resolveIntersections", "[block]") {
     resolveIntersectionsTest(testvec, "a b c d e a b", "a b c f c d e g a b", 2);
     REQUIRE(testvec.size() == 6);
     testvec.clear();
+}
+
+//The rolling hash backend must find the same blocks as getCommonBlocks followed by extendBlocks
+void compareMaximalBlocks(std::string a, std::string b, int blocksize) {
+    std::vector<Block> expected;
+    extendBlocksTest(expected, a, b, blocksize);
+    StringEncoder se(a, b);
+    //extendBlocks leaves a single block unextended
+    if(expected.size() == 1)
+        extendBlock(expected[0], se);
+
+    std::vector<Block> result = getMaximalBlocks(blocksize, se);
+    std::sort(expected.begin(), expected.end(), compareStrict);
+    std::sort(result.begin(), result.end(), compareStrict);
+    REQUIRE(result.size() == expected.size());
+    for(size_t i = 0; i < result.size(); ++i) {
+        REQUIRE(result[i].oldloc == expected[i].oldloc);
+        REQUIRE(result[i].newloc == expected[i].newloc);
+        REQUIRE(result[i].len == expected[i].len);
+    }
+}
+
+TEST_CASE("Test getMaximalBlocks", "[block]") {
+    compareMaximalBlocks("", "", 0);
+    compareMaximalBlocks("", "a b c", 2);
+    compareMaximalBlocks("a b c d", "a b c d", 2);
+    compareMaximalBlocks("a b b c d c b", "a b b d c", 2);
+    compareMaximalBlocks("a b b e f d e g r", "a b b e g r", 2);
+    compareMaximalBlocks("a b", "a b a b a b", 2);
+    compareMaximalBlocks("a b a b a b", "a b", 2);
+    compareMaximalBlocks("a b c d e f g", "a b i a b c j c d e k c d e f g", 2);
+    compareMaximalBlocks("a b c d e a b", "a b c f c d e g a b", 2);
+    compareMaximalBlocks("a b c d z c d e f g y e f g", "a b c d e f g", 2);
+    compareMaximalBlocks("a b a b e a b a b", "a b a b a b a b", 2);
+
+    //Random edits over a small vocabulary, so that windows repeat
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> word(0, 5);
+    std::uniform_int_distribution<int> edit(0, 9);
+    for(int round = 0; round < 20; ++round) {
+        std::string a, b;
+        for(int i = 0; i < 300; ++i) {
+            std::string token = "w" + std::to_string(word(gen)) + " ";
+            a += token;
+            if(edit(gen) == 0)
+                b += "w" + std::to_string(word(gen)) + " ";
+            else if(edit(gen) != 0)
+                b += token;
+        }
+        compareMaximalBlocks(a, b, 3 + round % 4);
+    }
 }
\ No newline at end of file
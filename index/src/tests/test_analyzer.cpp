@@ -0,0 +1,131 @@
+#include "libs/catch.hpp"
+
+#include <string>
+#include <vector>
+
+#include "index.hpp"
+#include "doc_analyzer/analyzer.h"
+#include "Structures/documentstore.h"
+#include "Structures/translationtable.h"
+
+//The second version of a changes a few words in the middle of the first, so it has translations
+const std::vector<DocumentInput> documents = {
+    {"test_analyzer/a", "the quick brown fox jumps over the lazy dog while the farmer watches from the old red barn "
+        "and his wife bakes bread in the kitchen of the house on the hill above the river"},
+    {"test_analyzer/b", "a river runs through the valley below the hill and the farmer crosses it every morning "
+        "on his way to the fields where the wheat grows tall in the summer sun"},
+    {"test_analyzer/a", "the quick brown fox jumps over the lazy dog while the children play near the new blue shed "
+        "and his wife bakes bread in the kitchen of the house on the hill above the river"},
+    {"test_analyzer/c", "the old red barn burned down one winter night and the farmer built a new blue shed in the "
+        "spring with wood cut from the forest beyond the fields"}
+};
+
+TEST_CASE("Test splitting batches into rounds", "[analyzer]") {
+    REQUIRE(splitBatchRounds(documents) == (std::vector<std::pair<size_t, size_t>>{{0, 2}, {2, 4}}));
+    REQUIRE(splitBatchRounds({}).empty());
+
+    std::vector<DocumentInput> batch = {{"a", ""}, {"a", ""}, {"b", ""}, {"c", ""}, {"b", ""}, {"a", ""}};
+    REQUIRE(splitBatchRounds(batch) == (std::vector<std::pair<size_t, size_t>>{{0, 1}, {1, 4}, {4, 6}}));
+}
+
+void requireSameTranslations(const std::vector<Translation>& a, const std::vector<Translation>& b) {
+    REQUIRE(a.size() == b.size());
+    for(size_t i = 0; i < a.size(); ++i) {
+        REQUIRE(a[i].loc == b[i].loc);
+        REQUIRE(a[i].oldlen == b[i].oldlen);
+        REQUIRE(a[i].newlen == b[i].newlen);
+    }
+}
+
+//Needs the redis servers of the document store and the translation table, so it only runs when asked for with [redis]
+TEST_CASE("Test batched updates match single updates", "[analyzer][redis][.]") {
+    DocumentStore docstore;
+    TranslationTable transtable;
+    std::string timestamp = "0";
+
+    docstore.clear();
+    transtable.clear();
+    std::vector<MatcherInfo> single;
+    for(const DocumentInput& input : documents) {
+        std::string url = input.url;
+        single.push_back(indexUpdate(url, input.page, timestamp, docstore, transtable));
+    }
+    std::vector<int> singlelengths;
+    std::vector<std::vector<Translation>> singletranslations;
+    for(unsigned int docID = 0; docID < 3; ++docID) {
+        singlelengths.push_back(docstore.getDocLength(docID));
+        singletranslations.push_back(transtable.getTranslations(docID));
+    }
+
+    docstore.clear();
+    transtable.clear();
+    std::vector<MatcherInfo> batched;
+    std::vector<std::pair<size_t, size_t>> rounds = splitBatchRounds(documents);
+    REQUIRE(rounds.size() == 2);
+    for(auto& round : rounds) {
+        std::vector<MatcherInfo> results = indexUpdateBatch(documents, round.first, round.second, timestamp,
+            docstore, transtable);
+        for(MatcherInfo& info : results)
+            batched.push_back(std::move(info));
+    }
+
+    REQUIRE(batched.size() == single.size());
+    for(size_t i = 0; i < single.size(); ++i) {
+        REQUIRE(batched[i].docID == single[i].docID);
+        REQUIRE(batched[i].maxfragID == single[i].maxfragID);
+        REQUIRE(batched[i].postings.docID == single[i].postings.docID);
+        REQUIRE(batched[i].postings.npterms == single[i].postings.npterms);
+        REQUIRE(batched[i].postings.freqs == single[i].postings.freqs);
+        REQUIRE(batched[i].postings.pterms == single[i].postings.pterms);
+        REQUIRE(batched[i].postings.fragIDs == single[i].postings.fragIDs);
+        REQUIRE(batched[i].postings.positions == single[i].postings.positions);
+        requireSameTranslations(batched[i].translations, single[i].translations);
+    }
+    //The changed page of a has translations, which the batch must have appended to the stored ones
+    REQUIRE(!single[2].translations.empty());
+
+    for(unsigned int docID = 0; docID < 3; ++docID) {
+        REQUIRE(docstore.getDocLength(docID) == singlelengths[docID]);
+        requireSameTranslations(transtable.getTranslations(docID), singletranslations[docID]);
+    }
+
+    docstore.clear();
+    transtable.clear();
+}
+
+//Needs the redis servers of the document store and the translation table, so it only runs when asked for with [redis]
+TEST_CASE("Test batched inserts match single inserts", "[analyzer][redis][.]") {
+    Index index("test_analyzer");
+    std::vector<std::vector<std::string>> queries = {
+        {"the"}, {"farmer"}, {"barn"}, {"shed"}, {"river", "hill"}, {"children", "bread"}, {"wheat"}, {"forest"}
+    };
+    std::vector<std::vector<std::string>> phrases = {
+        {"old", "red", "barn"}, {"new", "blue", "shed"}, {"the", "farmer"}, {"lazy", "dog"}
+    };
+    auto runQueries = [&]() {
+        std::vector<std::vector<unsigned int>> results;
+        for(auto& words : queries)
+            results.push_back(index.query(words));
+        for(auto& words : phrases)
+            results.push_back(index.phrase_query(words));
+        return results;
+    };
+
+    index.clear();
+    unsigned long long before = index.getPostingsInserted();
+    for(const DocumentInput& input : documents) {
+        std::string url = input.url;
+        index.insert_document(url, input.page);
+    }
+    unsigned long long singlepostings = index.getPostingsInserted() - before;
+    std::vector<std::vector<unsigned int>> single = runQueries();
+
+    index.clear();
+    before = index.getPostingsInserted();
+    std::vector<DocumentInput> batch = documents;
+    index.insert_documents(batch);
+    REQUIRE(index.getPostingsInserted() - before == singlepostings);
+    REQUIRE(runQueries() == single);
+
+    index.clear();
+}
@@ -0,0 +1,186 @@
+#include "libs/catch.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+#include <map>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "index.hpp"
+#include "static_index.hpp"
+#include "static_functions/postingIO.hpp"
+#include "static_functions/bytesIO.hpp"
+#include "query_processing/query_primitive_low.hpp"
+#include "utility/util.hpp"
+
+//Reads every posting list of a non-positional index file
+std::map<unsigned int, std::vector<nPosting>> readNonPosIndex(const std::string& path) {
+    std::map<unsigned int, std::vector<nPosting>> lists;
+    std::ifstream ifile(path);
+    unsigned int termID;
+    readFromBytes(termID, ifile);
+    while(ifile) {
+        lists[termID] = read_nonpos_postinglist(ifile, termID);
+        readFromBytes(termID, ifile);
+    }
+    return lists;
+}
+
+void makeIndexDirs(const std::string& dir) {
+    mkdir(dir.c_str(), S_IRWXU);
+    mkdir(("./" + dir + GlobalConst::IndexPath).c_str(), S_IRWXU);
+    mkdir(("./" + dir + GlobalConst::NonPosPath).c_str(), S_IRWXU);
+    mkdir(("./" + dir + GlobalConst::PosPath).c_str(), S_IRWXU);
+}
+
+void removeIndexDirs(const std::string& dir) {
+    for(const std::string& sub : {GlobalConst::NonPosPath, GlobalConst::PosPath, GlobalConst::IndexPath}) {
+        std::string path = "./" + dir + sub;
+        for(std::string& name : Utility::readDirectory(path))
+            std::remove((path + name).c_str());
+        rmdir(path.c_str());
+    }
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("Test bulk build runs", "[bulk]") {
+    std::string dir = "test_bulk";
+    std::string npdir = "./" + dir + GlobalConst::NonPosPath;
+    std::string pdir = "./" + dir + GlobalConst::PosPath;
+    makeIndexDirs(dir);
+
+    StaticIndex staticindex(dir);
+    //Term 1 is in every run and long enough to get sparse lexicon entries, term 2 only in the second run
+    std::map<unsigned int, std::vector<nPosting>> expected;
+    for(unsigned int run = 0; run < 3; ++run) {
+        std::vector<nPosting> nppostings;
+        std::vector<Posting> ppostings;
+        for(unsigned int doc = run * 200; doc < run * 200 + 200; ++doc) {
+            nppostings.emplace_back(1, doc, doc % 5 + 1);
+            ppostings.emplace_back(1, doc, 0, doc % 5);
+        }
+        if(run == 1) {
+            nppostings.emplace_back(2, 250, 3);
+            ppostings.emplace_back(2, 250, 0, 7);
+        }
+        for(nPosting& p : nppostings)
+            expected[p.termID].push_back(p);
+        staticindex.write_run(nppostings);
+        staticindex.write_run(ppostings);
+    }
+    REQUIRE(staticindex.getRunCount() == 3);
+
+    //601 postings with in-memory indexes of 200 postings would have been merged into a Z2
+    staticindex.merge_runs(200);
+    REQUIRE(staticindex.getRunCount() == 0);
+    REQUIRE(Utility::readDirectory(npdir) == std::vector<std::string>{"Z2"});
+    REQUIRE(Utility::readDirectory(pdir) == std::vector<std::string>{"Z2"});
+    REQUIRE(Utility::readDirectory("./" + dir + GlobalConst::IndexPath).size() == 2);
+
+    std::map<unsigned int, std::vector<nPosting>> merged = readNonPosIndex(npdir + "Z2");
+    REQUIRE(merged.size() == expected.size());
+    for(auto& entry : expected) {
+        std::vector<nPosting>& list = merged[entry.first];
+        REQUIRE(list.size() == entry.second.size());
+        for(size_t i = 0; i < list.size(); ++i) {
+            REQUIRE(list[i].docID == entry.second[i].docID);
+            REQUIRE(list[i].second == entry.second[i].second);
+        }
+    }
+
+    //The merged index is found through the sparse lexicon like any other
+    std::shared_ptr<const StaticFileSet> files = staticindex.openNonPosFiles();
+    REQUIRE(files->size() == 1);
+    QueryStats stats;
+    query_primitive_low qpl(1, files->front(), stats);
+    bool failure = false;
+    REQUIRE(qpl.nextGEQ(399, failure) == 399);
+    REQUIRE(qpl.nextGEQ(600, failure) == GlobalConst::UIntMax);
+
+    //Runs can only be merged into an empty index
+    std::vector<nPosting> extra = {nPosting(3, 700, 1)};
+    staticindex.write_run(extra);
+    REQUIRE_THROWS_AS(staticindex.merge_runs(200), std::runtime_error);
+
+    removeIndexDirs(dir);
+}
+
+TEST_CASE("Test bulk build runs with renumbered docIDs", "[bulk]") {
+    std::string dir = "test_bulk_renumbered";
+    makeIndexDirs(dir);
+
+    //Two documents per run, each with term 1 at positions 0 and 1. Term 2 is only in document 0
+    StaticIndex staticindex(dir);
+    for(unsigned int run = 0; run < 2; ++run) {
+        std::vector<nPosting> nppostings;
+        std::vector<Posting> ppostings;
+        for(unsigned int doc = run * 2; doc < run * 2 + 2; ++doc) {
+            nppostings.emplace_back(1, doc, doc + 10);
+            ppostings.emplace_back(1, doc, 0, 0);
+            ppostings.emplace_back(1, doc, 0, 1);
+        }
+        if(run == 0) {
+            nppostings.emplace_back(2, 0, 1);
+            ppostings.emplace_back(2, 0, 0, 2);
+        }
+        std::stable_sort(nppostings.begin(), nppostings.end(), [](const nPosting& a, const nPosting& b) {
+            return a.termID < b.termID;
+        });
+        std::stable_sort(ppostings.begin(), ppostings.end(), [](const Posting& a, const Posting& b) {
+            return a.termID < b.termID;
+        });
+        staticindex.write_run(nppostings);
+        staticindex.write_run(ppostings);
+    }
+
+    //Reverses the order of the documents
+    staticindex.merge_runs(100, {3, 2, 1, 0});
+
+    std::string npdir = "./" + dir + GlobalConst::NonPosPath;
+    std::map<unsigned int, std::vector<nPosting>> lists = readNonPosIndex(npdir + "Z0");
+    REQUIRE(lists[1].size() == 4);
+    for(unsigned int docID = 0; docID < 4; ++docID) {
+        REQUIRE(lists[1][docID].docID == docID);
+        REQUIRE(lists[1][docID].second == 3 - docID + 10);
+    }
+    REQUIRE(lists[2].size() == 1);
+    REQUIRE(lists[2][0].docID == 3);
+
+    std::ifstream ifile("./" + dir + GlobalConst::PosPath + "Z0");
+    unsigned int termID;
+    readFromBytes(termID, ifile);
+    REQUIRE(termID == 1);
+    std::vector<Posting> positions = read_pos_postinglist(ifile, termID);
+    REQUIRE(positions.size() == 8);
+    for(unsigned int i = 0; i < positions.size(); ++i) {
+        REQUIRE(positions[i].docID == i / 2);
+        REQUIRE(positions[i].third == i % 2);
+    }
+    readFromBytes(termID, ifile);
+    REQUIRE(termID == 2);
+    positions = read_pos_postinglist(ifile, termID);
+    REQUIRE(positions.size() == 1);
+    REQUIRE(positions[0].docID == 3);
+    REQUIRE(positions[0].third == 2);
+    ifile.close();
+
+    removeIndexDirs(dir);
+}
+
+//Needs the redis server of the document store, so it only runs when asked for with [redis]
+TEST_CASE("Test inserts are refused during a bulk build", "[bulk][redis][.]") {
+    std::string dir = "test_bulk_index";
+    Index index(dir);
+    std::vector<DocumentInput> batch = {{"test_bulk_index/a", "the cat sat on the mat"}};
+    index.bulk_insert(batch);
+
+    std::string url = "test_bulk_index/b";
+    std::vector<DocumentInput> more = {{url, "the dog sat on the log"}};
+    REQUIRE_THROWS_AS(index.insert_document(url, more[0].page), std::logic_error);
+    REQUIRE_THROWS_AS(index.insert_documents(more), std::logic_error);
+
+    index.bulk_finish();
+    index.insert_documents(more);
+    removeIndexDirs(dir);
+}
\ No newline at end of file
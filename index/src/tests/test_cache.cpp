@@ -0,0 +1,218 @@
+#include "libs/catch.hpp"
+
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utility/lru_cache.hpp"
+#include "query_processing/block_cache.hpp"
+#include "Structures/translationcache.h"
+#include "query_processing/query_primitive_low.hpp"
+#include "static_functions/postingIO.hpp"
+
+TEST_CASE("Test LRU cache", "[cache]") {
+    Utility::LRUCache<int, std::string> cache(2);
+    REQUIRE(cache.get(1) == nullptr);
+
+    cache.put(1, "a");
+    cache.put(2, "b");
+    REQUIRE(cache.size() == 2);
+    REQUIRE(*cache.get(1) == "a");
+
+    //2 is now the least recently used entry
+    cache.put(3, "c");
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.get(2) == nullptr);
+    REQUIRE(*cache.get(1) == "a");
+    REQUIRE(*cache.get(3) == "c");
+
+    cache.put(1, "d");
+    REQUIRE(*cache.get(1) == "d");
+    REQUIRE(cache.size() == 2);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.get(1) == nullptr);
+}
+
+TEST_CASE("Test LRU cache bounded by weight", "[cache]") {
+    Utility::LRUCache<int, std::string> cache(10, [](const std::string& value) { return value.size(); });
+    cache.put(1, "aaaa");
+    cache.put(2, "bbbb");
+    REQUIRE(cache.getWeight() == 8);
+
+    //1 and 2 are both evicted to make room
+    cache.put(3, "cccccccc");
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.getWeight() == 8);
+    REQUIRE(cache.get(1) == nullptr);
+    REQUIRE(cache.get(2) == nullptr);
+
+    //Replacing a value changes its weight
+    cache.put(3, "cc");
+    cache.put(4, "dddddddd");
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.getWeight() == 10);
+
+    //Too heavy to cache, and drops the old value of the key
+    cache.put(4, "eeeeeeeeeee");
+    REQUIRE(cache.get(4) == nullptr);
+    REQUIRE(cache.getWeight() == 2);
+
+    cache.erase(3);
+    REQUIRE(cache.getWeight() == 0);
+}
+
+TEST_CASE("Test translation cache with concurrent inserts", "[cache]") {
+    //The stored translation list of document 1, as redis holds it
+    std::vector<Translation> stored = {Translation(3, 2, 4), Translation(0, 1, 0)};
+    std::vector<Translation> added = {Translation(6, 0, 3), Translation(2, 5, 1)};
+    TranslationCache cache(1 << 20);
+
+    auto requireStored = [&](const CompiledTranslations& compiled) {
+        REQUIRE(compiled.size() == stored.size());
+        for(size_t fragID = 0; fragID <= stored.size(); ++fragID) {
+            for(int position = 0; position < 20; ++position) {
+                int expected = applyTranslations(position, fragID, stored);
+                if(expected < 0)
+                    REQUIRE(compiled.apply(position, fragID) < 0);
+                else
+                    REQUIRE(compiled.apply(position, fragID) == expected);
+            }
+        }
+    };
+
+    //A query misses and caches the list
+    unsigned long long version;
+    REQUIRE(cache.get(1, version) == nullptr);
+    cache.put(1, std::make_shared<const CompiledTranslations>(stored), version);
+    REQUIRE(cache.get(1, version) != nullptr);
+
+    //An insert extends the cached entry
+    size_t oldlength = stored.size();
+    stored.insert(stored.end(), added.begin(), added.end());
+    cache.append(1, added, oldlength);
+    requireStored(*cache.get(1, version));
+
+    //A query misses after the insert pushed to redis, and caches the new list before the insert reaches the cache.
+    //The insert must not append its translations to that list a second time
+    cache.erase(1);
+    REQUIRE(cache.get(1, version) == nullptr);
+    oldlength = stored.size();
+    stored.insert(stored.end(), added.begin(), added.end());
+    cache.put(1, std::make_shared<const CompiledTranslations>(stored), version);
+    cache.append(1, added, oldlength);
+    REQUIRE(cache.get(1, version) == nullptr);
+
+    //A query reads the list before an insert pushes to redis, and caches it after the insert reached the cache
+    cache.erase(1);
+    REQUIRE(cache.get(1, version) == nullptr);
+    auto old = std::make_shared<const CompiledTranslations>(stored);
+    oldlength = stored.size();
+    stored.insert(stored.end(), added.begin(), added.end());
+    cache.append(1, added, oldlength);
+    cache.put(1, old, version);
+    REQUIRE(cache.get(1, version) == nullptr);
+}
+
+TEST_CASE("Test block cache eviction", "[cache]") {
+    //Room for a few blocks per shard
+    BlockCache cache(BlockCache::SHARD_COUNT * 4096);
+    REQUIRE(cache.get(BlockKey{0, 0}) == nullptr);
+
+    DecodedBlock block = std::make_shared<const std::vector<unsigned int>>(BLOCKSIZE, 1);
+    for(unsigned long offset = 0; offset < 10000; ++offset)
+        cache.put(BlockKey{0, offset}, block);
+    REQUIRE(cache.getBytes() <= cache.getCapacity());
+    REQUIRE(cache.getBytes() > 0);
+
+    //Entries are keyed by file generation as well as offset
+    cache.clear();
+    cache.put(BlockKey{1, 64}, block);
+    REQUIRE(cache.get(BlockKey{1, 64}) == block);
+    REQUIRE(cache.get(BlockKey{2, 64}) == nullptr);
+
+    //Blocks larger than a shard are never cached
+    DecodedBlock large = std::make_shared<const std::vector<unsigned int>>(4096, 1);
+    cache.put(BlockKey{1, 128}, large);
+    REQUIRE(cache.get(BlockKey{1, 128}) == nullptr);
+
+    cache.clear();
+    REQUIRE(cache.getBytes() == 0);
+}
+
+TEST_CASE("Test block cache from several threads", "[cache]") {
+    BlockCache cache(BlockCache::SHARD_COUNT * 8192);
+
+    //Each block holds its own offset, so a block returned for the wrong key is detected
+    auto worker = [&cache](unsigned long seed, bool& ok) {
+        for(unsigned long i = 0; i < 20000; ++i) {
+            unsigned long offset = (i * 7919 + seed) % 512;
+            DecodedBlock block = cache.get(BlockKey{3, offset});
+            if(block == nullptr)
+                cache.put(BlockKey{3, offset}, std::make_shared<const std::vector<unsigned int>>(16, offset));
+            else if((*block)[0] != offset)
+                ok = false;
+        }
+    };
+
+    bool ok[4] = {true, true, true, true};
+    std::vector<std::thread> threads;
+    for(unsigned long t = 0; t < 4; ++t)
+        threads.emplace_back(worker, t, std::ref(ok[t]));
+    for(std::thread& t : threads)
+        t.join();
+
+    for(bool b : ok)
+        REQUIRE(b);
+    REQUIRE(cache.getBytes() <= cache.getCapacity());
+}
+
+TEST_CASE("Test block cache in query_primitive_low", "[cache]") {
+    //Static index files are named after their order
+    const std::string dir = "./test_block_cache";
+    const std::string path = dir + "/Z0";
+    mkdir(dir.c_str(), S_IRWXU);
+    std::vector<nPosting> postinglist;
+    for(unsigned int i = 0; i < BLOCKSIZE * 3; ++i)
+        postinglist.emplace_back(5, i * 3, i % 7 + 1);
+    {
+        std::ofstream ofile(path, std::ios::out | std::ios::trunc);
+        write_postinglist(ofile, 5, postinglist, false);
+    }
+
+    BlockCache cache(1 << 20);
+    auto file = std::make_shared<const StaticFileHandle>(path, 1, std::map<unsigned int, unsigned long>());
+    QueryStats coldstats, warmstats;
+    query_primitive_low cold(5, file, coldstats, &cache);
+    query_primitive_low warm(5, file, warmstats, &cache);
+
+    bool failure = false;
+    for(nPosting& p : postinglist) {
+        REQUIRE(cold.nextGEQ(p.docID, failure) == p.docID);
+        REQUIRE(cold.getFreq() == p.second);
+    }
+    for(nPosting& p : postinglist) {
+        REQUIRE(warm.nextGEQ(p.docID, failure) == p.docID);
+        REQUIRE(warm.getFreq() == p.second);
+    }
+    REQUIRE(warm.nextGEQ(postinglist.back().docID + 1, failure) == GlobalConst::UIntMax);
+    REQUIRE(failure);
+
+    //Three docID and three frequency blocks
+    REQUIRE(coldstats.blocksdecoded == 6);
+    REQUIRE(warmstats.blocksdecoded == 0);
+    REQUIRE(warmstats.blockcachehits == 6);
+
+    //A different file generation must not see the cached blocks
+    QueryStats newstats;
+    auto newfile = std::make_shared<const StaticFileHandle>(path, 2, std::map<unsigned int, unsigned long>());
+    query_primitive_low newqpl(5, newfile, newstats, &cache);
+    REQUIRE(newstats.blocksdecoded == 1);
+    REQUIRE(newstats.blockcachehits == 0);
+
+    std::remove(path.c_str());
+    rmdir(dir.c_str());
+}
\ No newline at end of file
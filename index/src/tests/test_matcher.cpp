@@ -1,8 +1,14 @@
 #include "libs/catch.hpp"
 
 #include <iostream>
+#include <random>
 
 #include "doc_analyzer/Matcher/matcher.h"
+#include "doc_analyzer/Matcher/blockmatching.hpp"
+#include "doc_analyzer/Matcher/distancetable.h"
+#include "doc_analyzer/Matcher/translate.h"
+#include "doc_analyzer/analyzer.h"
+#include "global_parameters.hpp"
 
 TEST_CASE("Test getPostings", "[matcher]") {
     std::string a = "a b c d e f g h i j k l";
@@ -14,7 +20,226 @@ TEST_CASE("Test getPostings", "[matcher]") {
     unsigned int fragID = 0;
     auto results = getPostings(r1, 0, fragID, se);
 
-    REQUIRE(results.first.size() == 8);
-    REQUIRE(results.second.size() == 5);
+    REQUIRE(results.nonPositionalSize() == 8);
+    REQUIRE(results.positionalSize() == 5);
     REQUIRE(fragID == 2);
+}
+
+TEST_CASE("Test posting batch", "[matcher]") {
+    PostingBatch batch(7);
+    std::vector<unsigned int> terms = {3, 0, 3, 1, 0, 3};
+    for(unsigned int i = 0; i < terms.size(); ++i)
+        batch.addPositional(terms[i], 1, i);
+    batch.addNonPositional(2, 4);
+    REQUIRE(batch.positionalSize() == 6);
+    REQUIRE(batch.nonPositionalSize() == 1);
+
+    //Grouped by term, in order of position within a term
+    std::vector<unsigned int> runstarts;
+    std::vector<unsigned int> order = batch.groupPositional(5, runstarts);
+    REQUIRE(order == (std::vector<unsigned int>{1, 4, 3, 0, 2, 5}));
+    REQUIRE(runstarts == (std::vector<unsigned int>{0, 2, 3, 3, 6, 6}));
+
+    PostingBatch moved = std::move(batch);
+    REQUIRE(moved.docID == 7);
+    REQUIRE(moved.positions.size() == 6);
+}
+
+//Total common text of a path, which must be a chain of blocks moving forward in both versions
+int pathLength(const std::vector<Block>& path) {
+    int length = 0;
+    for(size_t i = 0; i < path.size(); ++i) {
+        if(i > 0) {
+            REQUIRE(path[i].oldloc > path[i-1].oldendloc());
+            REQUIRE(path[i].newloc > path[i-1].newendloc());
+        }
+        length += path[i].len;
+    }
+    return length;
+}
+
+TEST_CASE("Test distance table", "[matcher]") {
+    //The sweep must find paths as good as relaxing every edge of the block graph
+    std::mt19937 gen(11);
+    std::uniform_int_distribution<int> word(0, 7);
+    std::uniform_int_distribution<int> edit(0, 6);
+    for(int round = 0; round < 10; ++round) {
+        std::string a, b;
+        for(int i = 0; i < 400; ++i) {
+            std::string token = "w" + std::to_string(word(gen)) + " ";
+            a += token;
+            if(edit(gen) == 0)
+                b += "x" + std::to_string(word(gen)) + " ";
+            else if(edit(gen) != 0)
+                b += token;
+        }
+        StringEncoder se(a, b);
+        std::vector<Block> blocks = getMaximalBlocks(2, se);
+        resolveIntersections(blocks);
+
+        for(int blocklimit : {1, 3, 100}) {
+            for(int cost : {0, 2, 5}) {
+                DistanceTable sweep(blocklimit, blocks);
+                std::vector<Block> graphblocks = blocks;
+                BlockGraph graph(graphblocks);
+                DistanceTable relaxed(blocklimit, graph, topologicalSort(graph));
+
+                std::vector<Block> sweeppath = sweep.findOptimalPath(cost);
+                std::vector<Block> relaxedpath = relaxed.findOptimalPath(cost);
+                REQUIRE(sweeppath.size() <= (size_t)blocklimit);
+                REQUIRE(sweeppath.size() == relaxedpath.size());
+                REQUIRE(pathLength(sweeppath) == pathLength(relaxedpath));
+            }
+        }
+    }
+
+    DistanceTable empty(MAX_BLOCK_COUNT, std::vector<Block>());
+    REQUIRE(empty.findOptimalPath(0).empty());
+}
+TEST_CASE("Test trimmed matching", "[matcher]") {
+    //A long document with a few edited terms in the middle
+    std::string a, b;
+    for(int i = 0; i < 1000; ++i) {
+        std::string token = "w" + std::to_string(i) + " ";
+        a += token;
+        if(i == 400)
+            b += "x y z ";
+        else if(i < 500 || i > 503)
+            b += token;
+    }
+    StringEncoder se(a, b);
+
+    //Trimming finds the same blocks as matching the whole document
+    std::vector<Block> full = getOptimalBlocks(se, MIN_BLOCK_SIZE, MAX_BLOCK_COUNT, 0);
+    std::vector<Block> trimmed = getTrimmedBlocks(se, MIN_BLOCK_SIZE, MAX_BLOCK_COUNT, 0);
+    std::sort(full.begin(), full.end(), compareOld);
+    std::sort(trimmed.begin(), trimmed.end(), compareOld);
+    REQUIRE(trimmed == full);
+    REQUIRE(trimmed.size() == 3);
+
+    unsigned int fullfragID = 1;
+    unsigned int trimmedfragID = 1;
+    auto fullpostings = getPostings(full, 0, fullfragID, se);
+    auto trimmedpostings = getPostings(trimmed, 0, trimmedfragID, se);
+    REQUIRE(trimmedfragID == fullfragID);
+    REQUIRE(trimmedpostings.npterms == fullpostings.npterms);
+    REQUIRE(trimmedpostings.positions == fullpostings.positions);
+
+    //The prefix and suffix are too short to be blocks
+    StringEncoder shortse("a b c d e", "a b x d e");
+    REQUIRE(getTrimmedBlocks(shortse, 2, MAX_BLOCK_COUNT, 0) == getOptimalBlocks(shortse, 2, MAX_BLOCK_COUNT, 0));
+    REQUIRE(getTrimmedBlocks(shortse, 3, MAX_BLOCK_COUNT, 0).empty());
+
+    //An unchanged document is one common block, encoded the same as two identical versions
+    StringEncoder unchanged(StringEncoder("", a).getNewVersion(0));
+    StringEncoder twice(a, a);
+    REQUIRE(std::equal(unchanged.getOldIter(), unchanged.getOldEnd(), twice.getOldIter(), twice.getOldEnd()));
+    REQUIRE(std::equal(unchanged.getNewIter(), unchanged.getNewEnd(), twice.getNewIter(), twice.getNewEnd()));
+    int code = unchanged.getCode("w5");
+    REQUIRE(unchanged.getNewCount(code) == 1);
+    REQUIRE(!unchanged.inOld(code));
+    REQUIRE(!unchanged.inNew(code));
+    REQUIRE(getTrimmedBlocks(unchanged, MIN_BLOCK_SIZE, MAX_BLOCK_COUNT, 0) == std::vector<Block>{Block(0, 0, 1000)});
+}
+
+//Both paths must give the same blocks, translations and postings, including when the common prefix or suffix
+//also matches elsewhere in the other version
+TEST_CASE("Test trimmed matching on random revisions", "[matcher]") {
+    std::mt19937 rng(17);
+    //Every other round uses a small vocabulary, so text repeats often. The large one lets the prefix and suffix be trimmed
+    size_t vocabularysize;
+    auto randomWord = [&]() {
+        return "w" + std::to_string(rng() % vocabularysize);
+    };
+    auto randomText = [&](int length) {
+        std::vector<std::string> words;
+        for(int i = 0; i < length; ++i)
+            words.push_back(randomWord());
+        return words;
+    };
+    auto join = [](const std::vector<std::string>& words) {
+        std::string text;
+        for(const std::string& word : words)
+            text += word + " ";
+        return text;
+    };
+
+    int minsize = 3;
+    for(int round = 0; round < 4000; ++round) {
+        vocabularysize = round % 2 ? 6 : 200;
+        std::vector<std::string> oldwords = randomText(10 + rng() % 60);
+        std::vector<std::string> newwords = oldwords;
+        int edits = 1 + rng() % 3;
+        for(int edit = 0; edit < edits; ++edit) {
+            size_t at = rng() % (newwords.size() + 1);
+            switch(rng() % 4) {
+            //Insert random text
+            case 0: {
+                std::vector<std::string> inserted = randomText(1 + rng() % 5);
+                newwords.insert(newwords.begin() + at, inserted.begin(), inserted.end());
+                break;
+            }
+            //Delete text
+            case 1:
+                newwords.erase(newwords.begin() + at, newwords.begin() + std::min(newwords.size(), at + 1 + rng() % 5));
+                break;
+            //Copy a piece of the start or end of the document, which repeats the prefix or suffix
+            case 2: {
+                size_t length = std::min<size_t>(newwords.size(), 1 + rng() % 8);
+                size_t from = rng() % 2 ? 0 : newwords.size() - length;
+                std::vector<std::string> copied(newwords.begin() + from, newwords.begin() + from + length);
+                newwords.insert(newwords.begin() + at, copied.begin(), copied.end());
+                break;
+            }
+            //Replace one word
+            default:
+                if(at < newwords.size())
+                    newwords[at] = randomWord();
+            }
+        }
+
+        StringEncoder se(join(oldwords), join(newwords));
+        std::vector<Block> full = getOptimalBlocks(se, minsize, MAX_BLOCK_COUNT, 0);
+        std::vector<Block> trimmed = getTrimmedBlocks(se, minsize, MAX_BLOCK_COUNT, 0);
+        INFO("old: " << join(oldwords));
+        INFO("new: " << join(newwords));
+
+        std::vector<Translation> fulltranslations = getTranslations(se.getOldSize(), se.getNewSize(), full);
+        std::vector<Translation> trimmedtranslations = getTranslations(se.getOldSize(), se.getNewSize(), trimmed);
+        REQUIRE(trimmedtranslations.size() == fulltranslations.size());
+        for(size_t i = 0; i < fulltranslations.size(); ++i) {
+            REQUIRE(trimmedtranslations[i].loc == fulltranslations[i].loc);
+            REQUIRE(trimmedtranslations[i].oldlen == fulltranslations[i].oldlen);
+            REQUIRE(trimmedtranslations[i].newlen == fulltranslations[i].newlen);
+        }
+
+        unsigned int fullfragID = 1;
+        unsigned int trimmedfragID = 1;
+        PostingBatch fullpostings = getPostings(full, 0, fullfragID, se);
+        PostingBatch trimmedpostings = getPostings(trimmed, 0, trimmedfragID, se);
+        REQUIRE(trimmedfragID == fullfragID);
+        REQUIRE(trimmedpostings.npterms == fullpostings.npterms);
+        REQUIRE(trimmedpostings.freqs == fullpostings.freqs);
+        REQUIRE(trimmedpostings.pterms == fullpostings.pterms);
+        REQUIRE(trimmedpostings.fragIDs == fullpostings.fragIDs);
+        REQUIRE(trimmedpostings.positions == fullpostings.positions);
+    }
+}
+
+
+TEST_CASE("Test unchanged pages", "[matcher]") {
+    std::string page = "The cat sat on the mat";
+    DocumentTuple olddoc(0, StringEncoder("", page).getNewVersion(Utility::hashString(page)), 1, "1");
+
+    //Only the case of a term differs, so the page is unchanged
+    MatcherInfo same = makePosts(olddoc, "the cat SAT on the mat", olddoc.doc.hash);
+    REQUIRE(same.translations.empty());
+    REQUIRE(same.postings.npterms.empty());
+    REQUIRE(same.maxfragID == 1);
+
+    //A page whose hash collides with the stored version is still matched
+    for(std::string changed : {"the cat sat on the hat", "the cat sat on the mat again", "the cat sat on the"}) {
+        MatcherInfo info = makePosts(olddoc, changed, olddoc.doc.hash);
+        REQUIRE(!info.postings.npterms.empty());
+    }
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include "libs/catch.hpp"
+
+#include "utility/metrics.hpp"
+
+TEST_CASE("Test metrics histogram", "[metrics]") {
+    Metrics::Histogram h;
+    REQUIRE(h.count() == 0);
+    REQUIRE(h.percentile(50) == 0);
+
+    for(unsigned long long i = 1; i <= 1000; ++i)
+        h.record(i);
+
+    REQUIRE(h.count() == 1000);
+    REQUIRE(h.sum() == 500500);
+    REQUIRE(h.max() == 1000);
+
+    //Percentiles are upper bounds within the bucket precision
+    unsigned long long p50 = h.percentile(50);
+    REQUIRE(p50 >= 500);
+    REQUIRE(p50 <= 500 + 500 / Metrics::Histogram::SUB_BUCKETS);
+    unsigned long long p99 = h.percentile(99);
+    REQUIRE(p99 >= 990);
+    REQUIRE(p99 <= 1000);
+    REQUIRE(h.percentile(100) == 1000);
+
+    //Small values are recorded exactly
+    Metrics::Histogram exact;
+    exact.record(3);
+    exact.record(7);
+    REQUIRE(exact.percentile(50) == 3);
+    REQUIRE(exact.percentile(100) == 7);
+
+    h.reset();
+    REQUIRE(h.count() == 0);
+    REQUIRE(h.max() == 0);
+}
+
+TEST_CASE("Test metrics registry", "[metrics]") {
+    Metrics::Counter& c = Metrics::counter("test.counter");
+    c.add(5);
+    REQUIRE(&Metrics::counter("test.counter") == &c);
+    REQUIRE(Metrics::counter("test.counter").get() == 5);
+
+    Metrics::gauge("test.gauge").set(-3);
+    Metrics::histogram("test.histogram").record(42);
+
+    nlohmann::json jobject = Metrics::toJson();
+    REQUIRE(jobject["counters"]["test.counter"] == 5);
+    REQUIRE(jobject["gauges"]["test.gauge"] == -3);
+    REQUIRE(jobject["histograms"]["test.histogram"]["count"] == 1);
+    REQUIRE(jobject["histograms"]["test.histogram"]["max"] == 42);
+
+    Metrics::reset();
+    REQUIRE(c.get() == 0);
+}
\ No newline at end of file
@@ -0,0 +1,222 @@
+#include "libs/catch.hpp"
+
+#include <fstream>
+#include <cstdio>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "query_processing/pos_query_primitive_low.hpp"
+#include "query_processing/positional_DAAT.hpp"
+#include "static_functions/postingIO.hpp"
+
+//In-memory positional list of a term, sorted by docID. Each posting is (docID, position) in fragment 0
+std::shared_ptr<const std::vector<Posting>> makePositionalList(unsigned int termID,
+    std::vector<std::pair<unsigned int, unsigned int>> postings)
+{
+    auto list = std::make_shared<std::vector<Posting>>();
+    for(auto& posting : postings)
+        list->emplace_back(termID, posting.first, 0, posting.second);
+    return list;
+}
+
+//Snapshot of the in-memory lists, with no static files
+IndexSnapshot makePositionalSnapshot(std::vector<std::shared_ptr<const std::vector<Posting>>> lists) {
+    IndexSnapshot snapshot;
+    for(size_t i = 0; i < lists.size(); ++i) {
+        SnapshotTerm term;
+        term.termID = lists[i]->front().termID;
+        term.f_t = 0;
+        term.memlength = term.sidelength = 0;
+        term.poslist = lists[i];
+        snapshot.terms.push_back(term);
+    }
+    snapshot.posfiles = std::make_shared<const StaticFileSet>();
+    snapshot.blockcache = nullptr;
+    snapshot.generation = 0;
+    return snapshot;
+}
+
+TEST_CASE("Test phrase and proximity counting", "[positional]") {
+    //a b c a b
+    std::vector<std::vector<int>> positions = {{0, 3}, {1, 4}};
+    REQUIRE(countPhrase(positions) == 2);
+    REQUIRE(countProximity(positions, 2) == 2);
+    REQUIRE(countProximity(positions, 1) == 0);
+
+    //b a
+    positions = {{1}, {0}};
+    REQUIRE(countPhrase(positions) == 0);
+    REQUIRE(countProximity(positions, 2) == 1);
+
+    //A repeated word must appear at distinct positions
+    positions = {{2, 3}, {2, 3}};
+    REQUIRE(countPhrase(positions) == 1);
+}
+
+TEST_CASE("Test compiled translations", "[positional]") {
+    //Each version replaces, inserts or deletes a block of the previous one
+    std::vector<Translation> translations = {
+        Translation(3, 2, 4), Translation(0, 1, 0), Translation(6, 0, 3), Translation(2, 5, 1), Translation(10, 3, 3)
+    };
+
+    CompiledTranslations compiled;
+    for(size_t count = 0; count <= translations.size(); ++count) {
+        std::vector<Translation> prefix(translations.begin(), translations.begin() + count);
+        REQUIRE(compiled.size() == count);
+        for(size_t fragID = 0; fragID <= count; ++fragID) {
+            for(int position = 0; position < 30; ++position) {
+                int expected = applyTranslations(position, fragID, prefix);
+                if(expected < 0)
+                    REQUIRE(compiled.apply(position, fragID) < 0);
+                else
+                    REQUIRE(compiled.apply(position, fragID) == expected);
+            }
+        }
+        if(count < translations.size())
+            compiled.append(translations[count]);
+    }
+    REQUIRE(CompiledTranslations(translations).apply(20, 0) == compiled.apply(20, 0));
+
+    //A batch in any order, including fragments newer than every translation
+    std::vector<FragmentPosition> batch;
+    for(unsigned int position = 30; position-- > 0;) {
+        for(unsigned int fragID = 0; fragID <= translations.size() + 1; ++fragID)
+            batch.emplace_back(fragID, (position * 7 + fragID) % 30);
+    }
+    for(int sorted = 0; sorted < 2; ++sorted) {
+        //Batches in posting list order take a separate path
+        if(sorted)
+            std::sort(batch.begin(), batch.end());
+        std::vector<int> mapped = compiled.applyBatch(batch);
+        REQUIRE(mapped.size() == batch.size());
+        for(size_t i = 0; i < batch.size(); ++i) {
+            int expected = compiled.apply(batch[i].second, batch[i].first);
+            if(expected < 0)
+                REQUIRE(mapped[i] < 0);
+            else
+                REQUIRE(mapped[i] == expected);
+        }
+    }
+}
+
+TEST_CASE("Test compiled translations past the compile limit", "[positional]") {
+    //Each edit inserts a word early in the document, so each one shifts the positions of every older fragment
+    std::vector<Translation> translations;
+    for(int i = 0; i < TRANSLATION_COMPILE_LIMIT + 20; ++i)
+        translations.emplace_back(i % 7 * 3, i % 3, 1);
+
+    CompiledTranslations compiled;
+    size_t compiledbytes = 0;
+    for(size_t count = 1; count <= translations.size(); ++count) {
+        compiled.append(translations[count - 1]);
+        if(count == TRANSLATION_COMPILE_LIMIT)
+            compiledbytes = compiled.bytes();
+        if(count % 37 != 0 && count != TRANSLATION_COMPILE_LIMIT + 1 && count != translations.size())
+            continue;
+
+        std::vector<Translation> prefix(translations.begin(), translations.begin() + count);
+        std::vector<FragmentPosition> batch;
+        for(unsigned int fragID = 0; fragID <= count; fragID += 5) {
+            for(unsigned int position = 0; position < 40; ++position)
+                batch.emplace_back(fragID, position);
+        }
+        std::vector<int> mapped = compiled.applyBatch(batch);
+        for(size_t i = 0; i < batch.size(); ++i) {
+            int expected = applyTranslations(batch[i].second, batch[i].first, prefix);
+            if(expected < 0) {
+                REQUIRE(compiled.apply(batch[i].second, batch[i].first) < 0);
+                REQUIRE(mapped[i] < 0);
+            }
+            else {
+                REQUIRE(compiled.apply(batch[i].second, batch[i].first) == expected);
+                REQUIRE(mapped[i] == expected);
+            }
+        }
+    }
+
+    //Past the limit only the translations themselves are kept
+    REQUIRE(compiled.size() == translations.size());
+    REQUIRE(compiled.bytes() < compiledbytes);
+    REQUIRE(compiled.bytes() < sizeof(CompiledTranslations) + 2 * translations.size() * sizeof(Translation));
+}
+
+TEST_CASE("Test positional queries", "[positional]") {
+    //Document 1 is "a b c a b", document 2 is "b a", document 3 is "a c"
+    auto a = makePositionalList(1, {{1, 0}, {1, 3}, {2, 1}, {3, 0}});
+    auto b = makePositionalList(2, {{1, 1}, {1, 4}, {2, 0}});
+    IndexSnapshot snapshot = makePositionalSnapshot({a, b});
+
+    TranslationLookup unchanged = [](unsigned int) { return std::make_shared<const CompiledTranslations>(); };
+
+    QueryStats stats;
+    std::vector<unsigned int> docs = positionalDAAT(snapshot, PositionalOperator::PHRASE, 0, unchanged, stats);
+    REQUIRE(docs == std::vector<unsigned int>{1});
+    //Document 3 does not contain b, so only the intersection is matched
+    REQUIRE(stats.translationlookups == 2);
+    REQUIRE(stats.positionsread == 6);
+
+    //Ranked from the fewest to the most matches
+    docs = positionalDAAT(snapshot, PositionalOperator::PROXIMITY, 2, unchanged, stats);
+    REQUIRE(docs == (std::vector<unsigned int>{2, 1}));
+
+    //Deleting the first word of document 1 leaves "b c a b"
+    TranslationLookup edited = [](unsigned int docID) {
+        auto translations = std::make_shared<CompiledTranslations>();
+        if(docID == 1)
+            translations->append(Translation(0, 1, 0));
+        return std::shared_ptr<const CompiledTranslations>(translations);
+    };
+    REQUIRE(positionalDAAT(snapshot, PositionalOperator::PHRASE, 0, edited, stats) == std::vector<unsigned int>{1});
+    REQUIRE(positionalDAAT(makePositionalSnapshot({b, a}), PositionalOperator::PHRASE, 0, edited, stats) ==
+        std::vector<unsigned int>{2});
+}
+
+TEST_CASE("Test static positional list", "[positional]") {
+    const std::string dir = "./test_positional";
+    const std::string path = dir + "/Z0";
+    mkdir(dir.c_str(), S_IRWXU);
+
+    //Seven postings per document, so documents cross block boundaries
+    std::vector<Posting> postinglist;
+    for(unsigned int i = 0; i < BLOCKSIZE * 3; ++i)
+        postinglist.emplace_back(5, i / 7, i % 3, i % 7 * 2);
+    {
+        std::ofstream ofile(path, std::ios::out | std::ios::trunc);
+        write_postinglist(ofile, 5, postinglist, true);
+    }
+
+    std::map<unsigned int, unsigned long> sparselex = {{5, 0}};
+    auto file = std::make_shared<const StaticFileHandle>(path, 1, sparselex);
+
+    QueryStats stats;
+    pos_query_primitive_low qpl(5, file, stats);
+    //Only the first docID block is decoded up front
+    REQUIRE(stats.blocksdecoded == 1);
+
+    bool failure = false;
+    unsigned int straddling = BLOCKSIZE / 7;
+    REQUIRE(qpl.nextGEQ(straddling, failure) == straddling);
+    REQUIRE(stats.blocksdecoded == 1);
+
+    std::vector<FragmentPosition> positions;
+    qpl.getPositions(positions);
+    REQUIRE(positions.size() == 7);
+    for(unsigned int i = 0; i < 7; ++i) {
+        unsigned int index = straddling * 7 + i;
+        REQUIRE(positions[i].first == index % 3);
+        REQUIRE(positions[i].second == i * 2);
+    }
+    //Both fragment and position blocks of both groups
+    REQUIRE(stats.blocksdecoded == 6);
+
+    //Skipping documents never decodes their positions
+    REQUIRE(qpl.nextGEQ(straddling + 30, failure) == straddling + 30);
+    REQUIRE(stats.blocksdecoded == 7);
+    REQUIRE(qpl.nextGEQ(BLOCKSIZE * 3, failure) == GlobalConst::UIntMax);
+    REQUIRE(failure);
+    REQUIRE_THROWS_AS(pos_query_primitive_low(6, file, stats), std::invalid_argument);
+
+    std::remove(path.c_str());
+    rmdir(dir.c_str());
+}
\ No newline at end of file
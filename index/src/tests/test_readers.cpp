@@ -0,0 +1,177 @@
+#include "libs/catch.hpp"
+
+#include <fstream>
+#include <cstdio>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "document_readers/WETreader.hpp"
+#include "document_readers/RAWreader.hpp"
+
+//A WET record with the header fields of Common Crawl conversion records
+std::string makeWETRecord(const std::string& type, const std::string& url, const std::string& body) {
+    std::string record = "WARC/1.0\r\nWARC-Type: " + type + "\r\n";
+    if(!url.empty())
+        record += "WARC-Target-URI: " + url + "\r\n";
+    record += "WARC-Date: 2017-05-22T12:00:00Z\r\nContent-Type: text/plain\r\n";
+    record += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    return record + body + "\r\n\r\n";
+}
+
+//Compresses data as a single gzip member. Common Crawl files concatenate one member per record
+std::string gzipMember(const std::string& data) {
+    z_stream stream{};
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string compressed(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = (Bytef*)data.data();
+    stream.avail_in = data.size();
+    stream.next_out = (Bytef*)&compressed[0];
+    stream.avail_out = compressed.size();
+    deflate(&stream, Z_FINISH);
+    compressed.resize(stream.total_out);
+    deflateEnd(&stream);
+    return compressed;
+}
+
+TEST_CASE("Test WET reader", "[readers]") {
+    const std::string dir = "test_readers";
+    mkdir(dir.c_str(), S_IRWXU);
+
+    //Every file starts with a warcinfo record, which has no target URI
+    std::vector<std::vector<std::pair<std::string, std::string>>> files = {
+        {{"http://a.com/", "first\ndocument"}, {"http://b.com/", "WARC/1.0 inside\r\n\r\na body"}},
+        {{"http://c.com/", ""}},
+        {{"http://d.com/", "last document"}},
+    };
+    for(size_t i = 0; i < files.size(); ++i) {
+        std::ofstream ofile(dir + "/" + std::to_string(i) + ".warc.wet", std::ios::out | std::ios::trunc | std::ios::binary);
+        ofile << makeWETRecord("warcinfo", "", "software: test\r\n");
+        for(auto& document : files[i])
+            ofile << makeWETRecord("conversion", document.first, document.second);
+    }
+
+    WETReader reader(dir);
+    for(auto& file : files) {
+        for(auto& document : file) {
+            REQUIRE(reader.isValid());
+            REQUIRE(reader.getURL() == document.first);
+            REQUIRE(reader.getCurrentDocument() == document.second);
+            reader.nextDocument();
+        }
+    }
+    REQUIRE(!reader.isValid());
+    REQUIRE(!reader.nextDocument());
+
+    //Shards split the files, not the documents
+    WETReader shard(dir, 1, 2);
+    REQUIRE(shard.getURL() == "http://c.com/");
+    REQUIRE(shard.getCurrentDocument().empty());
+    REQUIRE(!shard.nextDocument());
+    REQUIRE(!WETReader(dir, 3, 4).isValid());
+    REQUIRE_THROWS_AS(WETReader(dir, 2, 2), std::invalid_argument);
+
+    for(size_t i = 0; i < files.size(); ++i)
+        std::remove((dir + "/" + std::to_string(i) + ".warc.wet").c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("Test compressed WET reader", "[readers]") {
+    const std::string dir = "test_readers_gz";
+    mkdir(dir.c_str(), S_IRWXU);
+
+    //Larger than a decompressed chunk, so records are split between chunks
+    std::string large;
+    for(int i = 0; large.size() < GZIP_CHUNK_SIZE * 3 / 2; ++i)
+        large += "word" + std::to_string(i) + (i % 10 ? " " : "\n");
+    std::vector<std::pair<std::string, std::string>> documents = {
+        {"http://a.com/", "small"}, {"http://b.com/", large}, {"http://c.com/", large.substr(5000)}, {"http://d.com/", "x"}
+    };
+
+    std::string text = makeWETRecord("warcinfo", "", "software: test\r\n");
+    std::string compressed = gzipMember(text);
+    for(auto& document : documents) {
+        std::string record = makeWETRecord("conversion", document.first, document.second);
+        text += record;
+        compressed += gzipMember(record);
+    }
+    {
+        std::ofstream ofile(dir + "/0.warc.wet.gz", std::ios::out | std::ios::trunc | std::ios::binary);
+        ofile << compressed;
+        //Compressed and plain files can be mixed
+        std::ofstream plain(dir + "/1.warc.wet", std::ios::out | std::ios::trunc | std::ios::binary);
+        plain << makeWETRecord("conversion", "http://e.com/", "plain");
+    }
+    documents.emplace_back("http://e.com/", "plain");
+
+    WETReader reader(dir);
+    for(auto& document : documents) {
+        REQUIRE(reader.isValid());
+        REQUIRE(reader.getURL() == document.first);
+        REQUIRE(reader.getCurrentDocument() == document.second);
+        reader.nextDocument();
+    }
+    REQUIRE(!reader.isValid());
+
+    //Members are decompressed as one stream
+    Utility::GzipReader gzip(dir + "/0.warc.wet.gz", 100, 2);
+    std::string buffer;
+    while(gzip.read(buffer)) {}
+    REQUIRE(buffer == text);
+
+    //A file cut off partway through a member is an error, once the data before it has been read
+    {
+        std::ofstream ofile(dir + "/0.warc.wet.gz", std::ios::out | std::ios::trunc | std::ios::binary);
+        ofile << compressed.substr(0, compressed.size() - 10);
+    }
+    Utility::GzipReader truncated(dir + "/0.warc.wet.gz");
+    buffer.clear();
+    auto readAll = [&]() { while(truncated.read(buffer)) {} };
+    REQUIRE_THROWS_AS(readAll(), std::runtime_error);
+
+    std::remove((dir + "/0.warc.wet.gz").c_str());
+    std::remove((dir + "/1.warc.wet").c_str());
+    rmdir(dir.c_str());
+}
+
+TEST_CASE("Test RAW reader", "[readers]") {
+    const std::string dir = "test_readers_raw";
+    const std::string magic = "df6fa1abb58549287111ba8d776733e9";
+    mkdir(dir.c_str(), S_IRWXU);
+
+    std::vector<std::pair<std::string, std::string>> documents = {
+        {"http://a.com/", "first\ndocument\n"}, {"http://b.com/", "mentions " + magic + " inline\n"}, {"http://c.com/", ""},
+        {"http://d.com/", "other file\n"}
+    };
+    {
+        //Only headers after the first one of a file start with the magic number
+        std::ofstream ofile(dir + "/0", std::ios::out | std::ios::trunc | std::ios::binary);
+        ofile << "WARC 0 " << documents[0].first << "\n" << documents[0].second;
+        for(size_t i = 1; i < 3; ++i)
+            ofile << magic << " 0 " << documents[i].first << "\n" << documents[i].second;
+        std::ofstream other(dir + "/1", std::ios::out | std::ios::trunc | std::ios::binary);
+        other << magic << " 0 " << documents[3].first << "\n" << documents[3].second;
+    }
+
+    RAWReader reader(dir);
+    for(auto& document : documents) {
+        REQUIRE(reader.isValid());
+        REQUIRE(reader.getURL() == document.first);
+        REQUIRE(reader.getCurrentDocument() == document.second);
+        reader.nextDocument();
+    }
+    REQUIRE(!reader.isValid());
+
+    //A range of the offsets reads just those documents
+    std::vector<RawDocumentOffset> offsets = RAWReader::indexCollection(dir);
+    REQUIRE(offsets.size() == documents.size());
+    RAWReader split(dir, std::vector<RawDocumentOffset>(offsets.begin() + 2, offsets.end()));
+    REQUIRE(split.getURL() == "http://c.com/");
+    REQUIRE(split.nextDocument());
+    REQUIRE(split.getURL() == "http://d.com/");
+    REQUIRE(!split.nextDocument());
+
+    std::remove((dir + "/0").c_str());
+    std::remove((dir + "/1").c_str());
+    rmdir(dir.c_str());
+}
\ No newline at end of file
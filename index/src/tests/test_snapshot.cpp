@@ -0,0 +1,213 @@
+#include "libs/catch.hpp"
+
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "utility/append_only_list.hpp"
+#include "Structures/memtable.h"
+#include "Structures/doclengthtable.h"
+#include "static_file.hpp"
+#include "query_processing/query_primitive_low.hpp"
+#include "static_functions/postingIO.hpp"
+
+TEST_CASE("Test append only list", "[snapshot]") {
+    Utility::AppendOnlyList<int> list;
+    REQUIRE(list.size() == 0);
+
+    for(int i = 0; i < 100; ++i)
+        list.push_back(i);
+    //Nothing is visible before publishing
+    REQUIRE(list.size() == 0);
+
+    list.publish();
+    REQUIRE(list.size() == 100);
+
+    int expected = 0;
+    for(auto iter = list.begin(); iter != list.end(list.size()); ++iter)
+        REQUIRE(*iter == expected++);
+    REQUIRE(expected == 100);
+}
+
+TEST_CASE("Test append only list with concurrent readers", "[snapshot]") {
+    Utility::AppendOnlyList<unsigned long> list;
+    std::atomic<bool> done(false);
+
+    //Every published element must be complete, and the published prefix may only grow
+    auto reader = [&list, &done](bool& ok) {
+        size_t lastsize = 0;
+        while(!done.load()) {
+            size_t size = list.size();
+            if(size < lastsize)
+                ok = false;
+            unsigned long expected = 0;
+            for(auto iter = list.begin(); iter != list.end(size); ++iter) {
+                if(*iter != expected * 3)
+                    ok = false;
+                expected++;
+            }
+            lastsize = size;
+        }
+    };
+
+    bool ok[2] = {true, true};
+    std::thread reader1(reader, std::ref(ok[0]));
+    std::thread reader2(reader, std::ref(ok[1]));
+    for(unsigned long i = 0; i < 50000; ++i) {
+        list.push_back(i * 3);
+        if(i % 7 == 0)
+            list.publish();
+    }
+    list.publish();
+    done.store(true);
+    reader1.join();
+    reader2.join();
+
+    REQUIRE(ok[0]);
+    REQUIRE(ok[1]);
+    REQUIRE(list.size() == 50000);
+}
+
+TEST_CASE("Test memtable", "[snapshot]") {
+    NonPosMemtable memtable;
+    memtable.insert(nPosting(2, 10, 1));
+    memtable.insert(nPosting(1, 5, 3));
+    memtable.insert(nPosting(2, 4, 2));
+    REQUIRE(memtable.find(3) == nullptr);
+    REQUIRE(memtable.find(2)->size() == 0);
+
+    memtable.publish();
+    REQUIRE(memtable.size() == 3);
+    REQUIRE(memtable.find(1)->size() == 1);
+    REQUIRE(memtable.find(2)->size() == 2);
+    //Out of order postings go to the side buffer
+    REQUIRE(memtable.find(2)->sortedSize() == 1);
+    REQUIRE(memtable.find(2)->sideSize() == 1);
+
+    //Lists are ordered by termID
+    REQUIRE(memtable.getLists().begin()->first == 1);
+
+    std::vector<nPosting> sorted = memtable.find(2)->toVector();
+    REQUIRE(sorted[0].docID == 4);
+    REQUIRE(sorted[1].docID == 10);
+
+    //A snapshot only reads as many postings as it saw when it was taken
+    QueryStats stats;
+    auto list = memtable.find(2);
+    size_t seensorted = list->sortedSize();
+    size_t seenside = list->sideSize();
+    memtable.insert(nPosting(2, 1, 9));
+    memtable.insert(nPosting(2, 12, 9));
+    memtable.publish();
+    query_primitive_low qpl(*list, seensorted, seenside, stats);
+    bool failure = false;
+    REQUIRE(qpl.nextGEQ(0, failure) == 4);
+    REQUIRE(qpl.getFreq() == 2);
+    REQUIRE(qpl.nextGEQ(5, failure) == 10);
+    REQUIRE(qpl.getFreq() == 1);
+    REQUIRE(qpl.nextGEQ(11, failure) == GlobalConst::UIntMax);
+    REQUIRE(failure);
+}
+
+TEST_CASE("Test memtable lists stay sorted", "[snapshot]") {
+    NonPosMemtable memtable;
+    std::vector<unsigned int> docIDs;
+    //Mostly increasing docIDs, with every fifth posting going back to an older document
+    for(unsigned int i = 0; i < 2000; ++i) {
+        unsigned int docID = (i % 5 == 4) ? i / 3 : i;
+        docIDs.push_back(docID);
+        memtable.insert(nPosting(1, docID, i));
+        memtable.publish();
+    }
+
+    //The side buffer is merged back into the sorted run once it grows large
+    auto list = memtable.find(1);
+    REQUIRE(list->size() == 2000);
+    REQUIRE(list->sideSize() <= MEMTABLE_SIDE_MIN + list->sortedSize() / MEMTABLE_SIDE_RATIO + 1);
+
+    std::stable_sort(docIDs.begin(), docIDs.end());
+    std::vector<nPosting> postings = list->toVector();
+    REQUIRE(postings.size() == docIDs.size());
+    for(size_t i = 0; i < postings.size(); ++i)
+        REQUIRE(postings[i].docID == docIDs[i]);
+
+    //Readers keep reading the list they found after it is replaced by a compacted one
+    size_t seensorted = list->sortedSize();
+    size_t seenside = list->sideSize();
+    size_t inserted = 0;
+    while(memtable.find(1) == list) {
+        memtable.insert(nPosting(1, 0, 0));
+        memtable.publish();
+        inserted++;
+    }
+    REQUIRE(list->size() == 2000 + inserted);
+    REQUIRE(memtable.find(1)->size() == 2000 + inserted);
+    REQUIRE(memtable.find(1)->sideSize() == 0);
+
+    QueryStats stats;
+    query_primitive_low qpl(*list, seensorted, seenside, stats);
+    bool failure = false;
+    unsigned int docID = 0;
+    size_t count = 0;
+    while(true) {
+        unsigned int next = qpl.nextGEQ(docID, failure);
+        if(failure)
+            break;
+        REQUIRE(next >= docID);
+        docID = next + 1;
+        count++;
+    }
+    std::vector<unsigned int> distinct = docIDs;
+    REQUIRE(count == (size_t)(std::unique(distinct.begin(), distinct.end()) - distinct.begin()));
+}
+
+TEST_CASE("Test document length table", "[snapshot]") {
+    DocLengthTable lengths;
+    REQUIRE(lengths.get(0) == -1);
+    REQUIRE(lengths.get(100000) == -1);
+
+    lengths.set(0, 0);
+    lengths.set(5000, 42);
+    REQUIRE(lengths.get(0) == 0);
+    REQUIRE(lengths.get(5000) == 42);
+    REQUIRE(lengths.get(4999) == -1);
+    REQUIRE(lengths.size() == 5001);
+}
+
+TEST_CASE("Test static file handle", "[snapshot]") {
+    const std::string dir = "./test_static_file";
+    const std::string path = dir + "/I3";
+    mkdir(dir.c_str(), S_IRWXU);
+
+    std::vector<nPosting> postinglist;
+    for(unsigned int i = 0; i < BLOCKSIZE + 5; ++i)
+        postinglist.emplace_back(7, i * 2, 1);
+    {
+        std::ofstream ofile(path, std::ios::out | std::ios::trunc);
+        write_postinglist(ofile, 7, postinglist, false);
+    }
+
+    std::map<unsigned int, unsigned long> sparselex = {{7, 0}};
+    auto file = std::make_shared<const StaticFileHandle>(path, 4, sparselex);
+    REQUIRE_FALSE(file->isZindex());
+    REQUIRE(file->getIndexNumber() == 3);
+    REQUIRE(file->getGeneration() == 4);
+    REQUIRE(file->getLEQOffset(6) == 0);
+    REQUIRE(file->getLEQOffset(9) == 0);
+    REQUIRE_THROWS(file->readBytes(16, file->getSize()));
+
+    //A merge deletes files that running queries may still be reading
+    std::remove(path.c_str());
+    rmdir(dir.c_str());
+
+    QueryStats stats;
+    query_primitive_low qpl(7, file, stats);
+    bool failure = false;
+    for(nPosting& p : postinglist)
+        REQUIRE(qpl.nextGEQ(p.docID, failure) == p.docID);
+    REQUIRE_THROWS_AS(query_primitive_low(8, file, stats), std::invalid_argument);
+}
\ No newline at end of file
@@ -1,6 +1,33 @@
 #include "libs/catch.hpp"
 
+#include <algorithm>
+
 #include "doc_analyzer/Matcher/stringencoder.h"
+#include "Structures/documentstore.h"
+#include "utility/util.hpp"
+#include "utility/tokenizer.hpp"
+
+TEST_CASE("Test tokenizer", "[stringencoder]") {
+    std::string text = "  \"Hello,\tWorld!\" -- it's\r\na...b\f(ok)\vX ";
+    std::vector<std::string> terms;
+    std::string_view term;
+    Utility::Tokenizer tokenizer(text);
+    while(tokenizer.next(term)) {
+        //Terms are views into the text
+        REQUIRE(term.data() >= text.data());
+        REQUIRE(term.data() + term.size() <= text.data() + text.size());
+        terms.emplace_back(term);
+    }
+    //Whitespace splits terms, but vertical tab does not
+    REQUIRE(terms == (std::vector<std::string>{"Hello", "World", "it's", "a...b", "ok)\vX"}));
+
+    std::string folded = "unused";
+    Utility::foldCase("MiXeD 123 \xC3\x84", folded);
+    REQUIRE(folded == "mixed 123 \xC3\x84");
+
+    Utility::Tokenizer empty("!? ... ");
+    REQUIRE(!empty.next(term));
+}
 
 TEST_CASE("Test stringencoder", "[stringencoder]") {
     StringEncoder se("a b c d", "c b a e");
@@ -24,31 +51,101 @@ TEST_CASE("Test stringencoder", "[stringencoder]") {
     REQUIRE(newwords[2] == "a");
     REQUIRE(newwords[3] == "e");
 
-    std::string s = "a";
-    REQUIRE(se.getNewCount(s) == 1);
-    s = "";
-    REQUIRE(se.getNewCount(s) == 0);
+    REQUIRE(se.getNewCount(se.getCode("a")) == 1);
+    REQUIRE(se.getCode("") == -1);
+    REQUIRE(se.getTerm(se.getCode("e")) == "e");
+    REQUIRE(se.getTermCount() == 5);
 
-    s = "e";
-    REQUIRE(se.inNew(s));
-    s = "d";
-    REQUIRE(!se.inNew(s));
-    s = "d";
-    REQUIRE(se.inOld(s));
-    s = "sdifjoaeariog reg r ";
-    REQUIRE(!se.inOld(s));
+    REQUIRE(se.inNew(se.getCode("e")));
+    REQUIRE(!se.inNew(se.getCode("d")));
+    REQUIRE(se.inOld(se.getCode("d")));
+    REQUIRE(se.getCode("sdifjoaeariog reg r ") == -1);
 
 
 
     se = StringEncoder("a b b c", "b b c d d");
 
-    s = "a";
-    REQUIRE(se.inOld(s));
-    REQUIRE(!se.inNew(s));
-    s = "d";
-    REQUIRE(!se.inOld(s));
-    REQUIRE(se.inNew(s));
-    s = "b";
-    REQUIRE(!se.inOld(s));
-    REQUIRE(!se.inNew(s));
+    REQUIRE(se.inOld(se.getCode("a")));
+    REQUIRE(!se.inNew(se.getCode("a")));
+    REQUIRE(!se.inOld(se.getCode("d")));
+    REQUIRE(se.inNew(se.getCode("d")));
+    REQUIRE(!se.inOld(se.getCode("b")));
+    REQUIRE(!se.inNew(se.getCode("b")));
+    REQUIRE(se.getNewCount(se.getCode("d")) == 2);
+}
+
+TEST_CASE("Test encoded documents", "[stringencoder]") {
+    std::string a = "The cat, the dog. And a bird!";
+    std::string b = "the dog and the cat ran";
+
+    EncodedDocument olddoc = StringEncoder("", a).getNewVersion(17);
+    REQUIRE(olddoc.hash == 17);
+    REQUIRE(olddoc.terms == (std::vector<std::string>{"the", "cat", "dog", "and", "a", "bird"}));
+    REQUIRE(olddoc.stream == (std::vector<int>{0, 1, 0, 2, 3, 4, 5}));
+
+    //Encoding against the stored version is the same as encoding both texts
+    StringEncoder text(a, b);
+    StringEncoder stored(olddoc, b);
+    REQUIRE(std::equal(text.getOldIter(), text.getOldEnd(), stored.getOldIter(), stored.getOldEnd()));
+    REQUIRE(std::equal(text.getNewIter(), text.getNewEnd(), stored.getNewIter(), stored.getNewEnd()));
+    for(std::string word : {"the", "cat", "dog", "and", "a", "bird", "ran"}) {
+        int code = text.getCode(word);
+        REQUIRE(stored.getCode(word) == code);
+        REQUIRE(stored.inOld(code) == text.inOld(code));
+        REQUIRE(stored.inNew(code) == text.inNew(code));
+        REQUIRE(stored.getNewCount(code) == text.getNewCount(code));
+    }
+
+    EncodedDocument newdoc = stored.getNewVersion(3);
+    REQUIRE(newdoc.terms == (std::vector<std::string>{"the", "dog", "and", "cat", "ran"}));
+    REQUIRE(newdoc.stream == (std::vector<int>{0, 1, 2, 0, 3, 4}));
+
+    //Stored in the document tuple, with codes that need more than one byte
+    for(int i = 0; i < 300; ++i) {
+        newdoc.terms.push_back("t" + std::to_string(i));
+        newdoc.stream.push_back(newdoc.terms.size() - 1);
+    }
+    newdoc.hash = Utility::hashString(b);
+    EncodedDocument restored = stringToEncoded(encodedToString(newdoc));
+    REQUIRE(restored.hash == newdoc.hash);
+    REQUIRE(restored.terms == newdoc.terms);
+    REQUIRE(restored.stream == newdoc.stream);
+
+    EncodedDocument empty = stringToEncoded(encodedToString(EncodedDocument()));
+    REQUIRE(empty.terms.empty());
+    REQUIRE(empty.stream.empty());
+    //Tagged, but cut short
+    std::string tagged = encodedToString(olddoc);
+    REQUIRE_THROWS_AS(stringToEncoded(tagged.substr(0, tagged.find('\n') + 1)), std::runtime_error);
+
+    //Codes past the terms are rejected rather than read out of bounds later
+    EncodedDocument missing;
+    missing.terms = {"the"};
+    missing.stream = {0, 1};
+    REQUIRE_THROWS_AS(stringToEncoded(encodedToString(missing)), std::runtime_error);
+}
+
+TEST_CASE("Test documents stored before encoding", "[stringencoder]") {
+    //Stores written by earlier builds hold the raw page, which is encoded as it is read
+    std::string a = "The cat, the dog. And a bird!";
+    EncodedDocument legacy = stringToEncoded(a);
+    EncodedDocument encoded = StringEncoder("", a).getNewVersion(Utility::hashString(a));
+    REQUIRE(legacy.hash == encoded.hash);
+    REQUIRE(legacy.terms == encoded.terms);
+    REQUIRE(legacy.stream == encoded.stream);
+
+    //Raw text that has the newlines of an encoded document
+    std::string b = "17\nthe cat\nran off\n";
+    EncodedDocument lines = stringToEncoded(b);
+    REQUIRE(lines.hash == Utility::hashString(b));
+    REQUIRE(lines.terms == (std::vector<std::string>{"17", "the", "cat", "ran", "off"}));
+
+    //The next crawl of the page is matched against the legacy version like against any encoded one
+    std::string c = "the dog and the cat ran";
+    StringEncoder text(a, c);
+    StringEncoder stored(legacy, c);
+    REQUIRE(std::equal(text.getOldIter(), text.getOldEnd(), stored.getOldIter(), stored.getOldEnd()));
+    REQUIRE(std::equal(text.getNewIter(), text.getNewEnd(), stored.getNewIter(), stored.getNewEnd()));
+
+    REQUIRE(stringToEncoded("").terms.empty());
 }
\ No newline at end of file
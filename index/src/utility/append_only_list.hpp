@@ -0,0 +1,155 @@
+#ifndef APPEND_ONLY_LIST_HPP
+#define APPEND_ONLY_LIST_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <algorithm>
+#include <iterator>
+
+namespace Utility
+{
+
+//List with a single writer that appends, and any number of readers that iterate concurrently.
+//Elements live in a chain of chunks that are never moved or freed while the list exists. Appended elements only
+//become visible to readers once the writer publishes them, so readers never see a partially written element.
+template <typename T>
+class AppendOnlyList {
+private:
+    static const size_t FIRST_CHUNK = 4;
+    static const size_t MAX_CHUNK = 4096;
+
+    struct Chunk {
+        Chunk(size_t c) : capacity(c), data(new T[c]), next(nullptr) {}
+        ~Chunk() { delete[] data; }
+
+        size_t capacity;
+        T* data;
+        std::atomic<Chunk*> next;
+    };
+
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T*;
+        using reference = const T&;
+
+        const_iterator(const Chunk* c, size_t i) : chunk(c), offset(0), index(i) {}
+
+        const T& operator*() const { return chunk->data[offset]; }
+        const T* operator->() const { return chunk->data + offset; }
+
+        const_iterator& operator++() {
+            ++index;
+            if(++offset == chunk->capacity) {
+                chunk = chunk->next.load(std::memory_order_relaxed);
+                offset = 0;
+            }
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        //Advances past the elements before end for which pred holds, where pred must hold for a prefix of them.
+        //Gallops forward from the current element and binary searches the last step, so both short and long skips
+        //are cheap. Returns how many elements were skipped
+        template <typename Pred>
+        size_t advanceWhile(Pred pred, const const_iterator& end) {
+            size_t skipped = 0;
+            while(index < end.index) {
+                size_t available = std::min(chunk->capacity - offset, end.index - index);
+                const T* first = chunk->data + offset;
+
+                //pred holds for the first known elements, and does not hold at probe (or probe is past the chunk)
+                size_t known = 0;
+                size_t probe = 0;
+                size_t step = 1;
+                while(probe < available && pred(first[probe])) {
+                    known = probe + 1;
+                    probe += step;
+                    step *= 2;
+                }
+                size_t n = std::partition_point(first + known, first + std::min(probe, available), pred) - first;
+
+                skipped += n;
+                index += n;
+                offset += n;
+                if(offset == chunk->capacity) {
+                    chunk = chunk->next.load(std::memory_order_relaxed);
+                    offset = 0;
+                }
+                if(n < available)
+                    break;
+            }
+            return skipped;
+        }
+
+        //Iterators are compared by position only, so an end iterator does not need a chunk
+        bool operator==(const const_iterator& rhs) const { return index == rhs.index; }
+        bool operator!=(const const_iterator& rhs) const { return index != rhs.index; }
+
+    private:
+        const Chunk* chunk;
+        size_t offset;
+        size_t index;
+    };
+
+    AppendOnlyList() : head(new Chunk(FIRST_CHUNK)), tail(head), tailused(0), count(0), published(0) {}
+
+    ~AppendOnlyList() {
+        while(head != nullptr) {
+            Chunk* next = head->next.load(std::memory_order_relaxed);
+            delete head;
+            head = next;
+        }
+    }
+
+    AppendOnlyList(const AppendOnlyList&) = delete;
+    AppendOnlyList& operator=(const AppendOnlyList&) = delete;
+
+    //Writer only. The element is not visible to readers until publish is called
+    void push_back(const T& value) {
+        if(tailused == tail->capacity) {
+            Chunk* chunk = new Chunk(std::min(tail->capacity * 2, MAX_CHUNK));
+            tail->next.store(chunk, std::memory_order_relaxed);
+            tail = chunk;
+            tailused = 0;
+        }
+        tail->data[tailused++] = value;
+        count++;
+    }
+
+    //Writer only. Makes every element appended so far visible to readers
+    void publish() {
+        published.store(count, std::memory_order_release);
+    }
+
+    //Number of elements visible to readers
+    size_t size() const {
+        return published.load(std::memory_order_acquire);
+    }
+
+    //Iterates over the first n elements, where n must not be larger than size()
+    const_iterator begin() const {
+        return const_iterator(head, 0);
+    }
+    const_iterator end(size_t n) const {
+        return const_iterator(nullptr, n);
+    }
+
+private:
+    Chunk* head;
+    Chunk* tail;
+    size_t tailused;
+    size_t count;
+    std::atomic<size_t> published;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef CHUNKED_ARRAY_HPP
+#define CHUNKED_ARRAY_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace Utility
+{
+
+//Array that grows in chunks which are never moved, so it can be read by other threads while one writer grows it.
+//Chunk k holds FIRST_CHUNK << k elements, so the chunk directory never needs to be reallocated.
+//Elements are value-initialized when their chunk is allocated.
+template <typename T, size_t FIRST_CHUNK = 1024>
+class ChunkedArray {
+public:
+    static const int MAX_CHUNKS = 32;
+
+    ChunkedArray() {
+        for(auto& chunk : chunks)
+            chunk.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~ChunkedArray() {
+        for(auto& chunk : chunks)
+            delete[] chunk.load(std::memory_order_relaxed);
+    }
+
+    ChunkedArray(const ChunkedArray&) = delete;
+    ChunkedArray& operator=(const ChunkedArray&) = delete;
+
+    //Writer only: returns the element at i, allocating its chunk if needed
+    T& grow(size_t i) {
+        int chunk;
+        size_t offset;
+        locate(i, chunk, offset);
+
+        T* data = chunks[chunk].load(std::memory_order_relaxed);
+        if(data == nullptr) {
+            data = new T[FIRST_CHUNK << chunk]();
+            chunks[chunk].store(data, std::memory_order_release);
+        }
+        return data[offset];
+    }
+
+    //Returns the element at i, or nullptr if its chunk has not been allocated yet
+    T* find(size_t i) const {
+        int chunk;
+        size_t offset;
+        locate(i, chunk, offset);
+
+        T* data = chunks[chunk].load(std::memory_order_acquire);
+        return data == nullptr ? nullptr : data + offset;
+    }
+
+private:
+    static void locate(size_t i, int& chunk, size_t& offset) {
+        size_t v = i / FIRST_CHUNK + 1;
+        chunk = 63 - __builtin_clzll(v);
+        offset = i - FIRST_CHUNK * ((size_t(1) << chunk) - 1);
+    }
+
+    std::atomic<T*> chunks[MAX_CHUNKS];
+};
+
+}
+
+#endif
\ No newline at end of file
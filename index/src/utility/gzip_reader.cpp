@@ -0,0 +1,126 @@
+#include "gzip_reader.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace Utility
+{
+
+GzipReader::GzipReader(const std::string& path, size_t chunksize, size_t maxchunks) : file(path), chunksize(chunksize),
+    maxchunks(maxchunks), finished(false), stopping(false), worker(&GzipReader::decompress, this) {}
+
+GzipReader::~GzipReader() {
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+    }
+    notfull.notify_all();
+    worker.join();
+}
+
+bool GzipReader::read(std::string& buffer) {
+    std::string chunk;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        notempty.wait(lock, [this] { return finished || !chunks.empty(); });
+        if(chunks.empty()) {
+            if(!error.empty())
+                throw std::runtime_error("Error decompressing " + file.getPath() + ": " + error);
+            return false;
+        }
+        chunk = std::move(chunks.front());
+        chunks.pop_front();
+    }
+    notfull.notify_one();
+
+    buffer.append(chunk);
+    return true;
+}
+
+const std::string& GzipReader::getPath() const {
+    return file.getPath();
+}
+
+bool GzipReader::push(std::string& chunk) {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        notfull.wait(lock, [this] { return stopping || chunks.size() < maxchunks; });
+        if(stopping)
+            return false;
+        chunks.push_back(std::move(chunk));
+    }
+    notempty.notify_one();
+    return true;
+}
+
+void GzipReader::decompress() {
+    std::string_view input = file.getContents();
+    size_t consumed = 0;
+    std::string failure;
+
+    z_stream stream{};
+    //15 + 16 selects the largest window with a gzip wrapper
+    if(inflateInit2(&stream, 15 + 16) != Z_OK)
+        failure = "could not initialize zlib";
+
+    std::string chunk(chunksize, '\0');
+    size_t filled = 0;
+    //Whether the input stopped partway through a member
+    bool inmember = false;
+    while(failure.empty()) {
+        //zlib takes at most 4GB of input at a time
+        if(stream.avail_in == 0 && consumed < input.size()) {
+            size_t piece = std::min<size_t>(input.size() - consumed, std::numeric_limits<uInt>::max());
+            stream.next_in = (Bytef*)(input.data() + consumed);
+            stream.avail_in = piece;
+            consumed += piece;
+        }
+        if(stream.avail_in == 0) {
+            if(inmember)
+                failure = "file is truncated";
+            break;
+        }
+
+        stream.next_out = (Bytef*)&chunk[filled];
+        stream.avail_out = chunksize - filled;
+        int status = inflate(&stream, Z_NO_FLUSH);
+        filled = chunksize - stream.avail_out;
+
+        if(status == Z_STREAM_END) {
+            //Another member may follow, which continues the same stream
+            inflateReset(&stream);
+            inmember = false;
+        }
+        else if(status == Z_OK) {
+            inmember = true;
+        }
+        else {
+            failure = stream.msg ? stream.msg : "invalid gzip data";
+            break;
+        }
+
+        if(filled == chunksize) {
+            if(!push(chunk))
+                break;
+            chunk.assign(chunksize, '\0');
+            filled = 0;
+        }
+    }
+    inflateEnd(&stream);
+
+    if(failure.empty() && filled > 0) {
+        chunk.resize(filled);
+        push(chunk);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        error = failure;
+        finished = true;
+    }
+    notempty.notify_all();
+}
+
+}
\ No newline at end of file
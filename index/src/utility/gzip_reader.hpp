@@ -0,0 +1,61 @@
+#ifndef GZIP_READER_HPP
+#define GZIP_READER_HPP
+
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "global_parameters.hpp"
+#include "mapped_file.hpp"
+
+namespace Utility
+{
+
+/**
+ * Decompresses a gzip file on a background thread, which starts as soon as the reader is constructed.
+ * Files made of several gzip members, like Common Crawl's, are read as one stream. Decompressed data is handed
+ * over in chunks through a bounded queue, so the thread stays at most maxchunks chunks ahead of the reader.
+ */
+class GzipReader {
+public:
+    //Throws std::runtime_error if the file cannot be opened
+    explicit GzipReader(const std::string& path, size_t chunksize = GZIP_CHUNK_SIZE, size_t maxchunks = GZIP_QUEUE_CHUNKS);
+    ~GzipReader();
+
+    GzipReader(const GzipReader&) = delete;
+    GzipReader& operator=(const GzipReader&) = delete;
+
+    //Appends the next chunk of decompressed data to buffer, waiting for it if needed.
+    //Returns false once the whole file has been read. Throws std::runtime_error if the file is not valid gzip
+    bool read(std::string& buffer);
+
+    const std::string& getPath() const;
+
+private:
+    //Runs on the worker thread
+    void decompress();
+    //Waits for space in the queue, then adds chunk to it. Returns false if the reader is being destroyed
+    bool push(std::string& chunk);
+
+    MappedFile file;
+    size_t chunksize;
+    size_t maxchunks;
+
+    std::mutex mtx;
+    std::condition_variable notfull;
+    std::condition_variable notempty;
+    std::deque<std::string> chunks;
+    //Set by the worker once it has queued every chunk, or failed
+    bool finished;
+    //Set by the destructor, to stop the worker early
+    bool stopping;
+    std::string error;
+
+    std::thread worker;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef LRU_CACHE_HPP
+#define LRU_CACHE_HPP
+
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <utility>
+
+namespace Utility
+{
+
+//Map that holds entries weighing at most capacity in total, evicting the least recently used entries when full
+//Every entry weighs 1 unless a weigh function is given, such as the bytes used by the value
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class LRUCache {
+public:
+    LRUCache(size_t capacity) : capacity(capacity), weigh([](const Value&) { return (size_t)1; }), weight(0) {}
+    LRUCache(size_t capacity, std::function<size_t(const Value&)> weigh)
+        : capacity(capacity), weigh(std::move(weigh)), weight(0) {}
+
+    //Returns a pointer to the cached value and marks it as most recently used, or nullptr if key is not cached
+    //The pointer is invalidated by the next put, erase or clear. Changing the value through it keeps its old weight
+    Value* get(const Key& key) {
+        auto iter = lookup.find(key);
+        if(iter == lookup.end())
+            return nullptr;
+
+        entries.splice(entries.begin(), entries, iter->second);
+        return &iter->second->value;
+    }
+
+    //A value heavier than the whole cache is not cached, and replaces nothing
+    void put(const Key& key, Value value) {
+        size_t valueweight = weigh(value);
+        if(valueweight > capacity) {
+            erase(key);
+            return;
+        }
+
+        auto iter = lookup.find(key);
+        if(iter != lookup.end()) {
+            weight -= iter->second->weight;
+            entries.erase(iter->second);
+            lookup.erase(iter);
+        }
+
+        while(weight + valueweight > capacity) {
+            weight -= entries.back().weight;
+            lookup.erase(entries.back().key);
+            entries.pop_back();
+        }
+        entries.push_front(Entry{key, std::move(value), valueweight});
+        lookup[key] = entries.begin();
+        weight += valueweight;
+    }
+
+    void erase(const Key& key) {
+        auto iter = lookup.find(key);
+        if(iter == lookup.end())
+            return;
+
+        weight -= iter->second->weight;
+        entries.erase(iter->second);
+        lookup.erase(iter);
+    }
+
+    void clear() {
+        entries.clear();
+        lookup.clear();
+        weight = 0;
+    }
+
+    size_t size() const {
+        return entries.size();
+    }
+
+    //Total weight of the cached entries
+    size_t getWeight() const {
+        return weight;
+    }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t weight;
+    };
+
+    size_t capacity;
+    std::function<size_t(const Value&)> weigh;
+    size_t weight;
+    //Most recently used entries are at the front
+    std::list<Entry> entries;
+    std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> lookup;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,59 @@
+#include "mapped_file.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace Utility
+{
+
+MappedFile::MappedFile(const std::string& path) : path(path), data(nullptr), size(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw std::runtime_error("Error: could not open " + path + ": " + std::strerror(errno));
+
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("Error: could not stat " + path);
+    }
+    size = st.st_size;
+
+    //Empty files cannot be mapped, and have nothing to read anyway
+    if(size > 0) {
+        void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(mapping == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Error: could not map " + path + ": " + std::strerror(errno));
+        }
+        data = static_cast<char*>(mapping);
+        //Files are scanned front to back, so the kernel can read further ahead and drop pages behind
+        madvise(data, size, MADV_SEQUENTIAL);
+    }
+    //The mapping keeps the file open
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if(data)
+        munmap(data, size);
+}
+
+std::string_view MappedFile::getContents() const {
+    return std::string_view(data, size);
+}
+
+const std::string& MappedFile::getPath() const {
+    return path;
+}
+
+void MappedFile::prefetch() const {
+    if(data)
+        madvise(data, size, MADV_WILLNEED);
+}
+
+}
\ No newline at end of file
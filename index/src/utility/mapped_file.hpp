@@ -0,0 +1,39 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <string>
+#include <string_view>
+
+namespace Utility
+{
+
+/**
+ * Read-only memory mapping of a whole file. Its contents are read by the kernel as they are touched, so a file
+ * can be scanned without copying it into a buffer first. Views into the contents are valid for the lifetime of the
+ * mapping.
+ */
+class MappedFile {
+public:
+    //Throws std::runtime_error if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view getContents() const;
+    const std::string& getPath() const;
+
+    //Asks the kernel to start reading the whole file in the background, so it is in the page cache by the time
+    //it is scanned. Does not block
+    void prefetch() const;
+
+private:
+    std::string path;
+    char* data;
+    size_t size;
+};
+
+}
+
+#endif
\ No newline at end of file
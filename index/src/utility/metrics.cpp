@@ -0,0 +1,269 @@
+#include "metrics.hpp"
+
+#include <fstream>
+#include <iostream>
+
+namespace Metrics {
+
+void Counter::add(unsigned long long n) {
+    value.fetch_add(n, std::memory_order_relaxed);
+}
+
+unsigned long long Counter::get() const {
+    return value.load(std::memory_order_relaxed);
+}
+
+void Counter::reset() {
+    value.store(0, std::memory_order_relaxed);
+}
+
+void Gauge::set(long long n) {
+    value.store(n, std::memory_order_relaxed);
+}
+
+void Gauge::add(long long n) {
+    value.fetch_add(n, std::memory_order_relaxed);
+}
+
+long long Gauge::get() const {
+    return value.load(std::memory_order_relaxed);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int Histogram::bucketIndex(unsigned long long value) {
+    if(value < (unsigned long long)SUB_BUCKETS)
+        return value;
+
+    int msb = 63 - __builtin_clzll(value);
+    int group = msb - SUB_BUCKET_BITS + 1;
+    int sub = (value >> (msb - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return group * SUB_BUCKETS + sub;
+}
+
+unsigned long long Histogram::bucketUpperBound(int index) {
+    if(index < SUB_BUCKETS)
+        return index;
+
+    int group = index / SUB_BUCKETS;
+    int sub = index % SUB_BUCKETS;
+    int shift = group - 1;
+    unsigned long long lower = (unsigned long long)(SUB_BUCKETS + sub) << shift;
+    return lower + ((1ULL << shift) - 1);
+}
+
+void Histogram::record(unsigned long long value) {
+    buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(1, std::memory_order_relaxed);
+    valuesum.fetch_add(value, std::memory_order_relaxed);
+
+    unsigned long long oldmax = maxvalue.load(std::memory_order_relaxed);
+    while(value > oldmax && !maxvalue.compare_exchange_weak(oldmax, value, std::memory_order_relaxed))
+        ;
+}
+
+unsigned long long Histogram::count() const {
+    return total.load(std::memory_order_relaxed);
+}
+
+unsigned long long Histogram::sum() const {
+    return valuesum.load(std::memory_order_relaxed);
+}
+
+unsigned long long Histogram::max() const {
+    return maxvalue.load(std::memory_order_relaxed);
+}
+
+unsigned long long Histogram::percentile(double p) const {
+    unsigned long long n = count();
+    if(n == 0)
+        return 0;
+
+    unsigned long long target = (unsigned long long)(p / 100.0 * n);
+    if(target == 0)
+        target = 1;
+
+    unsigned long long seen = 0;
+    for(int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if(seen >= target)
+            return std::min(bucketUpperBound(i), max());
+    }
+    return max();
+}
+
+void Histogram::reset() {
+    for(auto& bucket : buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    total.store(0, std::memory_order_relaxed);
+    valuesum.store(0, std::memory_order_relaxed);
+    maxvalue.store(0, std::memory_order_relaxed);
+}
+
+nlohmann::json Histogram::toJson() const {
+    unsigned long long n = count();
+    return nlohmann::json::object({
+        {"count", n},
+        {"mean", n == 0 ? 0.0 : sum() / (double)n},
+        {"p50", percentile(50)},
+        {"p90", percentile(90)},
+        {"p99", percentile(99)},
+        {"p999", percentile(99.9)},
+        {"max", max()},
+    });
+}
+
+ScopedTimer::ScopedTimer(Histogram& h) : histogram(h), begin(std::chrono::steady_clock::now()) {}
+
+ScopedTimer::~ScopedTimer() {
+    histogram.record(elapsed());
+}
+
+long long ScopedTimer::elapsed() const {
+    return nanosSince(begin);
+}
+
+long long nanosSince(std::chrono::steady_clock::time_point begin) {
+    auto dur = std::chrono::steady_clock::now() - begin;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(dur).count();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+//Metrics are never removed from the registry, so references handed out stay valid for the whole program
+struct Registry {
+    std::mutex lock;
+    std::map<std::string, std::unique_ptr<Counter>> counters;
+    std::map<std::string, std::unique_ptr<Gauge>> gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+};
+
+Registry& getRegistry() {
+    static Registry registry;
+    return registry;
+}
+
+template <typename T>
+T& getOrCreate(std::map<std::string, std::unique_ptr<T>>& metrics, const std::string& name) {
+    std::lock_guard<std::mutex> guard(getRegistry().lock);
+    auto iter = metrics.find(name);
+    if(iter == metrics.end())
+        iter = metrics.emplace(name, std::unique_ptr<T>(new T())).first;
+    return *iter->second;
+}
+
+struct PeriodicDumper {
+    std::mutex lock;
+    std::condition_variable wakeup;
+    std::thread worker;
+    bool stopping = false;
+
+    ~PeriodicDumper() {
+        stop();
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        if(worker.joinable())
+            worker.join();
+        stopping = false;
+    }
+};
+
+PeriodicDumper& getDumper() {
+    //The registry must outlive the dumper, which writes one last dump when it is destroyed
+    getRegistry();
+    static PeriodicDumper dumper;
+    return dumper;
+}
+
+void writeJson(const std::string& path) {
+    std::string jstring = toJson().dump(4);
+    std::ofstream ofile(path, std::ios::out | std::ios::trunc);
+    ofile.write(jstring.c_str(), jstring.size());
+}
+
+}
+
+Counter& counter(const std::string& name) {
+    return getOrCreate(getRegistry().counters, name);
+}
+
+Gauge& gauge(const std::string& name) {
+    return getOrCreate(getRegistry().gauges, name);
+}
+
+Histogram& histogram(const std::string& name) {
+    return getOrCreate(getRegistry().histograms, name);
+}
+
+nlohmann::json toJson() {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    nlohmann::json jobject;
+    jobject["counters"] = nlohmann::json::object();
+    jobject["gauges"] = nlohmann::json::object();
+    jobject["histograms"] = nlohmann::json::object();
+
+    for(auto& entry : registry.counters)
+        jobject["counters"][entry.first] = entry.second->get();
+    for(auto& entry : registry.gauges)
+        jobject["gauges"][entry.first] = entry.second->get();
+    for(auto& entry : registry.histograms)
+        jobject["histograms"][entry.first] = entry.second->toJson();
+
+    return jobject;
+}
+
+void print(std::ostream& os) {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    for(auto& entry : registry.counters)
+        os << entry.first << ": " << entry.second->get() << std::endl;
+    for(auto& entry : registry.gauges)
+        os << entry.first << ": " << entry.second->get() << std::endl;
+    for(auto& entry : registry.histograms) {
+        Histogram& h = *entry.second;
+        os << entry.first << ": count=" << h.count() << " mean=" << (h.count() == 0 ? 0 : h.sum() / h.count())
+            << " p50=" << h.percentile(50) << " p99=" << h.percentile(99) << " max=" << h.max() << std::endl;
+    }
+}
+
+void reset() {
+    Registry& registry = getRegistry();
+    std::lock_guard<std::mutex> guard(registry.lock);
+
+    for(auto& entry : registry.counters)
+        entry.second->reset();
+    for(auto& entry : registry.gauges)
+        entry.second->set(0);
+    for(auto& entry : registry.histograms)
+        entry.second->reset();
+}
+
+void startPeriodicDump(const std::string& path, unsigned int interval) {
+    PeriodicDumper& dumper = getDumper();
+    dumper.stop();
+
+    dumper.worker = std::thread([path, interval, &dumper]() {
+        std::unique_lock<std::mutex> guard(dumper.lock);
+        while(!dumper.stopping) {
+            dumper.wakeup.wait_for(guard, std::chrono::seconds(interval), [&dumper]() { return dumper.stopping; });
+            writeJson(path);
+        }
+    });
+}
+
+void stopPeriodicDump() {
+    getDumper().stop();
+}
+
+}
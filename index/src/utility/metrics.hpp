@@ -0,0 +1,111 @@
+#ifndef METRICS_HPP
+#define METRICS_HPP
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <condition_variable>
+
+#include "libs/json.hpp"
+
+/**
+ * In-process metrics: counters, gauges and HDR-style histograms, all registered by name in a global registry.
+ * Metrics are created on first use and never destroyed, so hot paths can hold on to a reference:
+ *     static Metrics::Counter& inserted = Metrics::counter("index.postings_inserted");
+ * Every update is a relaxed atomic operation, so metrics can be updated from any thread.
+ */
+namespace Metrics {
+
+class Counter {
+public:
+    void add(unsigned long long n = 1);
+    unsigned long long get() const;
+    void reset();
+
+private:
+    std::atomic<unsigned long long> value{0};
+};
+
+class Gauge {
+public:
+    void set(long long n);
+    void add(long long n);
+    long long get() const;
+
+private:
+    std::atomic<long long> value{0};
+};
+
+//Histogram with log-linear buckets, in the style of HdrHistogram.
+//Values are grouped by their highest set bit, and each group is split into SUB_BUCKETS linear buckets,
+//so every recorded value is kept with a relative error below 1/SUB_BUCKETS.
+class Histogram {
+public:
+    static const int SUB_BUCKET_BITS = 5;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void record(unsigned long long value);
+
+    unsigned long long count() const;
+    unsigned long long sum() const;
+    unsigned long long max() const;
+    //Returns an upper bound of the value at the given percentile (0-100)
+    unsigned long long percentile(double p) const;
+    void reset();
+
+    nlohmann::json toJson() const;
+
+private:
+    static int bucketIndex(unsigned long long value);
+    //Largest value that falls into the given bucket
+    static unsigned long long bucketUpperBound(int index);
+
+    std::array<std::atomic<unsigned long long>, BUCKET_COUNT> buckets{};
+    std::atomic<unsigned long long> total{0};
+    std::atomic<unsigned long long> valuesum{0};
+    std::atomic<unsigned long long> maxvalue{0};
+};
+
+//Records the time between construction and destruction (in nanoseconds) into a histogram
+class ScopedTimer {
+public:
+    ScopedTimer(Histogram& h);
+    ~ScopedTimer();
+
+    //Nanoseconds since the timer was created
+    long long elapsed() const;
+
+private:
+    Histogram& histogram;
+    std::chrono::steady_clock::time_point begin;
+};
+
+//Nanoseconds elapsed since begin
+long long nanosSince(std::chrono::steady_clock::time_point begin);
+
+//Gets or creates the metric with the given name
+Counter& counter(const std::string& name);
+Gauge& gauge(const std::string& name);
+Histogram& histogram(const std::string& name);
+
+//Dumps every registered metric into a json object, grouped by type
+nlohmann::json toJson();
+//Writes a human-readable listing of every metric
+void print(std::ostream& os);
+//Clears the values of every metric. Metrics stay registered
+void reset();
+
+//Writes toJson() to path every interval seconds on a background thread, replacing the file each time.
+//Calling it again replaces the previous dump target
+void startPeriodicDump(const std::string& path, unsigned int interval);
+void stopPeriodicDump();
+
+}
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utility
+{
+
+//Calls fn(i) for every i below count, spread over one thread per core. The calling thread is one of them
+//Each thread takes the next index until none are left, so uneven work is balanced. If any call throws, the
+//remaining indexes are still run and the first exception is rethrown once every thread is done
+template <typename F>
+void parallelFor(size_t count, F fn) {
+    std::atomic<size_t> next(0);
+    std::mutex failurelock;
+    std::exception_ptr failure;
+    auto work = [&]() {
+        for(size_t i = next++; i < count; i = next++) {
+            try {
+                fn(i);
+            }
+            catch(...) {
+                std::lock_guard<std::mutex> guard(failurelock);
+                if(!failure)
+                    failure = std::current_exception();
+            }
+        }
+    };
+
+    size_t threadcount = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for(size_t i = 1; i < threadcount; ++i)
+        threads.emplace_back(work);
+    work();
+    for(std::thread& t : threads)
+        t.join();
+    if(failure)
+        std::rethrow_exception(failure);
+}
+
+}
+
+#endif
\ No newline at end of file
@@ -3,26 +3,30 @@
 namespace Utility
 {
 
-Timer::Timer() : totalms(0) {}
+Timer::Timer() : totalns(0) {}
 
 void Timer::start() {
-    startedtime = std::chrono::high_resolution_clock::now();
+    startedtime = std::chrono::steady_clock::now();
 }
 
 void Timer::stop() {
-    auto endtime = std::chrono::high_resolution_clock::now();
+    auto endtime = std::chrono::steady_clock::now();
     auto dur = endtime - startedtime;
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(dur).count();
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(dur).count();
 
-    totalms += ms;
+    totalns += ns;
 }
 
 void Timer::reset() {
-    totalms = 0;
+    totalns = 0;
 }
 
 long Timer::getCumulative() {
-    return totalms;
+    return totalns / 1000000;
+}
+
+long long Timer::getCumulativeNanos() {
+    return totalns;
 }
 
 }
\ No newline at end of file
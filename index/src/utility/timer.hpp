@@ -14,11 +14,14 @@ public:
     void stop();
     void reset();
 
+    //Cumulative time in milliseconds
     long getCumulative();
+    //Cumulative time in nanoseconds
+    long long getCumulativeNanos();
 
 private:
-    long totalms;
-    std::chrono::time_point<std::chrono::high_resolution_clock> startedtime;
+    long long totalns;
+    std::chrono::time_point<std::chrono::steady_clock> startedtime;
 };
 
 }
@@ -0,0 +1,69 @@
+#include "tokenizer.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace Utility
+{
+
+namespace {
+
+enum CharClass : uint8_t { OTHER = 0, SPACE = 1, PUNCT = 2 };
+
+//Same classes as the old splitString delimiters and ispunct
+constexpr std::array<uint8_t, 256> makeClasses() {
+    std::array<uint8_t, 256> classes{};
+    for(char c : {' ', '\n', '\t', '\r', '\f'})
+        classes[(unsigned char)c] = SPACE;
+    for(int c = '!'; c <= '~'; ++c) {
+        bool alnum = (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        if(!alnum)
+            classes[c] = PUNCT;
+    }
+    return classes;
+}
+
+constexpr std::array<char, 256> makeLower() {
+    std::array<char, 256> lower{};
+    for(int c = 0; c < 256; ++c)
+        lower[c] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+    return lower;
+}
+
+constexpr std::array<uint8_t, 256> CLASSES = makeClasses();
+constexpr std::array<char, 256> LOWER = makeLower();
+
+inline uint8_t classOf(char c) {
+    return CLASSES[(unsigned char)c];
+}
+
+}
+
+Tokenizer::Tokenizer(std::string_view text) : pos(text.data()), end(text.data() + text.size()) {}
+
+bool Tokenizer::next(std::string_view& term) {
+    //Skip whitespace and leading punctuation, which also skips terms made only of punctuation
+    while(pos != end && classOf(*pos) != OTHER)
+        ++pos;
+    if(pos == end)
+        return false;
+
+    const char* begin = pos;
+    const char* last = pos;
+    //A term ends at whitespace. Its trailing punctuation is dropped
+    while(pos != end && classOf(*pos) != SPACE) {
+        if(classOf(*pos) == OTHER)
+            last = pos;
+        ++pos;
+    }
+    term = std::string_view(begin, last - begin + 1);
+    return true;
+}
+
+void foldCase(std::string_view term, std::string& folded) {
+    folded.resize(term.size());
+    for(size_t i = 0; i < term.size(); ++i)
+        folded[i] = LOWER[(unsigned char)term[i]];
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef TOKENIZER_HPP
+#define TOKENIZER_HPP
+
+#include <string>
+#include <string_view>
+
+namespace Utility
+{
+
+//Splits text into terms in a single pass, without copying it.
+//Terms are separated by whitespace, and lose their leading and trailing punctuation. Terms made only of
+//punctuation are skipped. Characters are classified with a table, as ASCII in the C locale.
+//The returned views point into the text, so they are only valid as long as it is.
+class Tokenizer {
+public:
+    explicit Tokenizer(std::string_view text);
+
+    //Sets term to the next term. Returns false once there are no terms left
+    bool next(std::string_view& term);
+
+private:
+    const char* pos;
+    const char* end;
+};
+
+//Writes the ASCII lowercase form of term into folded, reusing its memory
+void foldCase(std::string_view term, std::string& folded);
+
+}
+
+#endif
\ No newline at end of file
@@ -28,6 +28,15 @@ unsigned int hashVector(const std::vector<int>& v) {
     return hc;
 }
 
+uint64_t hashString(std::string_view s) {
+    uint64_t hc = 14695981039346656037ULL;
+    for(unsigned char c : s) {
+        hc ^= c;
+        hc *= 1099511628211ULL;
+    }
+    return hc;
+}
+
 //Gets all files inside the given directory
 //Returns a vector of *only* the file names
 //http://forum.codecall.net/topic/60157-read-all-files-in-a-folder/
@@ -3,6 +3,8 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <cstdint>
 
 namespace Utility {
 
@@ -12,6 +14,8 @@ namespace Utility {
     //Hashes a vector of ints
     //Not guaranteed to be optimal
     unsigned int hashVector(const std::vector<int>& v);
+    //64 bit FNV-1a hash of a string. Unlike std::hash, it is the same in every build, so it can be stored
+    uint64_t hashString(std::string_view s);
 
     //Gets a list of files in a given directory
     std::vector<std::string> readDirectory(std::string path);